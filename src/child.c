@@ -44,16 +44,41 @@ char **sargv = NULL;
 struct nhead netifs;
 struct ehead exclifs;
 struct mhead mqueue;
+struct shead watchers = TAILQ_HEAD_INITIALIZER(watchers);
 struct my_sysinfo sysinfo;
 extern struct proto protos[];
+extern uint32_t netif_gens;
+
+// netif frames are indexed by protocol
+my_ctassert(NETIF_FRAMES >= PROTO_MAX);
+
+// triggered lldp transmits, see child_tx_run
+int tx_fd = -1;
+static struct event tx_event;
+static uint8_t tx_pending = 0;
+static uint8_t tx_local = 0;
+
+// neighbor snapshot, kept open across the chroot
+int state_fd = -1;
+static uint32_t state_gen = 0;
+
+// netlink interface tracking
+static uint8_t link_events = 0;
+static uint8_t link_rescan = 1;
+#ifdef HAVE_NETIF_EVENTS
+#define LINK_DUMP_RUNNING   (1 << 0)
+#define LINK_DUMP_WANTED    (1 << 1)
+static uint8_t link_dump = 0;
+#endif
 
 void child_init(int reqfd, int msgfd, int ifc, char *ifl[],
 		struct passwd *pwd) {
 
     // events
     struct child_send_args args = { .index = NETIF_INDEX_MAX };
-    struct event evq, eva, evl;
-    struct event ev_sigterm, ev_sigint;
+    struct child_link_args largs = {};
+    struct event evq, eva, evl, evs;
+    struct event ev_sigterm, ev_sigint, ev_sighup;
 
     // parent socket
     extern int msock;
@@ -65,8 +90,8 @@ void child_init(int reqfd, int msgfd, int ifc, char *ifl[],
     sargv = ifl;
 
     // init the queues
-    TAILQ_INIT(&netifs);
-    TAILQ_INIT(&mqueue);
+    netif_list_init(&netifs);
+    mqueue_init(&mqueue);
 
     // configure command socket
     msock = reqfd;
@@ -104,6 +129,16 @@ void child_init(int reqfd, int msgfd, int ifc, char *ifl[],
 	umask(old_umask);
     }
 
+    // open the neighbor snapshot, the chroot isn't writable after dropping
+    if ((options & OPT_RECV) && !(options & (OPT_DEBUG|OPT_ONCE))) {
+	state_fd = open(PACKAGE_STATE_FILE, O_RDWR|O_CREAT|O_NOFOLLOW,
+			S_IRUSR|S_IWUSR);
+	if (state_fd == -1)
+	    my_loge(WARN, "failed to open " PACKAGE_STATE_FILE);
+	else
+	    fcntl(state_fd, F_SETFD, FD_CLOEXEC);
+    }
+
     // initalize the events and netifs
     event_init();
     netif_init();
@@ -121,6 +156,13 @@ void child_init(int reqfd, int msgfd, int ifc, char *ifl[],
     // startup message
     my_log(CRIT, PACKAGE_STRING " running");
 
+    // transmit phases differ between hosts and restarts
+    srandom(time(NULL) ^ getpid());
+
+    // fast transmits are only armed after the first run
+    if (!(options & OPT_ONCE))
+	tx_fd = msgfd;
+
     // create and run the transmit event
     event_set(&args.event, msgfd, 0, (void *)child_send, &args);
     child_send(msgfd, EV_TIMEOUT, &args);
@@ -144,15 +186,29 @@ void child_init(int reqfd, int msgfd, int ifc, char *ifl[],
 			(void *)child_cli_accept, NULL);
 	    event_add(&eva, NULL);
 	}
+
+	// restore neighbors which haven't expired yet, then save regularly
+	if (state_fd != -1) {
+	    child_load(state_fd);
+	    evtimer_set(&evs, (void *)child_save, &evs);
+	    child_save(state_fd, EV_TIMEOUT, &evs);
+	}
     }
 
     // create link fd
     if ((lsock = child_link_fd()) != -1) {
-	event_set(&evl, lsock, EV_READ|EV_PERSIST,
-		child_link, (void *)&msgfd);
+	event_set(&evl, lsock, EV_READ|EV_PERSIST, child_link, &largs);
 	event_add(&evl, NULL);
+	// coalesce bursts of link events
+	event_set(&largs.event, msgfd, 0, child_link_flush, &largs);
+	// catch changes made before the subscription
+	link_rescan = 1;
     }
 
+    // rescan all interfaces on request
+    signal_set(&ev_sighup, SIGHUP, child_rescan, &args);
+    signal_add(&ev_sighup, NULL);
+
     // wait for events
     event_dispatch();
 
@@ -160,126 +216,78 @@ void child_init(int reqfd, int msgfd, int ifc, char *ifl[],
     my_fatal("child event-loop failed");
 }
 
+// packets waiting to be handed to the parent
+static struct parent_msg smsgs[PARENT_MSG_BATCH];
+
+// frame cache statistics, see child_send_subif
+uint32_t frame_hits = 0, frame_builds = 0;
+static uint32_t frame_gen = 0;
+
 void child_send(int fd, short event, struct child_send_args *args) {
-    struct parent_msg msg;
-    struct netif *netif = NULL, *subif = NULL, *linkif = NULL;
-    ssize_t len;
+    struct netif *netif = NULL, *subif = NULL;
+    struct child_wheel *wheel = NULL;
+    int count = 0;
 
-    // bail early on known flapping interfaces
+    // handle a given ifindex
     if (args->index != NETIF_INDEX_MAX) {
-	linkif = netif_byindex(&netifs, args->index);
-	if (linkif && (linkif->link_event > 3))
-	    goto out;
+	child_send_links(fd, &args->index, 1);
+	goto out;
     }
 
-    // update netifs
-    my_log(INFO, "fetching all interfaces"); 
-
     // no configured ethernet interfaces found
-    if (netif_fetch(sargc, sargv, &sysinfo, &netifs) == 0)
+    if (child_send_fetch() == 0)
 	goto out;
 
-    // no interface matching the given ifindex found
-    if (args->index != NETIF_INDEX_MAX) {
-	if ((linkif = netif_byindex(&netifs, args->index)) == NULL)
-	    goto out;
+    // ask the parent about all interfaces at once
+    while ((netif = netif_iter(netif, &netifs)) != NULL) {
+	if (child_send_skip(netif))
+	    continue;
+	while ((subif = subif_iter(subif, netif)) != NULL) {
+	    if (!child_send_skip(subif))
+		netif_media_prefetch(subif);
+	}
+    }
+    my_mreq_flush();
+
+    // spread the periodic frames over the interval,
+    // single runs and link events send everything right away
+    if ((event == EV_TIMEOUT) && !(options & OPT_ONCE)) {
+	wheel = &args->wheel;
+	child_wheel_drain(fd, wheel);
+	child_wheel_reset(wheel);
     }
 
     while ((netif = netif_iter(netif, &netifs)) != NULL) {
 
-	// skip special interfaces
-	if (netif->type < NETIF_REGULAR)
-	    continue;
-	if ((netif->type == NETIF_WIRELESS) && !(options & OPT_WIRELESS))
-	    continue;
-	if ((netif->type == NETIF_TAP) && !(options & OPT_TAP))
-	    continue;
-
-	// skip excluded interfaces
-	if (netif_excluded(netif, &exclifs))
+	if (child_send_skip(netif))
 	    continue;
 
 	my_log(INFO, "starting loop with interface %s", netif->name); 
 
 	while ((subif = subif_iter(subif, netif)) != NULL) {
-
-	    // handle a given ifindex
-	    if (args->index != NETIF_INDEX_MAX) {
-		if (args->index != subif->index)
-		    continue;
-		subif->link_event++;
-	    } else {
-		subif->link_event = 0;
-	    }
-
-	    // skip special interfaces
-	    if (subif->type < NETIF_REGULAR)
-		continue;
-	    if ((subif->type == NETIF_WIRELESS) && !(options & OPT_WIRELESS))
-		continue;
-	    if ((subif->type == NETIF_TAP) && !(options & OPT_TAP))
+	    if (child_send_skip(subif))
 		continue;
 
-	    // skip excluded interfaces
-	    if (netif_excluded(subif, &exclifs))
+	    if (wheel == NULL) {
+		count = child_send_subif(fd, netif, subif, count);
 		continue;
-
-	    // populate msg
-	    memset(&msg, 0, sizeof(msg));
-	    msg.index = subif->index;
-
-	    // explicitly listen when recv is enabled
-	    if ((options & OPT_RECV) && (subif->protos == 0)) {
-		struct parent_req mreq = {};
-		mreq.op = PARENT_OPEN;
-		mreq.index = subif->index;
-		my_mreq(&mreq);
 	    }
 
-	    // fetch interface media status
-	    my_log(INFO, "fetching %s media details", subif->name);
-	    if (netif_media(subif) == EXIT_FAILURE)
-		my_log(CRIT, "error fetching interface media details");
+	    child_send_prep(subif);
+	    child_wheel_add(wheel, netif, subif);
+	}
+    }
 
-	    // bail if sending packets is disabled
-	    if (!(options & OPT_SEND))
-		continue;
+    // hand the remaining packets and requests to the parent
+    child_send_flush(fd, smsgs, count);
+    my_mreq_flush();
+    my_mreq_drop();
 
-	    // generate and send packets
-	    for (int p = 0; protos[p].name != NULL; p++) {
-
-		// only enabled protos
-		if (!(protos[p].enabled) && !(netif->protos & (1 << p)))
-		    continue;
-
-		// clear packet
-		memset(msg.msg, 0, ETHER_MAX_LEN);
-
-		my_log(INFO, "building %s packet for %s", 
-			    protos[p].name, subif->name);
-		msg.proto = p;
-		msg.len = protos[p].build(p, msg.msg, subif,
-						&netifs, &sysinfo);
-
-		if (msg.len == 0) {
-		    my_log(CRIT, "can't generate %s packet for %s",
-				  protos[p].name, subif->name);
-		    continue;
-		}
-
-		// zero the src when sending on a backup subif
-		if ((netif->bonding_mode == NETIF_BONDING_FAILOVER) &&
-		    (subif->child != NETIF_CHILD_ACTIVE))
-		    memset(msg.msg + ETHER_ADDR_LEN, 0, ETHER_ADDR_LEN);
-
-		// write it to the wire.
-		my_log(INFO, "sending %s packet (%zu bytes) on %s",
-			    protos[p].name, msg.len, subif->name);
-		len = write(fd, &msg, PARENT_MSG_LEN(msg.len));
-		if (len < PARENT_MSG_MIN || len != PARENT_MSG_LEN(msg.len))
-		    my_fatale("only %zi bytes written", len);
-	    }
-	}
+    if (wheel != NULL) {
+	if (wheel->count)
+	    my_log(INFO, "scheduled %u frames over %u slots, "
+		"peak %u per slot", wheel->count, wheel->used, wheel->peak);
+	child_wheel_arm(fd, wheel, 0);
     }
 
 out:
@@ -295,46 +303,576 @@ out:
     event_add(&args->event, &tv);
 }
 
+// transmit on the given ifindexes only, used for link events
+void child_send_links(int fd, uint32_t *index, int count) {
+    struct netif *netif, *subif;
+    time_t now = time(NULL);
+    int i, sent = 0;
+
+    // bail early when flapping interfaces used up their credit
+    for (i = 0; i < count; i++) {
+	subif = netif_byindex(&netifs, index[i]);
+	if (!subif || child_tx_credit(subif, now))
+	    break;
+	child_tx_fast(subif, 1);
+    }
+    if (i == count)
+	return;
+
+    // no configured ethernet interfaces found
+    if (child_send_fetch() == 0)
+	return;
+
+    for (i = 0; i < count; i++) {
+
+	// no interface matching the given ifindex found
+	if ((subif = netif_byindex(&netifs, index[i])) == NULL)
+	    continue;
+	if (child_send_skip(subif))
+	    continue;
+
+	// retry from the fast timer once credit is available
+	if (child_tx_credit(subif, now) == 0) {
+	    child_tx_fast(subif, 1);
+	    continue;
+	}
+	subif->tx_credit--;
+
+	// followed by a burst of lldp frames
+	child_tx_fast(subif, TX_FAST_INIT - 1);
+
+	// reached via the parent, see netif_iter and subif_iter
+	netif = subif->parent;
+	if (netif && (netif->type > NETIF_PARENT) &&
+	    netif_listed(netif) && !child_send_skip(netif))
+	    sent = child_send_subif(fd, netif, subif, sent);
+
+	// or directly
+	netif = subif;
+	if ((netif->type < NETIF_PARENT) &&
+	    netif_listed(netif) && !child_send_skip(netif))
+	    sent = child_send_subif(fd, netif, subif, sent);
+    }
+
+    // hand the remaining packets and requests to the parent
+    child_send_flush(fd, smsgs, sent);
+    my_mreq_flush();
+    my_mreq_drop();
+}
+
+// track the generation of the inputs shared by all frames
+static void child_send_gen() {
+    static struct my_sysinfo gen_sysinfo;
+    static uint32_t sysinfo_gen = 0;
+    struct netif *netif;
+    uint32_t gen;
+
+    if (memcmp(&gen_sysinfo, &sysinfo, sizeof(sysinfo)) != 0) {
+	memcpy(&gen_sysinfo, &sysinfo, sizeof(sysinfo));
+	sysinfo_gen = ++netif_gens;
+    }
+    frame_gen = sysinfo_gen;
+
+    // removed vlans only show up in the list generation
+    if ((netifs.hash != NULL) && (netifs.hash->gen > frame_gen))
+	frame_gen = netifs.hash->gen;
+
+    // vlan names and the management addresses end up in every frame
+    TAILQ_FOREACH(netif, &netifs, entries) {
+	if ((netif->type != NETIF_VLAN) && (netif != sysinfo.mnetif))
+	    continue;
+	if ((gen = netif_gen(netif)) > frame_gen)
+	    frame_gen = gen;
+    }
+}
+
+// update netifs, link events keep them current between rescans
+uint16_t child_send_fetch() {
+    uint16_t valid;
+
+    if (link_rescan || !link_events) {
+	my_log(INFO, "fetching all interfaces"); 
+	// without events the alias and media could have changed unnoticed
+	netif_facts_forget(NETIF_INDEX_MAX,
+			   NETIF_FACT_ALIAS|NETIF_FACT_MEDIA);
+	valid = netif_fetch(sargc, sargv, &sysinfo, &netifs);
+	link_rescan = 0;
+    } else {
+	valid = netif_valid(sargc, sargv, &sysinfo, &netifs);
+    }
+
+    child_send_gen();
+    return(valid);
+}
+
+int child_send_skip(struct netif *netif) {
+
+    // skip special interfaces
+    if (netif->type < NETIF_REGULAR)
+	return(1);
+    if ((netif->type == NETIF_WIRELESS) && !(options & OPT_WIRELESS))
+	return(1);
+    if ((netif->type == NETIF_TAP) && !(options & OPT_TAP))
+	return(1);
+
+    // skip excluded interfaces
+    if (netif_excluded(netif, &exclifs))
+	return(1);
+
+    return(0);
+}
+
+// open the subif and refresh the media details used by the frames
+void child_send_prep(struct netif *subif) {
+
+    // explicitly listen when recv is enabled
+    if ((options & OPT_RECV) && (subif->protos == 0)) {
+	struct parent_req mreq = {};
+	mreq.op = PARENT_OPEN;
+	mreq.index = subif->index;
+	my_mreq_queue(&mreq);
+    }
+
+    // fetch interface media status
+    my_log(INFO, "fetching %s media details", subif->name);
+    if (netif_media(subif) == EXIT_FAILURE)
+	my_log(CRIT, "error fetching interface media details");
+}
+
+// queue packets for all enabled protocols, returns the new queue count
+int child_send_subif(int fd, struct netif *netif, struct netif *subif,
+		     int count) {
+
+    child_send_prep(subif);
+
+    // bail if sending packets is disabled
+    if (!(options & OPT_SEND))
+	return(count);
+
+    return(child_send_frames(fd, netif, subif, count, UINT32_MAX));
+}
+
+// the generation of the frames of a subif
+static uint32_t child_send_frame_gen(struct netif *netif,
+				     struct netif *subif) {
+    uint32_t gen;
+
+    gen = netif_gen(subif);
+    if (netif_gen(netif) > gen)
+	gen = netif->gen;
+    if (frame_gen > gen)
+	gen = frame_gen;
+    return(gen);
+}
+
+// queue packets for the given protocols, returns the new queue count
+int child_send_frames(int fd, struct netif *netif, struct netif *subif,
+		      int count, uint32_t pmask) {
+    struct parent_msg *msg;
+    struct netif_frame *frame;
+    uint32_t gen;
+
+    // frames only need a rebuild when one of their inputs changed
+    gen = child_send_frame_gen(netif, subif);
+
+    // generate and send packets
+    for (int p = 0; protos[p].name != NULL; p++) {
+
+	// only enabled protos
+	if (!(protos[p].enabled) && !(netif->protos & (1 << p)))
+	    continue;
+	if (!(pmask & (1 << p)))
+	    continue;
+
+	if (subif->frames[p] == NULL)
+	    subif->frames[p] = my_malloc(sizeof(struct netif_frame));
+	frame = subif->frames[p];
+
+	if (protos[p].uncached || (frame->gen != gen)) {
+	    my_log(INFO, "building %s packet for %s", 
+			protos[p].name, subif->name);
+	    memset(frame->buf, 0, ETHER_MAX_LEN);
+	    frame->len = protos[p].build(p, frame->buf, subif,
+					    &netifs, &sysinfo);
+	    frame->gen = gen;
+	    frame_builds++;
+	} else {
+	    frame_hits++;
+	}
+
+	if (frame->len == 0) {
+	    my_log(CRIT, "can't generate %s packet for %s",
+			  protos[p].name, subif->name);
+	    continue;
+	}
+
+	// populate msg
+	msg = &smsgs[count];
+	memset(msg, 0, PARENT_MSG_MIN);
+	msg->index = subif->index;
+	msg->proto = p;
+	msg->len = frame->len;
+	memcpy(msg->msg, frame->buf, frame->len);
+
+	// zero the src when sending on a backup subif
+	if ((netif->bonding_mode == NETIF_BONDING_FAILOVER) &&
+	    (subif->child != NETIF_CHILD_ACTIVE))
+	    memset(msg->msg + ETHER_ADDR_LEN, 0, ETHER_ADDR_LEN);
+
+	// queue it for the wire
+	my_log(INFO, "sending %s packet (%zu bytes) on %s",
+		    protos[p].name, msg->len, subif->name);
+	if (++count == PARENT_MSG_BATCH) {
+	    child_send_flush(fd, smsgs, count);
+	    count = 0;
+	}
+    }
+
+    return(count);
+}
+
+// start a new round, anything left from the previous one has been sent
+void child_wheel_reset(struct child_wheel *wheel) {
+
+    if (wheel->seed == 0)
+	wheel->seed = random() | 1;
+
+    memset(wheel->slots, 0xff, sizeof(wheel->slots));
+    memset(wheel->load, 0, sizeof(wheel->load));
+    wheel->pos = 0;
+    wheel->count = 0;
+    wheel->tx_count = 0;
+    wheel->peak = 0;
+    wheel->used = 0;
+}
+
+// schedule a single frame, the phase is fixed per process and ifindex
+void child_wheel_insert(struct child_wheel *wheel, uint32_t netif,
+			uint32_t subif, uint8_t proto) {
+    struct child_tx *tx;
+    uint32_t slot;
+    int jitter;
+
+    if (wheel->tx_count == wheel->tx_size) {
+	wheel->tx_size = wheel->tx_size ? wheel->tx_size * 2 : 64;
+	wheel->tx = my_realloc(wheel->tx,
+			       wheel->tx_size * sizeof(struct child_tx));
+    }
+
+    slot = netif_hash_index(subif ^ wheel->seed) + proto * 0x9e3779b9;
+    jitter = random() % (2 * CHILD_WHEEL_JITTER + 1) - CHILD_WHEEL_JITTER;
+    slot = (slot % CHILD_WHEEL_SLOTS + CHILD_WHEEL_SLOTS + jitter) %
+	    CHILD_WHEEL_SLOTS;
+
+    tx = &wheel->tx[wheel->tx_count];
+    tx->netif = netif;
+    tx->subif = subif;
+    tx->proto = proto;
+    tx->next = wheel->slots[slot];
+    wheel->slots[slot] = wheel->tx_count++;
+
+    if (wheel->load[slot]++ == 0)
+	wheel->used++;
+    if (wheel->load[slot] > wheel->peak)
+	wheel->peak = wheel->load[slot];
+    wheel->count++;
+}
+
+// schedule all enabled protocols of a subif
+void child_wheel_add(struct child_wheel *wheel, struct netif *netif,
+		     struct netif *subif) {
+
+    if (!(options & OPT_SEND))
+	return;
+
+    for (int p = 0; protos[p].name != NULL; p++) {
+	if (!(protos[p].enabled) && !(netif->protos & (1 << p)))
+	    continue;
+	child_wheel_insert(wheel, netif->index, subif->index, p);
+    }
+}
+
+// send the frames in the current slot
+static void child_wheel_fire(int fd, struct child_wheel *wheel) {
+    struct netif *netif, *subif;
+    struct child_tx *tx;
+    uint32_t i;
+    int count = 0;
+
+    for (i = wheel->slots[wheel->pos]; i != CHILD_WHEEL_NONE; i = tx->next) {
+	tx = &wheel->tx[i];
+	wheel->count--;
+
+	// interfaces might have disappeared since the round started
+	netif = netif_byindex(&netifs, tx->netif);
+	subif = netif_byindex(&netifs, tx->subif);
+	if (!netif || !subif || child_send_skip(netif) ||
+	    child_send_skip(subif))
+	    continue;
+
+	count = child_send_frames(fd, netif, subif, count, 1 << tx->proto);
+    }
+    wheel->slots[wheel->pos] = CHILD_WHEEL_NONE;
+
+    child_send_flush(fd, smsgs, count);
+}
+
+// wait for the next busy slot after from
+void child_wheel_arm(int fd, struct child_wheel *wheel, uint32_t from) {
+    struct timeval tv;
+    uint32_t slot, msecs;
+
+    for (slot = wheel->pos; slot < CHILD_WHEEL_SLOTS; slot++) {
+	if (wheel->slots[slot] != CHILD_WHEEL_NONE)
+	    break;
+    }
+    if (slot == CHILD_WHEEL_SLOTS)
+	return;
+
+    msecs = (slot - from) * CHILD_WHEEL_TICK;
+    tv.tv_sec = msecs / 1000;
+    tv.tv_usec = (msecs % 1000) * 1000;
+
+    wheel->pos = slot;
+    wheel->pending = 1;
+    event_set(&wheel->event, fd, 0, (void *)child_wheel_tick, wheel);
+    event_add(&wheel->event, &tv);
+}
+
+void child_wheel_tick(int fd, short __unused(event),
+		      struct child_wheel *wheel) {
+    uint32_t pos = wheel->pos;
+
+    wheel->pending = 0;
+    child_wheel_fire(fd, wheel);
+
+    wheel->pos++;
+    child_wheel_arm(fd, wheel, pos);
+}
+
+// send everything still on the wheel right away
+void child_wheel_drain(int fd, struct child_wheel *wheel) {
+
+    if (wheel->pending) {
+	event_del(&wheel->event);
+	wheel->pending = 0;
+    }
+
+    for (; wheel->count && (wheel->pos < CHILD_WHEEL_SLOTS); wheel->pos++)
+	child_wheel_fire(fd, wheel);
+}
+
+// refill the txCredit of a port, one credit per second
+uint8_t child_tx_credit(struct netif *subif, time_t now) {
+    time_t credit;
+
+    if (subif->tx_refill == 0) {
+	subif->tx_credit = TX_CREDIT_MAX;
+	subif->tx_refill = now;
+    }
+
+    if (now > subif->tx_refill) {
+	credit = subif->tx_credit + (now - subif->tx_refill);
+	subif->tx_credit = (credit < TX_CREDIT_MAX) ? credit : TX_CREDIT_MAX;
+	subif->tx_refill = now;
+    }
+
+    return(subif->tx_credit);
+}
+
+static void child_tx_arm() {
+    struct timeval tv = { .tv_sec = TX_FAST_SECS };
+
+    if ((tx_fd == -1) || tx_pending)
+	return;
+
+    tx_pending = 1;
+    event_set(&tx_event, tx_fd, 0, child_tx_tick, NULL);
+    event_add(&tx_event, &tv);
+}
+
+// request fast lldp transmits on a port
+void child_tx_fast(struct netif *subif, uint8_t fast) {
+
+    if (subif->tx_fast < fast)
+	subif->tx_fast = fast;
+    child_tx_arm();
+}
+
+// send the pending fast and triggered lldp frames within the txCredit,
+// returns the number of ports still waiting
+int child_tx_run(int fd, time_t now) {
+    struct netif *netif = NULL, *subif = NULL;
+    struct netif_frame *frame;
+    int count = 0, waiting = 0;
+
+    // refresh the inputs after a local change
+    if (tx_local && (child_send_fetch() == 0))
+	tx_local = 0;
+
+    while ((netif = netif_iter(netif, &netifs)) != NULL) {
+
+	if (child_send_skip(netif))
+	    continue;
+
+	while ((subif = subif_iter(subif, netif)) != NULL) {
+
+	    if (child_send_skip(subif) || !(options & OPT_SEND) ||
+		(!(protos[PROTO_LLDP].enabled) &&
+		 !(netif->protos & (1 << PROTO_LLDP)))) {
+		subif->tx_fast = 0;
+		continue;
+	    }
+
+	    // somethingChangedLocal, only ports with a stale frame
+	    frame = subif->frames[PROTO_LLDP];
+	    if (tx_local && frame && (subif->tx_fast == 0) &&
+		(frame->gen != child_send_frame_gen(netif, subif)))
+		subif->tx_fast = 1;
+
+	    if (subif->tx_fast == 0)
+		continue;
+
+	    if (child_tx_credit(subif, now) == 0) {
+		waiting++;
+		continue;
+	    }
+	    subif->tx_credit--;
+
+	    count = child_send_frames(fd, netif, subif, count,
+					1 << PROTO_LLDP);
+	    if (--subif->tx_fast)
+		waiting++;
+	}
+    }
+    tx_local = 0;
+
+    child_send_flush(fd, smsgs, count);
+    return(waiting);
+}
+
+void child_tx_tick(int fd, short __unused(event), void __unused(*arg)) {
+
+    tx_pending = 0;
+    if (child_tx_run(fd, time(NULL)))
+	child_tx_arm();
+}
+
+void child_rescan(int __unused(sig), short __unused(event), void *arg) {
+    struct child_send_args *args = arg;
+    struct timeval tv = { .tv_sec = 0 };
+
+    my_log(CRIT, "rescanning all interfaces");
+    link_rescan = 1;
+    netif_facts_forget(NETIF_INDEX_MAX, NETIF_FACT_ALL);
+
+    // run the transmit loop right away
+    event_del(&args->event);
+    event_add(&args->event, &tv);
+}
+
+void child_send_flush(int fd, struct parent_msg *msgs, int count) {
+    int sent;
+
+    if (count == 0)
+	return;
+
+    if ((sent = my_msend(fd, msgs, count)) != count)
+	my_fatale("only %d of %d messages written", sent, count);
+}
+
+// decode statistics, see child_queue_refresh
+uint32_t queue_hits = 0, queue_decodes = 0;
+
 void child_queue(int fd, short __unused(event)) {
-    struct parent_msg rmsg = {};
-    struct parent_msg  *msg = NULL, *qmsg = NULL, *pmsg = NULL;
-    struct netif *subif, *netif;
-    struct ether_hdr *ether;
+    static struct parent_msg rmsgs[PARENT_MSG_BATCH];
     time_t now;
-    ssize_t len;
+    int count;
 
     my_log(INFO, "receiving message from parent");
-    if ((len = read(fd, &rmsg, PARENT_MSG_MAX)) == -1)
-	return;
-    if (len < PARENT_MSG_MIN || len != PARENT_MSG_LEN(rmsg.len))
+    if ((count = my_mrecv(fd, rmsgs, PARENT_MSG_BATCH)) == 0)
 	return;
     if ((now = time(NULL)) == (time_t)-1)
 	return;
 
-    assert(rmsg.proto < PROTO_MAX);
-    assert(rmsg.len <= ETHER_MAX_LEN);
+    for (int i = 0; i < count; i++)
+	child_queue_msg(&rmsgs[i], now, 0);
+
+    my_log(DEBUG, "decoded %u advertisements, refreshed %u unchanged",
+	    queue_decodes, queue_hits);
+}
+
+// refresh the stored copy of a byte-identical frame without decoding it,
+// returns 0 when the full decode is required
+static int child_queue_refresh(struct parent_msg *rmsg, struct netif *subif,
+			       time_t now) {
+    struct parent_msg *msg;
+    struct netif *netif = (subif->parent) ? subif->parent : subif;
+
+    if ((msg = mqueue_lookup(&mqueue, rmsg)) == NULL)
+	return(0);
+
+    // held by a cli snapshot, replaced via the copy in child_queue_msg
+    if ((msg->refs > 1) || (msg->ttl == 0))
+	return(0);
+    if ((msg->len != rmsg->len) ||
+	(memcmp(msg->msg, rmsg->msg, rmsg->len) != 0))
+	return(0);
+    if (strcmp(msg->name, subif->name) != 0)
+	return(0);
+
+    // protocols are re-enabled after a rescan
+    if ((options & OPT_AUTO) && !(netif->protos & (1 << msg->proto)))
+	return(0);
+
+    my_log(INFO, "refreshing unchanged %s advertisement on %s",
+	    protos[msg->proto].name, subif->name);
+    msg->received = now;
+    if (msg->record)
+	msg->record->received = now;
+    mqueue_update(&mqueue, msg);
+    queue_hits++;
+
+    return(1);
+}
+
+// restored neighbors are queued quietly, see child_load
+void child_queue_msg(struct parent_msg *rmsg, time_t now, uint8_t restore) {
+    struct parent_msg  *msg = NULL;
+    struct netif *subif, *netif;
+    struct ether_hdr *ether;
+    uint8_t changed = 0;
+
+    assert(rmsg->proto < PROTO_MAX);
+    assert(rmsg->len <= ETHER_MAX_LEN);
 
     // skip unknown interfaces
-    if ((subif = netif_byindex(&netifs, rmsg.index)) == NULL)
+    if ((subif = netif_byindex(&netifs, rmsg->index)) == NULL)
 	return;
-    strlcpy(rmsg.name, subif->name, sizeof(rmsg.name));
+    strlcpy(rmsg->name, subif->name, sizeof(rmsg->name));
 
     // skip locally generated packets
-    ether = (struct ether_hdr *)rmsg.msg;
+    ether = (struct ether_hdr *)rmsg->msg;
     if (netif_byaddr(&netifs, ether->src) != NULL)
 	return;
 
+    // identical refreshes only need a new timestamp
+    if (child_queue_refresh(rmsg, subif, now))
+	return;
+
     // decode message
     my_log(INFO, "decoding advertisement");
-    rmsg.decode = DECODE_STR;
-    if (protos[rmsg.proto].decode(&rmsg) == 0) {
-	peer_free(rmsg.peer);
+    queue_decodes++;
+    rmsg->decode = DECODE_STR;
+    peer_reset(rmsg);
+    if (protos[rmsg->proto].decode(rmsg) == 0) {
+	peer_reset(rmsg);
     	return;
     }
 
     // add current timestamp unless it's a shutdown msg
-    if (rmsg.ttl)
-	rmsg.received = now;
+    if (rmsg->ttl)
+	rmsg->received = now;
 
     // fetch the parent netif
     if (subif->parent)
@@ -342,44 +880,47 @@ void child_queue(int fd, short __unused(event)) {
     else
 	netif = subif;
 
-    TAILQ_FOREACH(qmsg, &mqueue, entries) {
-	// match ifindex
-	if (rmsg.index != qmsg->index)
-	    continue;
-	// save a pointer if the message peer matches
-	if (memcmp(rmsg.msg + ETHER_ADDR_LEN, qmsg->msg + ETHER_ADDR_LEN,
-		    ETHER_ADDR_LEN) == 0)
-	    pmsg = qmsg;
-	// match protocol
-	if (rmsg.proto != qmsg->proto)
-	    continue;
-	// identical source & destination
-	if (memcmp(rmsg.msg, qmsg->msg, ETHER_ADDR_LEN * 2) != 0)
-	    continue;
+    // refreshes with an identical frame are not reported to watchers
+    if ((msg = mqueue_lookup(&mqueue, rmsg)) != NULL)
+	changed = (msg->len != rmsg->len) ||
+		  (memcmp(msg->msg, rmsg->msg, rmsg->len) != 0);
 
-       msg = qmsg;
-       break;
-    }
+    if ((msg != NULL) && (msg->refs > 1)) {
+	// held by a cli snapshot or watcher, replace it with a fresh copy
+	struct parent_msg *omsg = msg;
 
-    if (msg != NULL) {
-	// free the old peer decode
-	peer_free(msg->peer);
+	msg = my_malloc(PARENT_MSG_SIZ);
+	memcpy(msg, rmsg, offsetof(struct parent_msg, entries));
+	rmsg->arena = NULL;
+	mqueue_replace(&mqueue, omsg, msg);
+	mqueue_unref(omsg);
+    } else if (msg != NULL) {
+	// swap arenas, the old peer decode becomes the next scratch space
+	struct peer_arena *arena = msg->arena;
 	// copy everything upto the tailq_entry
-	memcpy(msg, &rmsg, offsetof(struct parent_msg, entries));
+	memcpy(msg, rmsg, offsetof(struct parent_msg, entries));
+	rmsg->arena = arena;
+	mqueue_update(&mqueue, msg);
     } else {
 	char *hostname = NULL;
 
 	msg = my_malloc(PARENT_MSG_SIZ);
-	memcpy(msg, &rmsg, offsetof(struct parent_msg, entries));
-	// group messages per peer
-	if (pmsg)
-	    TAILQ_INSERT_AFTER(&mqueue, pmsg, msg, entries);
-	else
-	    TAILQ_INSERT_TAIL(&mqueue, msg, entries);
+	memcpy(msg, rmsg, offsetof(struct parent_msg, entries));
+	// the arena moves along with the peer decode
+	rmsg->arena = NULL;
+	// grouped per peer
+	mqueue_insert(&mqueue, msg);
+	if (msg->ttl)
+	    child_cli_notify(CLI_EVENT_ADD, msg);
+
+	// announce ourselves quickly to new lldp neighbors
+	if (msg->ttl && (msg->proto == PROTO_LLDP) && !restore)
+	    child_tx_fast(subif, TX_FAST_INIT);
 
 	hostname = msg->peer[PEER_HOSTNAME];
 	if (hostname)
-	    my_log(CRIT, "new peer %s (%s) on interface %s",
+	    my_log((restore) ? INFO : CRIT, "%s peer %s (%s) on interface %s",
+		    (restore) ? "restored" : "new",
 		    hostname, protos[msg->proto].name, netif->name);
     }
 
@@ -389,6 +930,9 @@ void child_queue(int fd, short __unused(event)) {
 	return;
     }
 
+    if (changed)
+	child_cli_notify(CLI_EVENT_CHANGE, msg);
+
     // update ifdescr
     if (options & OPT_IFDESCR)
 	netif_descr(subif, &mqueue);
@@ -410,20 +954,16 @@ void child_queue(int fd, short __unused(event)) {
 
 void child_expire() {
     time_t now;
-    struct parent_msg *msg = NULL, *nmsg = NULL;
+    struct parent_msg *msg = NULL;
     struct netif *netif = NULL, *subif = NULL;
     char *hostname = NULL;
+    int expired = 0;
 
     if ((now = time(NULL)) == (time_t)-1)
 	return;
 
     // remove expired messages
-    TAILQ_FOREACH_SAFE(msg, &mqueue, entries, nmsg) {
-	if (likely((msg->received + msg->ttl) >= now))
-	    continue;
-	if (unlikely(msg->lock))
-	    continue;
-
+    while ((msg = mqueue_expired(&mqueue, now)) != NULL) {
 	hostname = msg->peer[PEER_HOSTNAME];
 	if (hostname)
 	    my_log(CRIT, "removing peer %s (%s)",
@@ -433,11 +973,15 @@ void child_expire() {
 	if ((subif = netif_byindex(&netifs, msg->index)) != NULL)
 	    subif->update = 1;
 
-	TAILQ_REMOVE(&mqueue, msg, entries);
-	peer_free(msg->peer);
-	free(msg);
+	mqueue_remove(&mqueue, msg);
+	child_cli_notify(CLI_EVENT_REMOVE, msg);
+	mqueue_unref(msg);
+	expired++;
     }
 
+    if (likely(!expired))
+	return;
+
     // update interfaces
     TAILQ_FOREACH(subif, &netifs, entries) { 
 	if (likely(!subif->update))
@@ -461,14 +1005,61 @@ void child_expire() {
     }
 }
 
+static void child_load_msg(struct parent_msg *msg, time_t received) {
+    struct netif *subif;
+
+    if (msg->proto >= PROTO_MAX)
+	return;
+
+    // skip reused ifindexes
+    subif = netif_byindex(&netifs, msg->index);
+    if ((subif == NULL) || (strcmp(subif->name, msg->name) != 0))
+	return;
+
+    child_queue_msg(msg, received, 1);
+}
+
+void child_load(int fd) {
+    time_t now;
+    int count;
+
+    if ((now = time(NULL)) == (time_t)-1)
+	return;
+
+    if ((count = mqueue_load(fd, now, child_load_msg)) == -1)
+	my_log(INFO, "no valid neighbor snapshot found");
+    else
+	my_log(INFO, "restored %d neighbors", count);
+    state_gen = mqueue.gen;
+}
+
+// write the neighbor snapshot when the queue changed
+void child_save(int __unused(fd), short event, struct event *ev) {
+    struct timeval tv = { .tv_sec = MQUEUE_SAVE_INTERVAL };
+    time_t now;
+
+    if ((state_gen != mqueue.gen) && ((now = time(NULL)) != (time_t)-1)) {
+	if (mqueue_save(&mqueue, state_fd, now) == -1)
+	    my_loge(WARN, "failed to save the neighbor snapshot");
+	state_gen = mqueue.gen;
+    }
+
+    if (ev && (event == EV_TIMEOUT))
+	evtimer_add(ev, &tv);
+}
+
 void child_free(int __unused(sig), short __unused(event), void __unused(*arg)) {
-    struct parent_msg *msg = NULL, *nmsg = NULL;
+    struct parent_msg *msg = NULL;
+
+    // keep the neighbors for the next start
+    if (state_fd != -1)
+	child_save(state_fd, 0, NULL);
 
-    TAILQ_FOREACH_SAFE(msg, &mqueue, entries, nmsg) {
-	TAILQ_REMOVE(&mqueue, msg, entries);
-	peer_free(msg->peer);
-	free(msg);
+    while ((msg = TAILQ_FIRST(&mqueue)) != NULL) {
+	mqueue_remove(&mqueue, msg);
+	mqueue_unref(msg);
     }
+    mqueue_free(&mqueue);
     exit(EXIT_SUCCESS);
 }
 
@@ -488,47 +1079,244 @@ void child_cli_accept(int socket, short __unused(event)) {
     if (setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf)) == -1)
 	my_loge(WARN, "failed to set sndbuf");
 
+    // wait for the query, clients which don't send one get raw messages
     session = my_malloc(sizeof(struct child_session));
-    event_set(&session->event, fd, EV_WRITE, (void *)child_cli_write, session);
+    event_set(&session->event, fd, EV_READ, (void *)child_cli_read, session);
     event_add(&session->event, &tv);
 }
 
-void child_cli_write(int fd, short event, struct child_session *sess) {
-    struct parent_msg *msg = sess->msg;
+void child_cli_read(int fd, short event, struct child_session *sess) {
+    struct cli_query *query = &sess->query;
     struct timeval tv = { .tv_sec = 1 };
+    ssize_t len;
 
+    // clients which didn't start a query get raw messages
+    if ((event == EV_TIMEOUT) && (sess->qlen == 0)) {
+	sess->raw = 1;
+	sess->snap = mqueue_snapshot(&mqueue);
+	child_cli_write(fd, EV_WRITE, sess);
+	return;
+    }
     if (event == EV_TIMEOUT)
-	goto cleanup;
+	goto invalid;
+
+    // stream sockets may return the query in pieces
+    len = read(fd, (uint8_t *)query + sess->qlen, sizeof(*query) - sess->qlen);
+    if ((len == -1) && ((errno == EAGAIN) || (errno == EINTR)))
+	goto again;
+    if (len <= 0)
+	goto invalid;
+    sess->qlen += len;
+
+    if (sess->qlen < CLI_QUERY_LEN(0))
+	goto again;
+    if ((query->version != CLI_VERSION) || (query->count > CLI_QUERY_MAX))
+	goto invalid;
+    if (sess->qlen < CLI_QUERY_LEN(query->count))
+	goto again;
+    if (sess->qlen != CLI_QUERY_LEN(query->count))
+	goto invalid;
+
+    // partial records are rendered into a per-session buffer
+    if (query->fields != CLI_FIELDS_PEER)
+	sess->rec = my_malloc(PEER_RECORD_MAX);
+
+    // watchers are notified of changes after the snapshot
+    if (query->flags & CLI_QUERY_WATCH) {
+	sess->events = my_calloc(CHILD_EVENT_MAX, sizeof(struct child_event));
+	TAILQ_INSERT_TAIL(&watchers, sess, entries);
+	event_set(&sess->revent, fd, EV_READ|EV_PERSIST,
+		    (void *)child_cli_close, sess);
+	event_add(&sess->revent, NULL);
+    }
 
-    // grab the first message
-    if (!msg)
-	msg = TAILQ_FIRST(&mqueue);
-    // or release
-    else
-	msg->lock--;
+    sess->snap = mqueue_snapshot(&mqueue);
+    child_cli_write(fd, EV_WRITE, sess);
+    return;
 
-    for (; msg != NULL; msg = TAILQ_NEXT(msg, entries)) {
-	if (write(fd, msg, PARENT_MSG_MAX) != -1)
-	    continue;
+again:
+    event_add(&sess->event, &tv);
+    return;
 
-	// bail unless non-block
-	if (errno != EAGAIN)
-	    break;
+invalid:
+    my_log(INFO, "invalid cli query");
+    free(sess);
+    close(fd);
+}
 
-	// schedule a new event
-	msg->lock++;
-	sess->msg = msg;
-	event_set(&sess->event, fd, EV_WRITE, (void *)child_cli_write, sess);
-	event_add(&sess->event, &tv);
-	return;
+static inline int child_cli_match(struct child_session *sess,
+    struct parent_msg *msg) {
+    struct cli_query *query = &sess->query;
+    uint32_t i;
+
+    if (sess->raw)
+	return(1);
+    if (!(query->proto & (1 << msg->proto)))
+	return(0);
+    if (!query->count)
+	return(1);
+
+    for (i = 0; i < query->count; i++) {
+	if (query->index[i] == msg->index)
+	    return(1);
     }
+    return(0);
+}
+
+// write a single record, markers are sent without a msg
+static ssize_t child_cli_send(int fd, struct child_session *sess,
+    struct parent_msg *msg, uint8_t type, time_t now) {
+    struct peer_record *rec, marker = {};
+
+    if (msg == NULL) {
+	marker.len = PEER_RECORD_MIN;
+	marker.event = type;
+	return(write(fd, &marker, marker.len));
+    }
+
+    if (sess->raw)
+	return(write(fd, msg, PARENT_MSG_MAX));
+
+    // rendered once, the holdtime is refreshed on every write
+    rec = peer_record_fields(msg, sess->query.fields, sess->rec);
+    rec->event = type;
+    rec->holdtime = 0;
+    if ((type != CLI_EVENT_REMOVE) && (msg->ttl > (now - msg->received)))
+	rec->holdtime = msg->ttl - (now - msg->received);
+    return(write(fd, rec, rec->len));
+}
+
+static void child_cli_free(int fd, struct child_session *sess) {
 
-cleanup:
     event_del(&sess->event);
+    if (sess->events) {
+	event_del(&sess->revent);
+	TAILQ_REMOVE(&watchers, sess, entries);
+	for (; sess->ecount; sess->ecount--) {
+	    mqueue_unref(sess->events[sess->ehead].msg);
+	    sess->ehead = (sess->ehead + 1) % CHILD_EVENT_MAX;
+	}
+	free(sess->events);
+    }
+    if (sess->snap)
+	mqueue_snap_unref(&mqueue, sess->snap);
+    free(sess->rec);
     free(sess);
     close(fd);
 }
 
+void child_cli_write(int fd, short event, struct child_session *sess) {
+    struct parent_msg *msg;
+    struct child_event *ev;
+    struct timeval tv = { .tv_sec = 1 };
+    time_t now = time(NULL);
+
+    if (event == EV_TIMEOUT)
+	goto cleanup;
+
+    if (sess->overflow) {
+	if (child_cli_send(fd, sess, NULL, CLI_EVENT_OVERFLOW, now) == -1)
+	    goto error;
+	sess->overflow = 0;
+    }
+
+    // the snapshot stays intact while the queue changes
+    if (sess->snap) {
+	for (; sess->pos < sess->snap->count; sess->pos++) {
+	    msg = sess->snap->msgs[sess->pos];
+	    if (!child_cli_match(sess, msg))
+		continue;
+	    if (child_cli_send(fd, sess, msg, CLI_EVENT_NONE, now) == -1)
+		goto error;
+	}
+
+	if (!sess->events)
+	    goto cleanup;
+	if (child_cli_send(fd, sess, NULL, CLI_EVENT_SYNC, now) == -1)
+	    goto error;
+
+	mqueue_snap_unref(&mqueue, sess->snap);
+	sess->snap = NULL;
+	sess->pos = 0;
+    }
+
+    // followed by the queued events
+    for (; sess->ecount; sess->ecount--) {
+	ev = &sess->events[sess->ehead];
+	if (child_cli_send(fd, sess, ev->msg, ev->type, now) == -1)
+	    goto error;
+	mqueue_unref(ev->msg);
+	sess->ehead = (sess->ehead + 1) % CHILD_EVENT_MAX;
+    }
+    return;
+
+error:
+    // bail unless non-block
+    if (errno != EAGAIN)
+	goto cleanup;
+
+    // schedule a new event, clients which stop reading are dropped
+    event_set(&sess->event, fd, EV_WRITE, (void *)child_cli_write, sess);
+    event_add(&sess->event, &tv);
+    return;
+
+cleanup:
+    child_cli_free(fd, sess);
+}
+
+// watch sessions only end when the cli disconnects
+void child_cli_close(int fd, short __unused(event),
+		     struct child_session *sess) {
+    char buf[CLI_QUERY_LEN(CLI_QUERY_MAX)];
+    ssize_t len;
+
+    len = read(fd, buf, sizeof(buf));
+    if ((len > 0) || ((len == -1) && (errno == EAGAIN)))
+	return;
+    child_cli_free(fd, sess);
+}
+
+// queue a neighbor change for all matching watchers
+void child_cli_notify(uint8_t type, struct parent_msg *msg) {
+    struct child_session *sess, *nsess;
+    struct child_event *ev;
+
+    TAILQ_FOREACH_SAFE(sess, &watchers, entries, nsess) {
+	if (!child_cli_match(sess, msg))
+	    continue;
+
+	// a watcher which can't keep up with a snapshot would pin the queue
+	if ((sess->ecount == CHILD_EVENT_MAX) && sess->snap) {
+	    my_log(INFO, "cli watcher too slow, disconnecting");
+	    child_cli_free(EVENT_FD(&sess->revent), sess);
+	    continue;
+	}
+
+	if (sess->ecount == CHILD_EVENT_MAX) {
+	    // drop the backlog, the client resyncs from a new snapshot
+	    for (; sess->ecount; sess->ecount--) {
+		mqueue_unref(sess->events[sess->ehead].msg);
+		sess->ehead = (sess->ehead + 1) % CHILD_EVENT_MAX;
+	    }
+	    sess->snap = mqueue_snapshot(&mqueue);
+	    sess->pos = 0;
+	    sess->overflow = 1;
+	    my_log(INFO, "cli watcher overflow");
+	} else {
+	    ev = &sess->events[(sess->ehead + sess->ecount++) % CHILD_EVENT_MAX];
+	    ev->msg = msg;
+	    ev->type = type;
+	    msg->refs++;
+	}
+
+	if (!event_pending(&sess->event, EV_WRITE, NULL)) {
+	    event_set(&sess->event, EVENT_FD(&sess->revent), EV_WRITE,
+		    (void *)child_cli_write, sess);
+	    event_add(&sess->event, NULL);
+	}
+    }
+}
+
 #ifdef HAVE_LIBMNL
 struct mnl_socket *nl;
 #endif
@@ -540,11 +1328,19 @@ int child_link_fd() {
     if (nl == NULL)
 	return -1;
 
-    if (mnl_socket_bind(nl, RTMGRP_LINK, MNL_SOCKET_AUTOPID) < 0) {
+    unsigned int groups = RTMGRP_LINK;
+#ifdef HAVE_NETIF_EVENTS
+    groups |= RTMGRP_IPV4_IFADDR|RTMGRP_IPV6_IFADDR;
+#endif
+
+    if (mnl_socket_bind(nl, groups, MNL_SOCKET_AUTOPID) < 0) {
 	mnl_socket_close(nl);
 	return -1;
     }
     my_nonblock(mnl_socket_get_fd(nl));
+#ifdef HAVE_NETIF_EVENTS
+    link_events = 1;
+#endif
 
     return mnl_socket_get_fd(nl);
 #endif
@@ -570,26 +1366,66 @@ int child_link_fd() {
     return -1;
 }
 
+#ifdef HAVE_NETIF_EVENTS
+// request all addresses, replies are handled like address events
+static void child_link_dump() {
+    char buf[MNL_SOCKET_BUFFER_SIZE];
+    struct nlmsghdr *nlh;
+    struct rtgenmsg *rtg;
+
+    // only one dump can run at a time
+    if (link_dump & LINK_DUMP_RUNNING)
+	return;
+    link_dump = 0;
+
+    nlh = mnl_nlmsg_put_header(buf);
+    nlh->nlmsg_type = RTM_GETADDR;
+    nlh->nlmsg_flags = NLM_F_REQUEST|NLM_F_DUMP;
+    rtg = mnl_nlmsg_put_extra_header(nlh, sizeof(struct rtgenmsg));
+    rtg->rtgen_family = AF_UNSPEC;
+
+    my_log(INFO, "fetching all addresses");
+    if (mnl_socket_sendto(nl, nlh, nlh->nlmsg_len) < 0) {
+	my_loge(WARN, "address request failed");
+	link_rescan = 1;
+	return;
+    }
+    link_dump = LINK_DUMP_RUNNING;
+}
+#endif
+
 #ifdef HAVE_LIBMNL
-static int child_link_cb(const struct nlmsghdr *nlh, void *msgfd) {
+static int child_link_cb(const struct nlmsghdr *nlh, void *largs) {
     struct ifinfomsg *ifm = mnl_nlmsg_get_payload(nlh);
     int ifi_flags = IFF_RUNNING|IFF_LOWER_UP;
-    struct child_send_args args = {};
 
+#ifdef HAVE_NETIF_EVENTS
+    int changes = netif_event(nlh, &sysinfo, &netifs);
+
+    if (changes & NETIF_EVENT_ADDRS)
+	link_dump |= LINK_DUMP_WANTED;
+
+    // resend lldp frames which include the changed details
+    if (changes) {
+	tx_local = 1;
+	child_tx_arm();
+    }
+#endif
+
+    if (nlh->nlmsg_type != RTM_NEWLINK)
+	goto out;
     if (ifm->ifi_type != ARPHRD_ETHER)
         goto out;
     if ((ifm->ifi_flags & ifi_flags) != ifi_flags)
         goto out;
 
-    my_log(INFO, "invoking child_send");
-    args.index = ifm->ifi_index;
-    child_send(*(int*)msgfd, 0, &args);
+    child_link_queue(largs, ifm->ifi_index);
 
 out:
     return MNL_CB_OK;
 }
 #endif
-void child_link(int __unused(fd), short __unused(event), void *msgfd) {
+void child_link(int __unused(fd), short __unused(event), void *largs) {
 
 #ifdef HAVE_LIBMNL
     char buf[MNL_SOCKET_BUFFER_SIZE];
@@ -597,11 +1433,31 @@ void child_link(int __unused(fd), short __unused(event), void *msgfd) {
 
     my_log(INFO, "reading link event");
     while ((ret = mnl_socket_recvfrom(nl, buf, sizeof(buf))) > 0) {
-        ret = mnl_cb_run(buf, ret, 0, 0, child_link_cb, msgfd);
-        if (ret <= 0)
+        ret = mnl_cb_run(buf, ret, 0, 0, child_link_cb, largs);
+        if (ret <= 0) {
+#ifdef HAVE_NETIF_EVENTS
+	    // the address dump finished or failed
+	    if (ret == MNL_CB_ERROR)
+		link_rescan = 1;
+	    link_dump &= ~LINK_DUMP_RUNNING;
+#endif
             break;
+	}
     }
 
+#ifdef HAVE_NETIF_EVENTS
+    // events were lost, fall back to a full rescan
+    if ((ret == -1) && (errno == ENOBUFS)) {
+	my_log(WARN, "link events lost, rescanning all interfaces");
+	link_rescan = 1;
+	link_dump = 0;
+	return;
+    }
+
+    if (link_dump & LINK_DUMP_WANTED)
+	child_link_dump();
+#endif
+
     return;
 #endif
 
@@ -630,9 +1486,65 @@ void child_link(int __unused(fd), short __unused(event), void *msgfd) {
 	return;
 #endif
 
-    my_log(INFO, "invoking child_send");
-    struct child_send_args args = { .index = ifm.ifm_index };
-    child_send(*(int*)msgfd, 0, &args);
+    child_link_queue(largs, ifm.ifm_index);
 #endif
 }
 
+// remember the ifindex and start the coalescing window
+void child_link_queue(struct child_link_args *args, uint32_t index) {
+    struct timeval tv = { .tv_sec = 0, .tv_usec = LINK_DELAY };
+    int i;
+
+    for (i = 0; i < args->count; i++) {
+	if (args->index[i] == index)
+	    break;
+    }
+
+    // too many interfaces, transmit on all of them
+    if (i == args->count) {
+	if (args->count < LINK_BATCH)
+	    args->index[args->count++] = index;
+	else
+	    args->all = 1;
+    }
+
+    if (args->pending)
+	return;
+
+    my_log(INFO, "delaying link event handling");
+    args->pending = 1;
+    event_add(&args->event, &tv);
+}
+
+void child_link_flush(int fd, short __unused(event), void *arg) {
+    struct child_link_args *args = arg;
+    struct netif *netif;
+    uint32_t *index;
+    int count = 0;
+
+    my_log(INFO, "handling link events for %d interfaces", args->count);
+    if (!args->all) {
+	child_send_links(fd, args->index, args->count);
+	goto out;
+    }
+
+    // too many interfaces, all ports are sent on within their credit
+    TAILQ_FOREACH(netif, &netifs, entries)
+	count++;
+    if (count == 0)
+	goto out;
+    index = my_calloc(count, sizeof(uint32_t));
+    count = 0;
+    TAILQ_FOREACH(netif, &netifs, entries) {
+	if (netif->type < NETIF_PARENT)
+	    index[count++] = netif->index;
+    }
+    child_send_links(fd, index, count);
+    free(index);
+
+out:
+    args->pending = 0;
+    args->all = 0;
+    args->count = 0;
+}
+
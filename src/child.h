@@ -24,24 +24,129 @@
 #include <libmnl/libmnl.h>
 #endif 
 
+// frames are spread over SLEEPTIME on a hashed timer wheel, each interface
+// and protocol gets a random phase plus up to CHILD_WHEEL_JITTER slots of
+// jitter per round
+#define CHILD_WHEEL_TICK	100	// msecs per slot
+#define CHILD_WHEEL_SLOTS	(SLEEPTIME * 1000 / CHILD_WHEEL_TICK)
+#define CHILD_WHEEL_JITTER	10
+#define CHILD_WHEEL_NONE	UINT32_MAX
+
+struct child_tx {
+    uint32_t next;
+    uint32_t netif;
+    uint32_t subif;
+    uint8_t proto;
+};
+
+struct child_wheel {
+    struct event event;
+    uint8_t pending;
+    uint32_t seed;
+    uint32_t pos;
+    uint32_t count;	// scheduled but not yet sent
+    uint32_t slots[CHILD_WHEEL_SLOTS];
+    struct child_tx *tx;
+    uint32_t tx_size;
+    uint32_t tx_count;
+
+    // load metrics of the current round
+    uint16_t load[CHILD_WHEEL_SLOTS];
+    uint16_t peak;
+    uint32_t used;
+};
+
 struct child_send_args {
     struct event event;
     uint32_t index;
+    struct child_wheel wheel;
 };
 
-struct child_session {
+// 802.1AB txCreditMax, txFastInit and msgFastTx
+#define TX_CREDIT_MAX	5
+#define TX_FAST_INIT	4
+#define TX_FAST_SECS	1
+
+// link events are collected for LINK_DELAY usecs
+#define LINK_DELAY	200000
+#define LINK_BATCH	64
+
+struct child_link_args {
     struct event event;
+    uint8_t pending;
+    uint8_t all;
+    uint16_t count;
+    uint32_t index[LINK_BATCH];
+};
+
+// seconds between neighbor snapshots
+#define MQUEUE_SAVE_INTERVAL	10
+
+// pending events per watch session, overflows trigger a new snapshot
+#define CHILD_EVENT_MAX	256
+
+struct child_event {
     struct parent_msg *msg;
+    uint8_t type;
+};
+
+struct child_session {
+    struct event event;
+    struct mqueue_snap *snap;
+    uint32_t pos;
+    struct cli_query query;
+    uint16_t qlen;	// query bytes read so far
+    struct peer_record *rec;
+    uint8_t raw;
+
+    // watch sessions only
+    TAILQ_ENTRY(child_session) entries;
+    struct event revent;
+    struct child_event *events;
+    uint16_t ehead;
+    uint16_t ecount;
+    uint8_t overflow;
 };
 
+TAILQ_HEAD(shead, child_session);
+
 void child_send(int fd, short event, struct child_send_args *);
+void child_send_links(int fd, uint32_t *index, int count);
+uint16_t child_send_fetch();
+int child_send_skip(struct netif *);
+void child_send_prep(struct netif *subif);
+int child_send_subif(int fd, struct netif *, struct netif *subif, int count);
+int child_send_frames(int fd, struct netif *, struct netif *subif, int count,
+		      uint32_t protos);
+void child_wheel_reset(struct child_wheel *);
+void child_wheel_insert(struct child_wheel *, uint32_t netif, uint32_t subif,
+			uint8_t proto);
+void child_wheel_add(struct child_wheel *, struct netif *,
+		     struct netif *subif);
+void child_wheel_arm(int fd, struct child_wheel *, uint32_t from);
+void child_wheel_tick(int fd, short event, struct child_wheel *);
+void child_wheel_drain(int fd, struct child_wheel *);
+uint8_t child_tx_credit(struct netif *, time_t now);
+void child_tx_fast(struct netif *, uint8_t fast);
+int child_tx_run(int fd, time_t now);
+void child_tx_tick(int fd, short event, void *);
+void child_send_flush(int fd, struct parent_msg *, int count);
+void child_rescan(int sig, short event, void *);
 void child_queue(int fd, short event);
+void child_queue_msg(struct parent_msg *, time_t now, uint8_t restore);
 void child_expire();
+void child_load(int fd);
+void child_save(int fd, short event, struct event *);
 void child_free(int sig, short event, void *);
 void child_cli_accept(int socket, short event);
+void child_cli_read(int fd, short event, struct child_session *);
 void child_cli_write(int fd, short event, struct child_session *);
+void child_cli_close(int fd, short event, struct child_session *);
+void child_cli_notify(uint8_t type, struct parent_msg *);
 
 int child_link_fd();
 void child_link(int fd, short event, void *);
+void child_link_queue(struct child_link_args *, uint32_t index);
+void child_link_flush(int fd, short event, void *);
 
 #endif /* _child_h */
@@ -25,18 +25,30 @@
 #include <sys/un.h>
 #include <netdb.h>
 #include <termios.h> 
+#ifdef HAVE_LIBZ
+#include <zlib.h>
+#endif /* HAVE_LIBZ */
 
 extern struct proto protos[];
 int status = EXIT_SUCCESS;
 static void usage() __noreturn;
+static void json_output(const char *, size_t);
+
+#define CLI_FIELDS_CLI	(CLI_FIELD(PEER_HOSTNAME) | CLI_FIELD(PEER_PORTNAME) | \
+			 CLI_FIELD(PEER_PORTDESCR) | CLI_FIELD(PEER_CAP))
+#define CLI_FIELDS_HTTP	(CLI_FIELD(PEER_HOSTNAME) | CLI_FIELD(PEER_PORTNAME) | \
+			 CLI_FIELD(PEER_CAP))
 
 static struct mode modes[] = {
-  { &cli_header, &cli_write, NULL },
-  { NULL, NULL, NULL },
-  { NULL, &batch_write, NULL },
-  { &debug_header, &debug_write, &debug_close },
+  { &cli_header, &cli_write, NULL, CLI_FIELDS_CLI },
+  { NULL, NULL, NULL, CLI_FIELD_FRAME },
+  { NULL, &batch_write, NULL, CLI_FIELDS_PEER },
+  { &debug_header, &debug_write, &debug_close, CLI_FIELD_FRAME },
+  { NULL, &json_write, &json_flush, CLI_FIELDS_PEER },
 #if HAVE_EVHTTP_H
-  { &http_connect, &http_request, &http_dispatch },
+  { &http_connect, &http_request, &http_dispatch, CLI_FIELDS_HTTP },
+  { &http_batch_init, &http_batch_write, &http_batch_dispatch,
+    CLI_FIELDS_PEER },
 #endif /* HAVE_EVHTTP_H */
 };
 
@@ -44,36 +56,89 @@ static struct mode modes[] = {
 #define MODE_PRINT  1
 #define MODE_BATCH  2
 #define MODE_DEBUG  3
-#define MODE_HTTP   4
+#define MODE_JSON   4
+#define MODE_HTTP   5
+#define MODE_POST   6
 
 #define TERM_DEFAULT 80
 static int host_width = 20;
 static int port_width = 10;
 
+// watch mode event of the current record
+static uint8_t watch = 0;
+static uint8_t event = CLI_EVENT_NONE;
+static const char *events[] = { "current", "add", "change", "remove" };
+static const char events_abbr[] = " +~-";
+
+// json keys for the PEER_* fields
+static const char *json_keys[] = {
+    "hostname", "portname", "portdescr", "capabilities",
+    "addr_inet4", "addr_inet6", "addr_802", "vlan_id",
+    "platform", "duplex", "vtp_mgmt_dom",
+};
+my_ctassert(sizeof(json_keys) / sizeof(json_keys[0]) == PEER_MAX);
+
+// ndjson output is collected here and written in large chunks
+#define JSON_BUF_SIZE	65536
+#define JSON_LIT(s)	(s), (sizeof(s) - 1)
+static char json_buf[JSON_BUF_SIZE];
+static size_t json_len = 0;
+static void (*json_sink)(const char *, size_t) = &json_output;
+static const char *json_host = NULL;
+
 #if HAVE_EVHTTP_H
 char *http_host = NULL;
 char *http_path = NULL;
 char *hostname = NULL;
 short http_port = 0;
 
+struct event_base *http_base = NULL;
 struct evhttp_connection *evcon = NULL;
 struct evhttp_request *lreq = NULL;
+
+// batched posts, each batch is kept until the collector accepted it.
+// batches are posted as they are closed, with at most one in flight
+struct http_batch {
+    TAILQ_ENTRY(http_batch) entries;
+    struct evbuffer *body;
+    uint32_t count;
+    uint8_t tries;
+};
+static TAILQ_HEAD(, http_batch) http_batches =
+    TAILQ_HEAD_INITIALIZER(http_batches);
+static struct http_batch *http_batch = NULL;
+static struct event http_retry_ev;
+
+uint32_t http_batch_max = HTTP_BATCH_MAX;
+uint32_t http_retry_ms = HTTP_RETRY_MS;
+uint8_t http_gzip = 0;
+
+static void http_url(const char *);
+static void http_batch_close();
+static void http_batch_send();
 #endif /* HAVE_EVHTTP_H */
 
 __noreturn
 void cli_main(int argc, char *argv[]) {
     int ch, i;
+    char *end;
+    unsigned long count;
     uint8_t proto = 0, mode = MODE_CLI;
     uint32_t *indexes = NULL;
     struct sockaddr_un usock = {};
     int fd = -1;
     time_t now;
     struct parent_msg *msg;
+    struct peer_record *rec;
+    struct cli_query query = { .version = CLI_VERSION };
     uint16_t holdtime;
+    int type = SOCK_SEQPACKET;
+    socklen_t slen = sizeof(type);
+    ssize_t len;
 
     options = 0;
 
-    while ((ch = getopt(argc, argv, "LCEFNbdfp:ovh")) != -1) {
+    while ((ch = getopt(argc, argv, "LCEFNbdfjp:P:n:zowvh")) != -1) {
 	switch(ch) {
 	    case 'L':
 		proto |= (1 << PROTO_LLDP);
@@ -99,28 +164,42 @@ void cli_main(int argc, char *argv[]) {
 	    case 'f':
 		mode = MODE_PRINT;
 		break;
+	    case 'j':
+		mode = MODE_JSON;
+		break;
 #if HAVE_EVHTTP_H
 	    case 'p':
 		if (http_host)
 		    usage();
 		mode = MODE_HTTP;
-		if (strncmp(optarg, "http://", 7) == 0)
-		    optarg += 7;
-		char *host = my_strdup(optarg);
-		char *path = strchr(host, '/');
-		if (path) {
-		    http_path = my_strdup(path);
-		    *path = '\0';
-		} else {
-		    http_path = my_strdup("/");
-		}
-		http_host = my_strdup(host);
-		free(host);
+		http_url(optarg);
 		break;
+	    case 'P':
+		if (http_host)
+		    usage();
+		mode = MODE_POST;
+		http_url(optarg);
+		break;
+	    case 'n':
+		errno = 0;
+		count = strtoul(optarg, &end, 10);
+		if ((errno != 0) || (*optarg == '\0') || (*end != '\0') ||
+		    (count == 0) || (count > UINT32_MAX))
+		    usage();
+		http_batch_max = count;
+		break;
+#ifdef HAVE_LIBZ
+	    case 'z':
+		http_gzip = 1;
+		break;
+#endif /* HAVE_LIBZ */
 #endif /* HAVE_EVHTTP_H */
 	    case 'o':
 		options |= OPT_ONCE;
 		break;
+	    case 'w':
+		watch = 1;
+		break;
 	    case 'v':
 		loglevel++;
 		break;
@@ -132,6 +211,10 @@ void cli_main(int argc, char *argv[]) {
     argc -= optind;
     argv += optind;
 
+    // posting relies on a finite list of records
+    if (watch && ((mode == MODE_HTTP) || (mode == MODE_POST)))
+	usage();
+
     // default to all protocols
     if (!proto)
 	proto = UINT8_MAX;
@@ -164,6 +247,22 @@ void cli_main(int argc, char *argv[]) {
 	else
 	    my_fatale("failed to open " PACKAGE_SOCKET);
     }
+    getsockopt(fd, SOL_SOCKET, SO_TYPE, &type, &slen);
+
+    // let the child filter, longer interface lists are filtered here
+    query.proto = proto;
+    query.fields = modes[mode].fields;
+    if (watch)
+	query.flags = CLI_QUERY_WATCH;
+    if (argc <= CLI_QUERY_MAX) {
+	query.count = argc;
+	for (i = 0; i < argc; i++)
+	    query.index[i] = indexes[i];
+    }
+    len = CLI_QUERY_LEN(query.count);
+    if (write(fd, &query, len) != len)
+	my_fatale("failed to send query");
+
     if ((now = time(NULL)) == (time_t)-1)
 	my_fatale("failed to fetch time");
 
@@ -171,13 +270,26 @@ void cli_main(int argc, char *argv[]) {
 	modes[mode].init();
 
     msg = my_malloc(PARENT_MSG_SIZ);
+    rec = my_malloc(PEER_RECORD_MAX);
 
-    while (read(fd, msg, PARENT_MSG_MAX) == PARENT_MSG_MAX) {
+    while ((len = cli_recv(fd, rec, type)) > 0) {
+
+	if (!cli_record(rec, len, msg))
+	    continue;
+
+	// watch markers carry no neighbor
+	if (rec->event == CLI_EVENT_OVERFLOW)
+	    my_log(CRIT, "events lost, resyncing");
+	if (rec->event >= CLI_EVENT_SYNC)
+	    continue;
+	event = rec->event;
+	if (watch && ((now = time(NULL)) == (time_t)-1))
+	    my_fatale("failed to fetch time");
 
 	if (msg->proto >= PROTO_MAX)
 	    continue;
-	if ((msg->len < (ETHER_MIN_LEN - ETHER_VLAN_ENCAP_LEN)) || 
-	    (msg->len > ETHER_MAX_LEN))
+	if ((query.fields & CLI_FIELD_FRAME) &&
+	    (msg->len < (ETHER_MIN_LEN - ETHER_VLAN_ENCAP_LEN)))
 	    continue;
 	
 	// skip unwanted interfaces
@@ -194,26 +306,31 @@ void cli_main(int argc, char *argv[]) {
 	if (!(proto & (1 << msg->proto)))
 	    continue;
 
-	// decode packet
-	msg->decode = DECODE_STR;
-	if (mode == MODE_PRINT)
+	// records arrive decoded, only the print mode decodes the frame
+	if (mode == MODE_PRINT) {
 	    msg->decode = DECODE_PRINT;
+	    if (protos[msg->proto].decode(msg) == 0)
+		continue;
+	}
 
-	if (protos[msg->proto].decode(msg) == 0) {
-	    peer_free(msg->peer);
+	// skip expired packets, removals can't be shown as frames
+	if (event == CLI_EVENT_REMOVE) {
+	    if ((mode == MODE_PRINT) || (mode == MODE_DEBUG))
+		continue;
+	} else if (msg->ttl < (now - msg->received)) {
 	    continue;
 	}
-	// skip expired packets
-	if (msg->ttl < (now - msg->received))
-	    continue;
 
-	holdtime = msg->ttl - (now - msg->received);
+	holdtime = rec->holdtime;
 	
 	if (modes[mode].write)
 	    modes[mode].write(msg, holdtime);
+	if (watch)
+	    fflush(stdout);
 
-	peer_free(msg->peer);
-	memset(msg, 0, PARENT_MSG_SIZ);
+	// the arena is kept for the next decode
+	peer_reset(msg);
+	memset(msg, 0, offsetof(struct parent_msg, peer));
 
 	if (options & OPT_ONCE)
 	    goto out;
@@ -226,10 +343,78 @@ out:
     if (modes[mode].dispatch)
 	modes[mode].dispatch();
 
+    peer_free(msg);
     free(msg);
+    free(rec);
     exit(status);
 }
 
+static int cli_read(int fd, void *buf, size_t len) {
+    ssize_t ret;
+
+    while (len) {
+	if ((ret = read(fd, buf, len)) <= 0)
+	    return(0);
+	buf = (char *)buf + ret;
+	len -= ret;
+    }
+    return(1);
+}
+
+// receive a record, returns the length
+ssize_t cli_recv(int fd, struct peer_record *rec, int type) {
+    ssize_t len;
+
+    // records are length-prefixed on stream sockets
+    if (type == SOCK_STREAM) {
+	if (!cli_read(fd, rec, PEER_RECORD_MIN) ||
+	    (rec->len < PEER_RECORD_MIN) || (rec->len > PEER_RECORD_MAX) ||
+	    !cli_read(fd, rec->data, rec->len - PEER_RECORD_MIN))
+	    return(0);
+	return(rec->len);
+    }
+
+    len = read(fd, rec, PEER_RECORD_MAX);
+    return((len > 0) ? len : 0);
+}
+
+// point the msg peer fields into a validated record
+int cli_record(struct peer_record *rec, size_t len, struct parent_msg *msg) {
+    char *str;
+    int i;
+
+    if ((len < PEER_RECORD_MIN) || (len != rec->len))
+	return(0);
+
+    if (rec->frame) {
+	if ((rec->frame < PEER_RECORD_MIN) ||
+	    (rec->frame_len > ETHER_MAX_LEN) ||
+	    (rec->frame + rec->frame_len > len))
+	    return(0);
+	memcpy(msg->msg, (char *)rec + rec->frame, rec->frame_len);
+	msg->len = rec->frame_len;
+    }
+
+    for (i = 0; i < PEER_MAX; i++) {
+	msg->peer[i] = NULL;
+	if (!rec->peer[i])
+	    continue;
+	str = (char *)rec + rec->peer[i];
+	if ((rec->peer[i] < PEER_RECORD_MIN) || (rec->peer[i] >= len) ||
+	    (memchr(str, '\0', len - rec->peer[i]) == NULL))
+	    return(0);
+	msg->peer[i] = str;
+    }
+
+    msg->index = rec->index;
+    memcpy(msg->name, rec->name, IFNAMSIZ);
+    msg->name[IFNAMSIZ - 1] = '\0';
+    msg->proto = rec->proto;
+    msg->ttl = rec->ttl;
+    msg->received = rec->received;
+    return(1);
+}
+
 static inline void swapchr(char *str, const int c, const int d) {
     if (!str)
 	return;
@@ -276,6 +461,8 @@ void batch_write(struct parent_msg *msg, const uint16_t holdtime) {
     printf("CAPABILITIES_%u='%s'\n", count, STR(cap));
     printf("TTL_%u='%" PRIu16 "'\n", count, msg->ttl);
     printf("HOLDTIME_%u='%" PRIu16 "'\n", count, holdtime);
+    if (watch)
+	printf("EVENT_%u='%s'\n", count, events[event]);
 
     count++;
 }
@@ -304,8 +491,9 @@ void cli_header() {
 	"\tr - Repeater, B - Bridge, H - Host, R - Router, S - Switch,\n"
 	"\tW - WLAN Access Point, C - DOCSIS Device, T - Telephone, "
 	"O - Other\n\n");
-    printf("%-*s Local Intf    Proto   "
-	"Hold-time    Capability    Port ID\n", host_width, "Device ID");
+    printf("%s%-*s Local Intf    Proto   "
+	"Hold-time    Capability    Port ID\n", (watch) ? "  " : "",
+	host_width, "Device ID");
 }
 
 void cli_write(struct parent_msg *msg, const uint16_t holdtime) {
@@ -325,6 +513,8 @@ void cli_write(struct parent_msg *msg, const uint16_t holdtime) {
     if (peer_suffix)
 	portname_abbr(peer_suffix);
 
+    if (watch)
+	printf("%c ", events_abbr[event]);
     printf("%-*.*s %-13.13s %-7.7s %-12" PRIu16 " %-13.13s %-*.*s\n",
 	host_width, host_width, STR(peer_host), STR(msg->name), protos[msg->proto].name,
 	holdtime, STR(cap), port_width, port_width, STR(peer_suffix));
@@ -342,7 +532,128 @@ void debug_close() {
     my_pcap_close();
 }
 
+static void json_append(const char *str, size_t len) {
+
+    if (json_len + len > JSON_BUF_SIZE)
+	json_flush();
+
+    // larger than the buffer, write directly
+    if (len > JSON_BUF_SIZE) {
+	json_sink(str, len);
+	return;
+    }
+
+    memcpy(json_buf + json_len, str, len);
+    json_len += len;
+}
+
+// escape quotes, backslashes and control characters, other bytes outside of
+// ascii are passed as latin-1 code points to keep the output valid utf-8
+static void json_string(const char *str) {
+    static const char hex[] = "0123456789abcdef";
+    char esc[6] = { '\\', 'u', '0', '0' };
+    const unsigned char *s = (const unsigned char *)str, *run = s;
+
+    json_append(JSON_LIT("\""));
+    for (; *s; s++) {
+	if ((*s >= 0x20) && (*s < 0x7f) && (*s != '"') && (*s != '\\'))
+	    continue;
+
+	json_append((const char *)run, s - run);
+	run = s + 1;
+
+	if ((*s == '"') || (*s == '\\')) {
+	    esc[1] = *s;
+	    json_append(esc, 2);
+	    esc[1] = 'u';
+	} else {
+	    esc[4] = hex[*s >> 4];
+	    esc[5] = hex[*s & 0xf];
+	    json_append(esc, 6);
+	}
+    }
+    json_append((const char *)run, s - run);
+    json_append(JSON_LIT("\""));
+}
+
+void json_write(struct parent_msg *msg, const uint16_t holdtime) {
+    char num[64];
+    int len, i;
+
+    if (json_host) {
+	json_append(JSON_LIT("{\"host\":"));
+	json_string(json_host);
+	json_append(JSON_LIT(",\"interface\":"));
+    } else {
+	json_append(JSON_LIT("{\"interface\":"));
+    }
+    json_string(msg->name);
+    len = snprintf(num, sizeof(num), ",\"ifindex\":%" PRIu32, msg->index);
+    json_append(num, len);
+    json_append(JSON_LIT(",\"protocol\":"));
+    json_string(protos[msg->proto].name);
+
+    for (i = 0; i < PEER_MAX; i++) {
+	if (!msg->peer[i])
+	    continue;
+	json_append(JSON_LIT(",\""));
+	json_append(json_keys[i], strlen(json_keys[i]));
+	json_append(JSON_LIT("\":"));
+	json_string(msg->peer[i]);
+    }
+
+    len = snprintf(num, sizeof(num),
+	",\"ttl\":%" PRIu16 ",\"holdtime\":%" PRIu16, msg->ttl, holdtime);
+    json_append(num, len);
+    if (watch) {
+	json_append(JSON_LIT(",\"event\":"));
+	json_string(events[event]);
+    }
+    json_append(JSON_LIT("}\n"));
+
+    // watchers expect every event right away
+    if (watch)
+	json_flush();
+}
+
+static void json_output(const char *buf, size_t len) {
+    ssize_t ret;
+
+    while (len) {
+	ret = write(STDOUT_FILENO, buf, len);
+	if (ret == -1) {
+	    if (errno == EINTR)
+		continue;
+	    my_fatale("failed to write output");
+	}
+	buf += ret;
+	len -= ret;
+    }
+}
+
+void json_flush() {
+    json_sink(json_buf, json_len);
+    json_len = 0;
+}
+
 #if HAVE_EVHTTP_H
+static void http_url(const char *url) {
+    char *host, *path;
+
+    if (strncmp(url, "http://", 7) == 0)
+	url += 7;
+    host = my_strdup(url);
+    path = strchr(host, '/');
+    if (path) {
+	http_path = my_strdup(path);
+	*path = '\0';
+    } else {
+	http_path = my_strdup("/");
+    }
+    http_host = my_strdup(host);
+    free(host);
+}
+
 void http_connect() {
     struct servent *sp;
     struct hostent *hp;
@@ -354,7 +665,8 @@ void http_connect() {
     }
 
     // initalize the event library
-    event_init();
+    if (!http_base)
+	http_base = event_init();
 
     evcon = evhttp_connection_new(http_host, http_port);
     if (evcon == NULL)
@@ -427,6 +739,170 @@ void http_dispatch() {
     event_dispatch();
     evhttp_connection_free(evcon);
 }
+
+// collect neighbors as ndjson, posted in batches over a single connection
+void http_batch_init() {
+    http_connect();
+    json_sink = &http_batch_add;
+    json_host = hostname;
+}
+
+void http_batch_add(const char *buf, size_t len) {
+    if (!http_batch) {
+	http_batch = my_malloc(sizeof(struct http_batch));
+	if ((http_batch->body = evbuffer_new()) == NULL)
+	    my_fatal("failed to allocate HTTP batch");
+    }
+    if (evbuffer_add(http_batch->body, buf, len) == -1)
+	my_fatal("failed to allocate HTTP batch");
+}
+
+void http_batch_write(struct parent_msg *msg, const uint16_t holdtime) {
+    json_write(msg, holdtime);
+    json_flush();
+
+    if (++http_batch->count >= http_batch_max)
+	http_batch_close();
+}
+
+#ifdef HAVE_LIBZ
+static void http_batch_gzip(struct http_batch *batch) {
+    z_stream zs = {};
+    struct evbuffer *body;
+    unsigned char buf[16384];
+    int ret;
+
+    // windowBits + 16 selects the gzip format
+    if (deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8,
+		     Z_DEFAULT_STRATEGY) != Z_OK)
+	my_fatal("failed to initialize zlib");
+    if ((body = evbuffer_new()) == NULL)
+	my_fatal("failed to allocate HTTP batch");
+
+    zs.next_in = EVBUFFER_DATA(batch->body);
+    zs.avail_in = EVBUFFER_LENGTH(batch->body);
+    do {
+	zs.next_out = buf;
+	zs.avail_out = sizeof(buf);
+	ret = deflate(&zs, Z_FINISH);
+	evbuffer_add(body, buf, sizeof(buf) - zs.avail_out);
+    } while (ret == Z_OK);
+    deflateEnd(&zs);
+
+    if (ret != Z_STREAM_END)
+	my_fatal("failed to compress HTTP batch");
+
+    evbuffer_free(batch->body);
+    batch->body = body;
+}
+#endif /* HAVE_LIBZ */
+
+static void http_batch_close() {
+    if (!http_batch)
+	return;
+
+#ifdef HAVE_LIBZ
+    if (http_gzip)
+	http_batch_gzip(http_batch);
+#endif /* HAVE_LIBZ */
+
+    TAILQ_INSERT_TAIL(&http_batches, http_batch, entries);
+    http_batch = NULL;
+
+    // post it right away if the collector is idle
+    if (TAILQ_NEXT(TAILQ_FIRST(&http_batches), entries) == NULL) {
+	http_batch_send();
+	return;
+    }
+
+    // otherwise wait for the previous batch to limit the memory used
+    while (TAILQ_NEXT(TAILQ_FIRST(&http_batches), entries) != NULL)
+	event_loop(EVLOOP_ONCE);
+}
+
+static void http_batch_free(struct http_batch *batch) {
+    TAILQ_REMOVE(&http_batches, batch, entries);
+    evbuffer_free(batch->body);
+    free(batch);
+}
+
+static void http_batch_send() {
+    struct http_batch *batch = TAILQ_FIRST(&http_batches);
+    struct evhttp_request *req = NULL;
+
+    req = evhttp_request_new(http_batch_reply, batch);
+    if (req == NULL)
+	my_fatal("failed to allocate HTTP request");
+
+    evhttp_add_header(req->output_headers, "Host", http_host);
+    evhttp_add_header(req->output_headers, "User-Agent", 
+		PACKAGE_CLI "/" PACKAGE_VERSION);
+    evhttp_add_header(req->output_headers, "Content-Type",
+		"application/x-ndjson");
+    if (http_gzip)
+	evhttp_add_header(req->output_headers, "Content-Encoding", "gzip");
+
+    // the batch is kept for retries
+    evbuffer_add(req->output_buffer, EVBUFFER_DATA(batch->body),
+		 EVBUFFER_LENGTH(batch->body));
+
+    if (evhttp_make_request(evcon, req, EVHTTP_REQ_POST, http_path) == -1)
+	my_fatal("failed to create HTTP request");
+    batch->tries++;
+}
+
+static void http_batch_retry(int __unused(fd), short __unused(event),
+			     void __unused(*arg)) {
+    http_batch_send();
+}
+
+// connection failures and server errors are retried with a backoff,
+// other errors are final. either way the next batch is posted after
+void http_batch_reply(struct evhttp_request *req, void *arg) {
+    struct http_batch *batch = arg;
+    struct timeval tv;
+    uint32_t delay;
+
+    if ((req == NULL) || (req->response_code == 0) ||
+	(req->response_code >= 500)) {
+	if (batch->tries > HTTP_RETRIES) {
+	    my_log(CRIT, "HTTP batch failed after %" PRIu8 " attempts",
+		   batch->tries);
+	    status = EXIT_FAILURE;
+	    goto next;
+	}
+
+	delay = http_retry_ms << (batch->tries - 1);
+	tv.tv_sec = delay / 1000;
+	tv.tv_usec = (delay % 1000) * 1000;
+	my_log(INFO, "HTTP batch failed, retrying in %" PRIu32 " ms", delay);
+	evtimer_set(&http_retry_ev, http_batch_retry, NULL);
+	evtimer_add(&http_retry_ev, &tv);
+	return;
+    }
+
+    if (req->response_code >= HTTP_BADREQUEST) {
+	my_log(CRIT, "HTTP error %d received", req->response_code);
+	status = EXIT_FAILURE;
+    }
+
+next:
+    http_batch_free(batch);
+    if (!TAILQ_EMPTY(&http_batches))
+	http_batch_send();
+}
+
+void http_batch_dispatch() {
+
+    http_batch_close();
+
+    // wait for the remaining batches
+    while (!TAILQ_EMPTY(&http_batches))
+	event_loop(EVLOOP_ONCE);
+
+    evhttp_connection_free(evcon);
+    evcon = NULL;
+}
 #endif /* HAVE_EVHTTP_H */
 
 __noreturn
@@ -443,9 +919,16 @@ static void usage() {
 	    "\t-b = Print scriptable output\n"
 	    "\t-d = Dump pcap-compatible packets to stdout\n"
 	    "\t-f = Print full decode\n"
+	    "\t-j = Print one JSON object per neighbor\n"
 	    "\t-o = Decode only one packet\n"
+	    "\t-w = Watch for neighbor changes\n"
 #if HAVE_EVHTTP_H
 	    "\t-p <url> = Post decode to url\n"
+	    "\t-P <url> = Post all neighbors to url as NDJSON batches\n"
+	    "\t-n <count> = Maximum number of neighbors per batch\n"
+#ifdef HAVE_LIBZ
+	    "\t-z = Compress batches with gzip\n"
+#endif /* HAVE_LIBZ */
 #endif /* HAVE_EVHTTP_H */
 	    "\t-v = Increase logging verbosity\n"
 	    "\t-h = Print this message\n",
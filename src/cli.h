@@ -20,24 +20,39 @@
 #ifndef _cli_h
 #define _cli_h
 
+// batched posts
+#define HTTP_BATCH_MAX	1000
+#define HTTP_RETRIES	3
+#define HTTP_RETRY_MS	1000
+
 struct mode {
     void (*init) ();
     void (*write) (struct parent_msg *, const uint16_t);
     void (*dispatch) ();
+    uint16_t fields;
 };
 
+ssize_t cli_recv(int fd, struct peer_record *, int type);
+int cli_record(struct peer_record *, size_t len, struct parent_msg *);
 void batch_write(struct parent_msg *msg, const uint16_t);
 void cli_header();
 void cli_write(struct parent_msg *msg, const uint16_t);
 void debug_header();
 void debug_write(struct parent_msg *msg, const uint16_t);
 void debug_close();
+void json_write(struct parent_msg *msg, const uint16_t);
+void json_flush();
 
 #if HAVE_EVHTTP_H
 void http_connect();
 void http_request(struct parent_msg *msg, const uint16_t);
 void http_reply(struct evhttp_request *req, void *arg);
 void http_dispatch();
+void http_batch_init();
+void http_batch_add(const char *, size_t);
+void http_batch_write(struct parent_msg *msg, const uint16_t);
+void http_batch_reply(struct evhttp_request *req, void *arg);
+void http_batch_dispatch();
 #endif /* HAVE_EVHTTP_H */
 
 #endif /* _cli_h */
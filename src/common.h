@@ -89,6 +89,11 @@
 # define likely(x)	(x)
 # define unlikely(x)	(x)
 #endif
+// compile time assertions, like CTASSERT on the BSDs
+#define my_ctassert(x)		my_ctassert_(x, __LINE__)
+#define my_ctassert_(x, y)	my_ctassert__(x, y)
+#define my_ctassert__(x, y)	\
+    typedef char my_ctassert_ ## y[(x) ? 1 : -1] __attribute__((__unused__))
 
 #include "ether.h"
 #include "compat/compat.h"
@@ -110,6 +115,22 @@
 
 #define NETIF_INDEX_MAX		UINT32_MAX
 
+#define NETIF_HASH_INDEX	0
+#define NETIF_HASH_NAME		1
+#define NETIF_HASH_ADDR		2
+#define NETIF_HASH_KEYS		3
+#define NETIF_HASH_MIN		64
+
+// encoded frames per proto, tagged with the generation of their inputs.
+// indexed by protocol so it needs to cover PROTO_MAX, see child.c
+#define NETIF_FRAMES		8
+
+struct netif_frame {
+    uint32_t gen;
+    size_t len;
+    unsigned char buf[ETHER_MAX_LEN];
+};
+
 struct netif {
     uint32_t index;
     char name[IFNAMSIZ];
@@ -133,6 +154,7 @@ struct netif {
 
     uint16_t vlan_id; 
     uint32_t vlan_parent;
+    uint32_t master;
 
     uint8_t protos;
     uint8_t update;
@@ -143,12 +165,73 @@ struct netif {
     // should be last
     TAILQ_ENTRY(netif) entries;
 
-    uint8_t link_event;
+    // 802.1AB transmit state, see child_tx_run
+    uint8_t tx_credit;
+    uint8_t tx_fast;
+    time_t tx_refill;
+
     uint8_t device_identified;
     char device_name[IFDESCRSIZE];
+
+    // frame cache, see netif_gen
+    uint32_t gen;
+    struct netif *gen_input;
+    struct netif_frame *frames[NETIF_FRAMES];
+
+    // hashed index chains, see netif_list_rehash
+    struct netif *hnext[NETIF_HASH_KEYS];
+    uint32_t hkey[NETIF_HASH_KEYS];
+};
+
+struct netif_hash {
+    uint32_t size;
+    uint32_t count;
+    uint32_t gen;
+    struct netif **buckets[NETIF_HASH_KEYS];
+};
+
+// hardware facts which don't change for the life of an ifindex,
+// the alias and media are only cached while netlink events keep them current.
+// the type is recorded for interfaces which are down as well
+#define NETIF_FACT_DRIVER	(1 << 0)
+#define NETIF_FACT_DEVICE	(1 << 1)
+#define NETIF_FACT_DEVICE_ID	(1 << 2)
+#define NETIF_FACT_ALIAS	(1 << 3)
+#define NETIF_FACT_MEDIA	(1 << 4)
+#define NETIF_FACT_TYPE		(1 << 5)
+#define NETIF_FACT_ALL		0xff
+#define NETIF_FACTS_HASH	256
+
+struct netif_facts {
+    uint32_t index;
+    char name[IFNAMSIZ];
+    uint8_t valid;
+    int8_t type;
+    uint8_t device;
+    char driver[IFNAMSIZ];
+    char device_name[IFDESCRSIZE];
+    char alias[IFDESCRSIZE];
+
+    // media details, refreshed when the carrier changes
+    uint32_t carrier;
+    int8_t duplex;
+    int8_t autoneg_supported;
+    int8_t autoneg_enabled;
+    uint16_t autoneg_pmd;
+    uint16_t mau;
+
+    // should be last
+    uint32_t gen;
+    struct netif_facts *next;
 };
 
-TAILQ_HEAD(nhead, netif);
+// a TAILQ_HEAD with a hashed index by ifindex, name and hwaddr
+struct nhead {
+    struct netif *tqh_first;
+    struct netif **tqh_last;
+
+    struct netif_hash *hash;
+};
 
 struct exclif {
     char name[IFNAMSIZ];
@@ -227,12 +310,14 @@ struct my_sysinfo {
 #define OPT_IFDESCR	(1 << 11)
 #define OPT_USEDESCR	(1 << 12)
 #define OPT_CHASSIS_IF	(1 << 13)
+#define OPT_RING	(1 << 14)
 #define OPT_CHECK	(1 << 31)
 
 extern uint32_t options;
 
 struct parent_req {
     uint8_t op;
+    uint32_t id;
     uint32_t index;
     char name[IFNAMSIZ];
     ssize_t len;
@@ -247,9 +332,25 @@ struct parent_team_info {
     uint32_t netif_active;
 };
 
+// link settings as returned by ETHTOOL_GLINKSETTINGS,
+// the masks use the ETHTOOL_LINK_MODE bit numbers
+#define PARENT_LINK_NWORDS 4
+struct parent_link_info {
+    uint32_t speed;
+    uint8_t duplex;
+    uint8_t port;
+    uint8_t autoneg;
+    uint32_t supported[PARENT_LINK_NWORDS];
+    uint32_t advertising[PARENT_LINK_NWORDS];
+};
+
 #define PARENT_REQ_MIN	    offsetof(struct parent_req, buf)
 #define PARENT_REQ_MAX	    sizeof(struct parent_req)
 #define PARENT_REQ_LEN(l)   PARENT_REQ_MIN + l
+// pipelined requests, the number in flight stays below the
+// default unix datagram queue length (net.unix.max_dgram_qlen)
+#define PARENT_REQ_QUEUE    128
+#define PARENT_REQ_BATCH    8
 
 #define DECODE_STR	1
 #define DECODE_PRINT	2
@@ -266,18 +367,19 @@ struct parent_team_info {
 #define PEER_DUPLEX	9				// added by James Gohl 18/02/2017
 #define PEER_VTP_MD	10				// added by James Gohl 18/02/2017
 #define PEER_MAX	11				// modified by James Gohl 18/02/2017
-#define PEER_STR(x,y)  ((x)?(free(y)):(x = y))
-
-static inline
-void peer_free(char *p[]) {
-    int s;
-    for (s = 0; s < PEER_MAX; s++) {
-	if (!p[s])
-	    continue;
-	free(p[s]);
-	p[s] = NULL;
-    }
-}
+// the first decoded value wins, later ones stay behind in the arena
+#define PEER_STR(x,y)  ((x)?(void)0:(void)(x = y))
+
+// decoded peer strings are allocated from a per-message arena,
+// which is rewound instead of freed when the message is decoded again
+#define PEER_ARENA_SIZE	512
+
+struct peer_arena {
+    struct peer_arena *next;
+    size_t size;
+    size_t used;
+    char buf[];
+};
 
 struct parent_msg {
     uint32_t index;
@@ -290,26 +392,175 @@ struct parent_msg {
     uint8_t decode;
     uint16_t ttl;
     char *peer[PEER_MAX];
+    struct peer_arena *arena;
+    struct peer_record *record;
 
-    uint8_t lock;
-
-    // should be last
+    // should be last, only followed by the mqueue index
     TAILQ_ENTRY(parent_msg) entries;
+
+    TAILQ_ENTRY(parent_msg) ientries;
+    struct parent_msg *hnext;
+    uint32_t hkey;
+    uint32_t hpos;
+
+    // held by the mqueue and cli snapshots
+    uint32_t refs;
+};
+
+// forget the decoded strings but keep the arena for the next decode
+static inline
+void peer_reset(struct parent_msg *msg) {
+    struct peer_arena *arena;
+
+    memset(msg->peer, 0, sizeof(msg->peer));
+    msg->record = NULL;
+    for (arena = msg->arena; arena != NULL; arena = arena->next)
+	arena->used = 0;
+}
+
+// control socket query, sent by the cli after connecting
+// the child returns a peer_record for every matching neighbor, watch
+// queries then stay subscribed to neighbor changes
+#define CLI_VERSION	2
+#define CLI_QUERY_MAX	64
+#define CLI_QUERY_WATCH	(1 << 0)
+#define CLI_FIELD(x)	(1 << (x))
+#define CLI_FIELD_FRAME	CLI_FIELD(PEER_MAX)
+#define CLI_FIELDS_PEER	(CLI_FIELD(PEER_MAX) - 1)
+
+struct cli_query {
+    uint8_t version;
+    uint8_t proto;	// mask of (1 << PROTO_*)
+    uint16_t fields;	// mask of CLI_FIELD(PEER_*) and CLI_FIELD_FRAME
+    uint16_t flags;	// mask of CLI_QUERY_*
+    uint16_t count;	// number of ifindexes, 0 for all
+    uint32_t index[CLI_QUERY_MAX];
+};
+
+#define CLI_QUERY_LEN(c)    (offsetof(struct cli_query, index) + \
+			    (c) * sizeof(uint32_t))
+
+// pre-decoded neighbor record, rendered into the peer arena by peer_record
+// the peer fields are offsets of nul-terminated strings, 0 when missing,
+// the raw frame is only included when requested
+// records sent to watch sessions carry a CLI_EVENT_*, the sync and overflow
+// markers are header-only
+#define CLI_EVENT_NONE	    0	// initial snapshot
+#define CLI_EVENT_ADD	    1
+#define CLI_EVENT_CHANGE    2
+#define CLI_EVENT_REMOVE    3
+#define CLI_EVENT_SYNC	    4	// end of the snapshot
+#define CLI_EVENT_OVERFLOW  5	// events were dropped, a new snapshot follows
+#define CLI_EVENT_MAX	    6
+
+#define PEER_RECORD_MAX	4096
+#define PEER_RECORD_MIN	offsetof(struct peer_record, data)
+
+struct peer_record {
+    uint16_t len;
+    uint16_t holdtime;
+    uint32_t index;
+    char name[IFNAMSIZ];
+    uint8_t proto;
+    uint8_t event;
+    uint16_t ttl;
+    time_t received;
+    uint16_t peer[PEER_MAX];
+    uint16_t frame;
+    uint16_t frame_len;
+    char data[];
+};
+
+#define MQUEUE_HASH_MIN	64
+
+// per-interface neighbor list
+struct mqueue_if {
+    uint32_t index;
+    uint32_t count;
+    struct mqueue_if *next;
+    TAILQ_HEAD(, parent_msg) msgs;
+};
+
+struct mqueue_index {
+    // messages by (ifindex, proto, src)
+    uint32_t size;
+    uint32_t count;
+    struct parent_msg **buckets;
+
+    // interfaces by ifindex
+    uint32_t isize;
+    uint32_t icount;
+    struct mqueue_if **ibuckets;
+
+    // min-heap ordered by expiry
+    uint32_t hcount;
+    struct parent_msg **heap;
 };
 
-TAILQ_HEAD(mhead, parent_msg);
+// immutable list of queued messages, see mqueue_snapshot
+struct mqueue_snap {
+    uint32_t refs;
+    uint32_t gen;
+    uint32_t count;
+    struct parent_msg *msgs[];
+};
+
+// memory-mappable neighbor snapshot, two alternating slots each described
+// by a header at the start of the file, followed by the 8-aligned records
+// with the raw frames, see mqueue_save
+#define MQUEUE_FILE_MAGIC	0x6c616476
+#define MQUEUE_FILE_VERSION	2
+#define MQUEUE_FILE_SLOTS	2
+#define MQUEUE_FILE_RECLEN(l)	\
+    ((offsetof(struct mqueue_file_rec, msg) + (l) + 7) & ~(size_t)7)
+
+struct mqueue_file {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t hdrlen;
+    uint32_t count;
+    uint32_t crc;	// crc-32 of the records
+    uint64_t size;	// length of the records
+    int64_t written;
+    uint64_t gen;	// the valid slot with the highest gen is loaded
+    uint64_t offset;	// start of the records
+};
+
+struct mqueue_file_rec {
+    uint16_t reclen;
+    uint16_t len;
+    uint32_t index;
+    int64_t received;
+    uint16_t ttl;
+    uint8_t proto;
+    char name[IFNAMSIZ];
+    uint8_t msg[];
+};
+
+// a TAILQ_HEAD with a neighbor index and expiry heap
+struct mhead {
+    struct parent_msg *tqh_first;
+    struct parent_msg **tqh_last;
+
+    struct mqueue_index *index;
+
+    // bumped on every change, the last snapshot is shared until then
+    uint32_t gen;
+    struct mqueue_snap *snap;
+};
 
 #define PARENT_MSG_MIN	    offsetof(struct parent_msg, msg)
 #define PARENT_MSG_MAX	    offsetof(struct parent_msg, decode)
 #define PARENT_MSG_SIZ	    sizeof(struct parent_msg)
 #define PARENT_MSG_LEN(l)   PARENT_MSG_MIN + l
+#define PARENT_MSG_BATCH    32
 #define PARENT_OPEN	    0
 #define PARENT_CLOSE	    1
 #define PARENT_DESCR	    2
 #define PARENT_ALIAS	    3
 #define PARENT_DEVICE	    4
 #define PARENT_DEVICE_ID    5
-#define PARENT_ETHTOOL_GSET 6
+#define PARENT_ETHTOOL_GLINK 6
 #define PARENT_ETHTOOL_GDRV 7
 #define PARENT_TEAMNL	    8
 #define PARENT_MAX	    9
@@ -324,6 +575,10 @@ struct proto {
 			    struct my_sysinfo *);
     unsigned char * (* const check) (void *, size_t);
     size_t (* const decode) (struct parent_msg *);
+    // frames which differ on every build can't be cached
+    const uint8_t uncached;
+    // received frames per second per interface, see parent_recv_limit
+    uint16_t rate;
 };
 
 void cli_main(int argc, char *argv[]) __noreturn;
@@ -334,6 +589,18 @@ void parent_signal(int fd, short event, void *pid);
 void sysinfo_fetch(struct my_sysinfo *);
 void netif_init();
 uint16_t netif_fetch(int ifc, char *ifl[], struct my_sysinfo *, struct nhead *);
+uint16_t netif_valid(int ifc, char *ifl[], struct my_sysinfo *, struct nhead *);
+struct netif_facts *netif_facts(uint32_t index, const char *name);
+void netif_facts_forget(uint32_t index, uint8_t facts);
+
+#if defined(HAVE_LIBMNL) && HAVE_DECL_IFLA_BOND_SLAVE_STATE
+#define HAVE_NETIF_EVENTS   1
+#define NETIF_EVENT_UPDATE  (1 << 0)
+#define NETIF_EVENT_ADDRS   (1 << 1)
+struct nlmsghdr;
+int netif_event(const struct nlmsghdr *, struct my_sysinfo *, struct nhead *);
+#endif
+void netif_media_prefetch(struct netif *);
 int netif_media(struct netif *);
 
 #endif /* _common_h */
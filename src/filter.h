@@ -25,92 +25,10 @@ static struct bpf_insn reject_filter[] = {
     BPF_STMT(BPF_RET+BPF_K, 0)
 };
 
-static struct bpf_insn proto_filter[] = {
-    // .1q vlan header
-    BPF_STMT(BPF_LD+BPF_H+BPF_ABS, ETHER_ADDR_LEN * 2),
-    BPF_JUMP(BPF_JMP+BPF_JEQ+BPF_K, ETHERTYPE_VLAN, 0, 1),
-    BPF_STMT(BPF_LDX+BPF_W+BPF_IMM, ETHER_VLAN_ENCAP_LEN),
-
-    // lldp
-    // ether 01:80:c2:00:00:0e
-    BPF_STMT(BPF_LD+BPF_W+BPF_ABS, 0),
-    BPF_JUMP(BPF_JMP+BPF_JEQ+BPF_K, 0x0180C200, 0, 5),
-    BPF_STMT(BPF_LD+BPF_H+BPF_ABS, 4),
-    BPF_JUMP(BPF_JMP+BPF_JEQ+BPF_K, 0x0000000E, 0, 3),
-    // ether proto 
-    BPF_STMT(BPF_LD+BPF_H+BPF_IND, ETHER_ADDR_LEN * 2),
-    BPF_JUMP(BPF_JMP+BPF_JEQ+BPF_K, ETHERTYPE_LLDP, 0, 1),
-    // accept
-    BPF_STMT(BPF_RET+BPF_K, (u_int)-1),
-
-    // llc dsap & ssap
-    BPF_STMT(BPF_LD+BPF_H+BPF_IND, ETHER_HDR_LEN),
-    BPF_JUMP(BPF_JMP+BPF_JEQ+BPF_K, 0xAAAA, 1, 0),
-    // reject
-    BPF_STMT(BPF_RET+BPF_K, 0),
-
-    // cdp
-    // ether dst 01:00:0c:cc:cc:cc
-    BPF_STMT(BPF_LD+BPF_W+BPF_ABS, 0),
-    BPF_JUMP(BPF_JMP+BPF_JEQ+BPF_K, 0x01000CCC, 0, 7),
-    BPF_STMT(BPF_LD+BPF_H+BPF_ABS, 4),
-    BPF_JUMP(BPF_JMP+BPF_JEQ+BPF_K, 0x0000CCCC, 0, 5),
-    // llc control + org
-    BPF_STMT(BPF_LD+BPF_W+BPF_IND, ETH_LLC_CONTROL),
-    BPF_JUMP(BPF_JMP+BPF_JEQ+BPF_K, 0x0300000C, 0, 3),
-    // llc protoid
-    BPF_STMT(BPF_LD+BPF_H+BPF_IND, ETH_LLC_PROTOID),
-    BPF_JUMP(BPF_JMP+BPF_JEQ+BPF_K, LLC_PID_CDP, 0, 1),
-    // accept
-    BPF_STMT(BPF_RET+BPF_K, (u_int)-1),
-
-    // edp
-    // ether dst 00:0e:2b:cc:cc:cc
-    BPF_STMT(BPF_LD+BPF_W+BPF_ABS, 0),
-    BPF_JUMP(BPF_JMP+BPF_JEQ+BPF_K, 0x000E2B00, 0, 7),
-    BPF_STMT(BPF_LD+BPF_H+BPF_ABS, 4),
-    BPF_JUMP(BPF_JMP+BPF_JEQ+BPF_K, 0x00000000, 0, 5),
-    // llc control + org
-    BPF_STMT(BPF_LD+BPF_W+BPF_IND, ETH_LLC_CONTROL),
-    BPF_JUMP(BPF_JMP+BPF_JEQ+BPF_K, 0x03000E2B, 0, 3),
-    // llc protoid
-    BPF_STMT(BPF_LD+BPF_H+BPF_IND, ETH_LLC_PROTOID),
-    BPF_JUMP(BPF_JMP+BPF_JEQ+BPF_K, LLC_PID_EDP, 0, 1),
-    // accept
-    BPF_STMT(BPF_RET+BPF_K, (u_int)-1),
-
-    // fdp
-    // ether dst 01:e0:52:cc:cc:cc
-    BPF_STMT(BPF_LD+BPF_W+BPF_ABS, 0),
-    BPF_JUMP(BPF_JMP+BPF_JEQ+BPF_K, 0x01E052CC, 0, 7),
-    BPF_STMT(BPF_LD+BPF_H+BPF_ABS, 4),
-    BPF_JUMP(BPF_JMP+BPF_JEQ+BPF_K, 0x0000CCCC, 0, 5),
-    // llc control + org
-    BPF_STMT(BPF_LD+BPF_W+BPF_IND, ETH_LLC_CONTROL),
-    BPF_JUMP(BPF_JMP+BPF_JEQ+BPF_K, 0x0300E052, 0, 3),
-    // llc protoid
-    BPF_STMT(BPF_LD+BPF_H+BPF_IND, ETH_LLC_PROTOID),
-    BPF_JUMP(BPF_JMP+BPF_JEQ+BPF_K, LLC_PID_FDP, 0, 1),
-    // accept
-    BPF_STMT(BPF_RET+BPF_K, (u_int)-1),
-
-    // ndp
-    // ether dst 01:00:81:00:01:00
-    BPF_STMT(BPF_LD+BPF_W+BPF_ABS, 0),
-    BPF_JUMP(BPF_JMP+BPF_JEQ+BPF_K, 0x01008100, 0, 7),
-    BPF_STMT(BPF_LD+BPF_H+BPF_ABS, 4),
-    BPF_JUMP(BPF_JMP+BPF_JEQ+BPF_K, 0x00000100, 0, 5),
-    // llc control + org
-    BPF_STMT(BPF_LD+BPF_W+BPF_IND, ETH_LLC_CONTROL),
-    BPF_JUMP(BPF_JMP+BPF_JEQ+BPF_K, 0x03000081, 0, 3),
-    // llc protoid
-    BPF_STMT(BPF_LD+BPF_H+BPF_IND, ETH_LLC_PROTOID),
-    BPF_JUMP(BPF_JMP+BPF_JEQ+BPF_K, LLC_PID_NDP_HELLO, 0, 1),
-    // accept
-    BPF_STMT(BPF_RET+BPF_K, (u_int)-1),
-
-    // reject
-    BPF_STMT(BPF_RET+BPF_K, 0)
-};
+// multicast destinations and llc orgs as filter constants
+#define FILTER_W(a)	((uint32_t)(a)[0] << 24 | (a)[1] << 16 | \
+			 (a)[2] << 8 | (a)[3])
+#define FILTER_H(a)	((a)[0] << 8 | (a)[1])
+#define FILTER_ORG(a)	(0x03000000 | (a)[0] << 16 | (a)[1] << 8 | (a)[2])
 
 #endif /* _filter_h */
@@ -32,6 +32,7 @@ extern struct ehead exclifs;
 extern char *__progname;
 
 static void usage() __noreturn;
+static int rate_parse(char *);
 
 int main(int argc, char *argv[]) {
 
@@ -81,11 +82,17 @@ int main(int argc, char *argv[]) {
     argv = sargv;
 #endif
 
-    while ((ch = getopt(argc, argv, "ade:fhm:noqrstu:vwyzc:l:LCEFN")) != -1) {
+    while ((ch = getopt(argc, argv, "ab:de:fhm:noqrRstu:vwyzc:l:LCEFN")) != -1) {
 	switch(ch) {
 	    case 'a':
 		options |= OPT_AUTO | OPT_RECV;
 		break;
+	    case 'b':
+		if (rate_parse(optarg) == EXIT_FAILURE) {
+		    my_log(CRIT, "invalid receive rate %s", optarg);
+		    usage();
+		}
+		break;
 	    case 'd':
 		options |= OPT_DEBUG;
 		options &= ~OPT_DAEMON;
@@ -132,6 +139,9 @@ int main(int argc, char *argv[]) {
 	    case 'r':
 		options |= OPT_RECV;
 		break;
+	    case 'R':
+		options |= OPT_RING;
+		break;
 	    case 's':
 		options &= ~OPT_SEND;
 		break;
@@ -288,6 +298,7 @@ static void usage() {
     fprintf(stderr, PACKAGE_NAME " version " PACKAGE_VERSION "\n" 
 	"Usage: %s [-a] [INTERFACE] [INTERFACE]\n"
 	    "\t-a = Auto-enable protocols based on received packets\n"
+	    "\t-b [<proto>=]<rate> = Received frames per second per interface\n"
 	    "\t-d = Dump pcap-compatible packets to stdout\n"
 	    "\t-e <interface> = Exclude this interface\n"
 	    "\t-f = Run in the foreground\n"
@@ -297,6 +308,7 @@ static void usage() {
 	    "\t-o = Run Once\n"
 	    "\t-q = Generate per-interface chassis-id values\n"
 	    "\t-r = Receive Packets\n"
+	    "\t-R = Receive via a shared packet ring (Linux)\n"
 	    "\t-s = Silent, don't transmit packets\n"
 	    "\t-t = Use Tun/Tap interfaces\n"
 	    "\t-u <user> = Setuid User (defaults to " PACKAGE_USER ")\n"
@@ -318,3 +330,33 @@ static void usage() {
     exit(EXIT_FAILURE);
 }
 
+// receive rate limit for all or a single protocol
+static int rate_parse(char *arg) {
+    char *sep, *end;
+    unsigned long rate;
+    int p, r, found = 0;
+
+    if ((sep = strchr(arg, '=')) != NULL)
+	*sep++ = '\0';
+    else
+	sep = arg;
+
+    errno = 0;
+    rate = strtoul(sep, &end, 10);
+    if ((errno != 0) || (*sep == '\0') || (*end != '\0') ||
+	(rate == 0) || (rate > UINT16_MAX))
+	return(EXIT_FAILURE);
+
+    for (p = 0; protos[p].name != NULL; p++) {
+	if ((sep != arg) && (strcasecmp(arg, protos[p].name) != 0))
+	    continue;
+	// frames count against the first protocol using the address,
+	// see parent_recv_proto, so CDP1 limits CDP
+	for (r = 0; memcmp(protos[r].dst_addr, protos[p].dst_addr,
+			   ETHER_ADDR_LEN) != 0; r++);
+	protos[r].rate = rate;
+	found = 1;
+    }
+
+    return((found) ? EXIT_SUCCESS : EXIT_FAILURE);
+}
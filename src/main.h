@@ -27,7 +27,7 @@ struct proto protos[] = {
   { 0, "CDP",  CDP_MULTICAST_ADDR, LLC_ORG_CISCO, LLC_PID_CDP,
     &cdp_packet, &cdp_check, &cdp_decode },
   { 0, "EDP",  EDP_MULTICAST_ADDR, LLC_ORG_EXTREME, LLC_PID_EDP,
-    &edp_packet, &edp_check, &edp_decode },
+    &edp_packet, &edp_check, &edp_decode, 1 },
   { 0, "FDP",  FDP_MULTICAST_ADDR, LLC_ORG_FOUNDRY, LLC_PID_FDP,
     &fdp_packet, &fdp_check, &fdp_decode },
   { 0, "NDP",  NDP_MULTICAST_ADDR, LLC_ORG_NORTEL, LLC_PID_NDP_HELLO,
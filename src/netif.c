@@ -58,7 +58,13 @@
 
 static int sockfd = -1;
 
+// static hardware facts, hashed by ifindex
+static struct netif_facts *facts[NETIF_FACTS_HASH];
+static uint32_t facts_gen = 0;
+
 static void netif_addrs(struct ifaddrs *, struct nhead *, struct my_sysinfo *);
+static void netif_forget(struct nhead *, struct my_sysinfo *, struct netif *);
+static void netif_facts_expire();
 
 #if defined(NETIF_LINUX)
 #include "netif_linux.c"
@@ -77,10 +83,10 @@ uint16_t netif_fetch(int ifc, char *ifl[], struct my_sysinfo *sysinfo,
 
     struct ifaddrs *ifaddrs, *ifaddr = NULL;
     struct ifreq ifr;
-    int count = 0;
     int type, enabled;
     uint32_t index;
     struct parent_req mreq = {};
+    struct netif_facts *nfacts;
 
 #ifdef AF_PACKET
     struct sockaddr_ll saddrll;
@@ -99,9 +105,6 @@ uint16_t netif_fetch(int ifc, char *ifl[], struct my_sysinfo *sysinfo,
 	return(0);
     }
 
-    // zero
-    count = 0;
-
     // unset all but CAP_HOST and CAP_ROUTER
     sysinfo->cap &= (CAP_HOST|CAP_ROUTER);
     sysinfo->cap_active &= (CAP_HOST|CAP_ROUTER);
@@ -112,6 +115,23 @@ uint16_t netif_fetch(int ifc, char *ifl[], struct my_sysinfo *sysinfo,
     TAILQ_FOREACH(netif, netifs, entries) {
 	netif->type = NETIF_OLD;
     }
+    facts_gen++;
+
+    // ask the parent about all interfaces at once
+    for (ifaddr = ifaddrs; ifaddr != NULL; ifaddr = ifaddr->ifa_next) {
+	if ((ifaddr->ifa_addr == NULL) ||
+	    (ifaddr->ifa_addr->sa_family != NETIF_AF))
+	    continue;
+#ifdef AF_PACKET
+	memcpy(&saddrll, ifaddr->ifa_addr, sizeof(saddrll));
+	if (saddrll.sll_hatype == ARPHRD_ETHER)
+	    netif_prefetch(saddrll.sll_ifindex, ifaddr);
+#elif defined(AF_LINK)
+	memcpy(&saddrdl, ifaddr->ifa_addr, sizeof(saddrdl));
+	netif_prefetch(saddrdl.sdl_index, ifaddr);
+#endif
+    }
+    my_mreq_flush();
 
     for (ifaddr = ifaddrs; ifaddr != NULL; ifaddr = ifaddr->ifa_next) {
 
@@ -160,6 +180,11 @@ uint16_t netif_fetch(int ifc, char *ifl[], struct my_sysinfo *sysinfo,
 	// detect interface type
 	type = netif_type(sockfd, index, ifaddr, &ifr);
 
+	// netif_event_sysinfo counts the interfaces which are down via this
+	nfacts = netif_facts(index, ifaddr->ifa_name);
+	nfacts->type = type;
+	nfacts->valid |= NETIF_FACT_TYPE;
+
 	if (type == NETIF_REGULAR) { 
 	    my_log(INFO, "found ethernet interface %s", ifaddr->ifa_name);
 	    sysinfo->physif_count++;
@@ -197,7 +222,7 @@ uint16_t netif_fetch(int ifc, char *ifl[], struct my_sysinfo *sysinfo,
 	// fetch / create netif
 	if ((netif = netif_byindex(netifs, index)) == NULL) {
 	    netif = my_malloc(sizeof(struct netif));
-	    TAILQ_INSERT_TAIL(netifs, netif, entries);
+	    netif_list_insert(netifs, netif);
 	} else {
 	    // reset everything up to the tailq_entry but keep protos
 	    uint16_t protos = netif->protos;
@@ -209,13 +234,22 @@ uint16_t netif_fetch(int ifc, char *ifl[], struct my_sysinfo *sysinfo,
 	netif->index = index;
 	strlcpy(netif->name, ifaddr->ifa_name, sizeof(netif->name));
 	netif->type = type;
+	netif_list_rehash(netifs, netif);
 
 #ifdef HAVE_SYSFS
-	mreq.op = PARENT_ALIAS;
-	mreq.index = netif->index;
+	nfacts = netif_facts(index, netif->name);
 
-	if (my_mreq(&mreq))
-	    strlcpy(netif->description, mreq.buf, IFDESCRSIZE);
+	if (!(nfacts->valid & NETIF_FACT_ALIAS)) {
+	    memset(&mreq, 0, PARENT_REQ_MAX);
+	    mreq.op = PARENT_ALIAS;
+	    mreq.index = netif->index;
+
+	    memset(nfacts->alias, 0, IFDESCRSIZE);
+	    if (my_mreq(&mreq))
+		strlcpy(nfacts->alias, mreq.buf, IFDESCRSIZE);
+	    nfacts->valid |= NETIF_FACT_ALIAS;
+	}
+	strlcpy(netif->description, nfacts->alias, IFDESCRSIZE);
 #elif defined(SIOCGIFDESCR)
 #ifndef __FreeBSD__
 	ifr.ifr_data = (caddr_t)&netif->description;
@@ -228,26 +262,13 @@ uint16_t netif_fetch(int ifc, char *ifl[], struct my_sysinfo *sysinfo,
 
 	if (sysinfo->mifname && (strcmp(netif->name, sysinfo->mifname) == 0))
 	    sysinfo->mnetif = netif;
-
-	// update counters
-	count++;
     }
 
     // remove old interfaces
     TAILQ_FOREACH_SAFE(netif, netifs, entries, n_netif) {
 	if (netif->type != NETIF_OLD)
 	    continue;
-
-	my_log(INFO, "removing old interface %s", netif->name);
-
-	mreq.op = PARENT_CLOSE;
-	mreq.index = netif->index;
-	my_mreq(&mreq);
-
-	TAILQ_REMOVE(netifs, netif, entries);
-	if (sysinfo->mnetif == netif)
-	    sysinfo->mnetif = NULL;
-	free(netif);
+	netif_forget(netifs, sysinfo, netif);
     }
 
     // add child subif lists to each bond/bridge
@@ -285,10 +306,22 @@ uint16_t netif_fetch(int ifc, char *ifl[], struct my_sysinfo *sysinfo,
     if ((netif = TAILQ_FIRST(netifs)) != NULL)
 	memcpy(&sysinfo->hwaddr, &netif->hwaddr, ETHER_ADDR_LEN);
 
-    // validate detected interfaces
-    if (ifc > 0) {
-	count = 0;
+    // cleanup
+    freeifaddrs(ifaddrs);
+    my_mreq_drop();
+    netif_facts_expire();
+
+    return(netif_valid(ifc, ifl, sysinfo, netifs));
+};
 
+
+// validate the detected interfaces, returns the number of usable netifs
+uint16_t netif_valid(int ifc, char *ifl[], struct my_sysinfo *sysinfo,
+		    struct nhead *netifs) {
+    struct netif *netif;
+    uint16_t count = 0;
+
+    if (ifc > 0) {
 	for (int j = 0; j < ifc; j++) {
 	    netif = netif_byname(netifs, ifl[j]);
 	    if (netif == NULL) {
@@ -303,18 +336,112 @@ uint16_t netif_fetch(int ifc, char *ifl[], struct my_sysinfo *sysinfo,
 	if (count != ifc)
 	    count = 0;
 
-    } else if (count == 0) {
-	my_log(CRIT, "no valid interface found");
+    } else {
+	TAILQ_FOREACH(netif, netifs, entries)
+	    count++;
+	if (count == 0)
+	    my_log(CRIT, "no valid interface found");
     }
 
     if ((options & OPT_MNETIF) && !sysinfo->mnetif)
 	my_log(CRIT, "could not detect the specified management interface");
 
-    // cleanup
-    freeifaddrs(ifaddrs);
-
     return(count);
-};
+}
+
+
+// returns the cached facts for an ifindex, a different name
+// means the ifindex was reused (or renamed) and resets them
+struct netif_facts *netif_facts(uint32_t index, const char *name) {
+    struct netif_facts *nfacts = facts[index % NETIF_FACTS_HASH];
+
+    for (; nfacts != NULL; nfacts = nfacts->next) {
+	if (nfacts->index == index)
+	    break;
+    }
+
+    if (nfacts == NULL) {
+	nfacts = my_malloc(sizeof(struct netif_facts));
+	nfacts->next = facts[index % NETIF_FACTS_HASH];
+	facts[index % NETIF_FACTS_HASH] = nfacts;
+    } else if (strncmp(nfacts->name, name, IFNAMSIZ) != 0) {
+	my_log(INFO, "resetting cached facts for %s", name);
+	memset(nfacts, 0, offsetof(struct netif_facts, gen));
+    }
+
+    nfacts->index = index;
+    strlcpy(nfacts->name, name, sizeof(nfacts->name));
+    nfacts->gen = facts_gen;
+
+    return(nfacts);
+}
+
+// invalidate facts, NETIF_INDEX_MAX matches all interfaces
+void netif_facts_forget(uint32_t index, uint8_t mask) {
+    struct netif_facts **nfacts, *dfacts;
+    int i = 0, last = NETIF_FACTS_HASH;
+
+    if (index != NETIF_INDEX_MAX) {
+	i = index % NETIF_FACTS_HASH;
+	last = i + 1;
+    }
+
+    for (; i < last; i++) {
+	for (nfacts = &facts[i]; *nfacts != NULL; ) {
+	    if ((index != NETIF_INDEX_MAX) && ((*nfacts)->index != index)) {
+		nfacts = &(*nfacts)->next;
+		continue;
+	    }
+
+	    (*nfacts)->valid &= ~mask;
+	    if ((*nfacts)->valid) {
+		nfacts = &(*nfacts)->next;
+		continue;
+	    }
+
+	    dfacts = *nfacts;
+	    *nfacts = dfacts->next;
+	    free(dfacts);
+	}
+    }
+}
+
+// drop facts for interfaces which weren't seen during the last fetch
+static void netif_facts_expire() {
+    struct netif_facts **nfacts, *dfacts;
+
+    for (int i = 0; i < NETIF_FACTS_HASH; i++) {
+	for (nfacts = &facts[i]; *nfacts != NULL; ) {
+	    if ((*nfacts)->gen == facts_gen) {
+		nfacts = &(*nfacts)->next;
+		continue;
+	    }
+
+	    dfacts = *nfacts;
+	    *nfacts = dfacts->next;
+	    free(dfacts);
+	}
+    }
+}
+
+
+// remove a netif which went away
+static void netif_forget(struct nhead *netifs, struct my_sysinfo *sysinfo,
+			struct netif *netif) {
+    struct parent_req mreq = {};
+
+    my_log(INFO, "removing old interface %s", netif->name);
+
+    mreq.op = PARENT_CLOSE;
+    mreq.index = netif->index;
+    my_mreq(&mreq);
+
+    netif_list_remove(netifs, netif);
+    if (sysinfo->mnetif == netif)
+	sysinfo->mnetif = NULL;
+    netif_frames_free(netif);
+    free(netif);
+}
 
 
 // perform address detection for all netifs
@@ -389,6 +516,7 @@ static void netif_addrs(struct ifaddrs *ifaddrs, struct nhead *netifs,
 	    memcpy(&saddrll, ifaddr->ifa_addr, sizeof(saddrll));
 
 	    memcpy(&netif->hwaddr, &saddrll.sll_addr, ETHER_ADDR_LEN);
+	    netif_list_rehash(netifs, netif);
 #endif
 #ifdef AF_LINK
 	} else if (ifaddr->ifa_addr->sa_family == AF_LINK) {
@@ -397,6 +525,7 @@ static void netif_addrs(struct ifaddrs *ifaddrs, struct nhead *netifs,
 	    memcpy(&saddrdl, ifaddr->ifa_addr, sizeof(saddrdl));
 
 	    memcpy(&netif->hwaddr, LLADDR(&saddrdl), ETHER_ADDR_LEN);
+	    netif_list_rehash(netifs, netif);
 #endif
 	}
     }
@@ -414,6 +543,12 @@ static void netif_addrs(struct ifaddrs *ifaddrs, struct nhead *netifs,
 }
 
 
+// queue the parent requests made by netif_media
+void netif_media_prefetch(struct netif *netif) {
+    if (netif->type == NETIF_REGULAR)
+	netif_physical_prefetch(netif);
+}
+
 // perform media detection on physical interfaces
 int netif_media(struct netif *netif) {
 
@@ -77,6 +77,14 @@
 static int netif_wireless(int, struct ifaddrs *ifaddr, struct ifreq *);
 static void netif_driver(int, uint32_t index, struct ifreq *, char *, size_t);
 
+// no parent requests to queue, bsd uses ioctls
+static void netif_prefetch(uint32_t __unused(index),
+			   struct ifaddrs *__unused(ifaddr)) {
+}
+
+static void netif_physical_prefetch(struct netif *__unused(netif)) {
+}
+
 // detect interface type
 static int netif_type(int sockfd, uint32_t index,
 	struct ifaddrs *ifaddr, struct ifreq *ifr) {
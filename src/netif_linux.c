@@ -66,9 +66,57 @@
 #include <linux/wireless.h>
 #endif /* HAVE_LINUX_WIRELESS_H */
 
+#ifdef HAVE_NETIF_EVENTS
+#include <libmnl/libmnl.h>
+#include <linux/rtnetlink.h>
+#include <linux/if_link.h>
+#endif /* HAVE_NETIF_EVENTS */
+
 static int netif_wireless(int, struct ifaddrs *ifaddr, struct ifreq *);
 static void netif_driver(int, uint32_t index, struct ifreq *, char *, size_t);
 
+// queue the parent requests made by netif_type and netif_fetch
+static void netif_prefetch(uint32_t index, struct ifaddrs *ifaddr) {
+    struct netif_facts *nfacts = netif_facts(index, ifaddr->ifa_name);
+    struct parent_req mreq = {};
+
+    mreq.index = index;
+
+#if HAVE_LINUX_ETHTOOL_H
+    mreq.op = PARENT_ETHTOOL_GDRV;
+    mreq.len = sizeof(struct ethtool_drvinfo);
+    if (!(nfacts->valid & NETIF_FACT_DRIVER))
+	my_mreq_queue(&mreq);
+    mreq.len = 0;
+#endif /* HAVE_LINUX_ETHTOOL_H */
+
+#ifdef HAVE_SYSFS
+    mreq.op = PARENT_DEVICE;
+    if (!(nfacts->valid & NETIF_FACT_DEVICE))
+	my_mreq_queue(&mreq);
+    // the alias is only read for enabled interfaces
+    mreq.op = PARENT_ALIAS;
+    if (!(nfacts->valid & NETIF_FACT_ALIAS) && (ifaddr->ifa_flags & IFF_UP))
+	my_mreq_queue(&mreq);
+#endif /* HAVE_SYSFS */
+}
+
+// queue the parent requests made by netif_physical
+static void netif_physical_prefetch(struct netif *netif) {
+#if HAVE_LINUX_ETHTOOL_H
+    struct netif_facts *nfacts = netif_facts(netif->index, netif->name);
+    struct parent_req mreq = {};
+
+    if (nfacts->valid & NETIF_FACT_MEDIA)
+	return;
+
+    mreq.op = PARENT_ETHTOOL_GLINK;
+    mreq.index = netif->index;
+    mreq.len = sizeof(struct parent_link_info);
+    my_mreq_queue(&mreq);
+#endif /* HAVE_LINUX_ETHTOOL_H */
+}
+
 // detect interface type
 static int netif_type(int sockfd, uint32_t index,
 	struct ifaddrs *ifaddr, struct ifreq *ifr) {
@@ -90,12 +138,18 @@ static int netif_type(int sockfd, uint32_t index,
 	return(NETIF_WIRELESS);
 
 #ifdef HAVE_SYSFS
+    struct netif_facts *nfacts = netif_facts(index, ifaddr->ifa_name);
     struct parent_req mreq = {};
 
-    mreq.op = PARENT_DEVICE;
-    mreq.index = index;
+    if (!(nfacts->valid & NETIF_FACT_DEVICE)) {
+	mreq.op = PARENT_DEVICE;
+	mreq.index = index;
+
+	nfacts->device = (my_mreq(&mreq) != 0);
+	nfacts->valid |= NETIF_FACT_DEVICE;
+    }
 
-    if (my_mreq(&mreq))
+    if (nfacts->device)
 	return(NETIF_REGULAR);
 #endif /* HAVE_SYSFS */
 
@@ -144,22 +198,28 @@ static int netif_type(int sockfd, uint32_t index,
 static void netif_driver(int sockfd, uint32_t index, struct ifreq *ifr,
 		    char *dname, size_t len) {
 #if HAVE_LINUX_ETHTOOL_H
+    struct netif_facts *nfacts = netif_facts(index, ifr->ifr_name);
     struct parent_req mreq = {};
     struct ethtool_drvinfo drvinfo = {};
 
-    memset(dname, 0, len);
+    if (nfacts->valid & NETIF_FACT_DRIVER)
+	goto out;
+    nfacts->valid |= NETIF_FACT_DRIVER;
 
     mreq.op = PARENT_ETHTOOL_GDRV;
     mreq.index = index;
     mreq.len = sizeof(drvinfo);
 
     if (my_mreq(&mreq) != sizeof(drvinfo))
-	return;
+	goto out;
 
     // copy drvinfo struct
     memcpy(&drvinfo, mreq.buf, sizeof(drvinfo));
+    strlcpy(nfacts->driver, drvinfo.driver, sizeof(nfacts->driver));
 
-    strlcpy(dname, drvinfo.driver, len);
+out:
+    memset(dname, 0, len);
+    strlcpy(dname, nfacts->driver, len);
 #endif /* HAVE_LINUX_ETHTOOL_H */
 }
 
@@ -181,20 +241,22 @@ static int netif_wireless(int sockfd, struct ifaddrs *ifaddr, struct ifreq *ifr)
 
 static void netif_device_id(int sockfd, struct netif *netif, struct ifreq *ifr) {
 
-    if (netif->device_identified)
-	return;
-    netif->device_identified = 1;
-
 #if defined(HAVE_PCI_PCI_H)
+    struct netif_facts *nfacts = netif_facts(netif->index, netif->name);
     struct parent_req mreq = {};
 
-    mreq.op = PARENT_DEVICE_ID;
-    mreq.index = netif->index;
+    if (!(nfacts->valid & NETIF_FACT_DEVICE_ID)) {
+	mreq.op = PARENT_DEVICE_ID;
+	mreq.index = netif->index;
 
-    if (!my_mreq(&mreq))
-	return;
+	if (my_mreq(&mreq))
+	    strlcpy(nfacts->device_name, mreq.buf,
+		    sizeof(nfacts->device_name));
+	nfacts->valid |= NETIF_FACT_DEVICE_ID;
+    }
 
-    strlcpy(netif->device_name, mreq.buf, sizeof(netif->device_name));
+    strlcpy(netif->device_name, nfacts->device_name,
+	    sizeof(netif->device_name));
 #endif /* HAVE_PCI_PCI_H */
 }
 
@@ -363,12 +425,18 @@ static void netif_vlan(int sockfd, struct nhead *netifs, struct netif *vlan,
 
 
 
-// perform media detection on physical interfaces
-static void netif_physical(int sockfd, struct netif *netif) {
-
 #if HAVE_LINUX_ETHTOOL_H
-    struct ethtool_cmd ecmd;
+static inline int netif_link_mode(const uint32_t *mask, unsigned int bit) {
+    if (bit >= PARENT_LINK_NWORDS * 32)
+	return(0);
+    return((mask[bit / 32] & (1U << (bit % 32))) != 0);
+}
+
+// query the link settings via the parent
+static void netif_link(struct netif *netif) {
+    struct parent_link_info link;
     struct parent_req mreq = {};
+    uint32_t *modes;
 
     int ecmd_to_lldp_pmd[][2] = {
 	{ADVERTISED_10baseT_Half,   LLDP_MAU_PMD_10BASE_T},
@@ -388,32 +456,92 @@ static void netif_physical(int sockfd, struct netif *netif) {
 #endif
 #ifdef ADVERTISED_2500baseX_Full
 	{ADVERTISED_2500baseX_Full, LLDP_MAU_PMD_OTHER},
+#endif
+#ifdef ADVERTISED_10000baseKR_Full
+	{ADVERTISED_10000baseKX4_Full, LLDP_MAU_PMD_OTHER},
+	{ADVERTISED_10000baseKR_Full, LLDP_MAU_PMD_OTHER},
+#endif
+#ifdef ADVERTISED_40000baseLR4_Full
+	{ADVERTISED_40000baseKR4_Full, LLDP_MAU_PMD_OTHER},
+	{ADVERTISED_40000baseCR4_Full, LLDP_MAU_PMD_OTHER},
+	{ADVERTISED_40000baseSR4_Full, LLDP_MAU_PMD_OTHER},
+	{ADVERTISED_40000baseLR4_Full, LLDP_MAU_PMD_OTHER},
 #endif
 	{0, 0}
     };
 
-    mreq.op = PARENT_ETHTOOL_GSET;
+#if HAVE_DECL_ETHTOOL_LINK_MODE_10000BASEER_FULL_BIT
+    // link modes which identify the mau
+    const struct {
+	uint32_t speed;
+	unsigned int bit;
+	uint16_t mau;
+    } link_to_lldp_mau[] = {
+	{SPEED_10000, ETHTOOL_LINK_MODE_10000baseKX4_Full_BIT,
+	    LLDP_MAU_TYPE_10GBASE_KX4},
+	{SPEED_10000, ETHTOOL_LINK_MODE_10000baseKR_Full_BIT,
+	    LLDP_MAU_TYPE_10GBASE_KR},
+	{SPEED_10000, ETHTOOL_LINK_MODE_10000baseSR_Full_BIT,
+	    LLDP_MAU_TYPE_10GBASE_SR},
+	{SPEED_10000, ETHTOOL_LINK_MODE_10000baseLR_Full_BIT,
+	    LLDP_MAU_TYPE_10GBASE_LR},
+	{SPEED_10000, ETHTOOL_LINK_MODE_10000baseLRM_Full_BIT,
+	    LLDP_MAU_TYPE_10GBASE_LRM},
+	{SPEED_10000, ETHTOOL_LINK_MODE_10000baseER_Full_BIT,
+	    LLDP_MAU_TYPE_10GBASE_ER},
+	{SPEED_25000, ETHTOOL_LINK_MODE_25000baseCR_Full_BIT,
+	    LLDP_MAU_TYPE_25GBASE_CR},
+	{SPEED_25000, ETHTOOL_LINK_MODE_25000baseKR_Full_BIT,
+	    LLDP_MAU_TYPE_25GBASE_KR},
+	{SPEED_25000, ETHTOOL_LINK_MODE_25000baseSR_Full_BIT,
+	    LLDP_MAU_TYPE_25GBASE_SR},
+	{SPEED_40000, ETHTOOL_LINK_MODE_40000baseKR4_Full_BIT,
+	    LLDP_MAU_TYPE_40GBASE_KR4},
+	{SPEED_40000, ETHTOOL_LINK_MODE_40000baseCR4_Full_BIT,
+	    LLDP_MAU_TYPE_40GBASE_CR4},
+	{SPEED_40000, ETHTOOL_LINK_MODE_40000baseSR4_Full_BIT,
+	    LLDP_MAU_TYPE_40GBASE_SR4},
+	{SPEED_40000, ETHTOOL_LINK_MODE_40000baseLR4_Full_BIT,
+	    LLDP_MAU_TYPE_40GBASE_LR4},
+	{SPEED_100000, ETHTOOL_LINK_MODE_100000baseKR4_Full_BIT,
+	    LLDP_MAU_TYPE_100GBASE_KR4},
+	{SPEED_100000, ETHTOOL_LINK_MODE_100000baseSR4_Full_BIT,
+	    LLDP_MAU_TYPE_100GBASE_SR4},
+	{SPEED_100000, ETHTOOL_LINK_MODE_100000baseCR4_Full_BIT,
+	    LLDP_MAU_TYPE_100GBASE_CR4},
+	{SPEED_100000, ETHTOOL_LINK_MODE_100000baseLR4_ER4_Full_BIT,
+	    LLDP_MAU_TYPE_100GBASE_LR4},
+	{0, 0, 0}
+    };
+#endif /* HAVE_DECL_ETHTOOL_LINK_MODE_10000BASEER_FULL_BIT */
+
+    mreq.op = PARENT_ETHTOOL_GLINK;
     mreq.index = netif->index;
-    mreq.len = sizeof(ecmd);
+    mreq.len = sizeof(link);
 
-    if (my_mreq(&mreq) != sizeof(ecmd))
+    if (my_mreq(&mreq) != sizeof(link))
 	return;
 
-    // copy ecmd struct
-    memcpy(&ecmd, mreq.buf, sizeof(ecmd));
+    // copy link struct
+    memcpy(&link, mreq.buf, sizeof(link));
 
     // duplex
-    netif->duplex = (ecmd.duplex == DUPLEX_FULL);
+    netif->duplex = (link.duplex == DUPLEX_FULL);
 
     // autoneg
-    if (ecmd.supported & SUPPORTED_Autoneg) {
+    if (link.supported[0] & SUPPORTED_Autoneg) {
 	my_log(INFO, "autoneg supported on %s", netif->name);
 	netif->autoneg_supported = 1;
-	netif->autoneg_enabled = (ecmd.autoneg == AUTONEG_ENABLE);
+	netif->autoneg_enabled = (link.autoneg == AUTONEG_ENABLE);
 	for (int i=0; ecmd_to_lldp_pmd[i][0]; i++) {
-	    if (ecmd.advertising & ecmd_to_lldp_pmd[i][0])
+	    if (link.advertising[0] & ecmd_to_lldp_pmd[i][0])
 		netif->autoneg_pmd |= ecmd_to_lldp_pmd[i][1];
 	}
+	// modes beyond the legacy mask are all faster than 10G
+	for (int i = 1; i < PARENT_LINK_NWORDS; i++) {
+	    if (link.advertising[i])
+		netif->autoneg_pmd |= LLDP_MAU_PMD_OTHER;
+	}
     } else {
 	my_log(INFO, "autoneg not supported on %s", netif->name);
 	netif->autoneg_supported = 0;
@@ -422,43 +550,63 @@ static void netif_physical(int sockfd, struct netif *netif) {
     // report a mau guesstimate
     netif->mau = LLDP_MAU_TYPE_UNKNOWN;
 
-    switch (ecmd.port) {
+#if HAVE_DECL_ETHTOOL_LINK_MODE_10000BASEER_FULL_BIT
+    // prefer the advertised link modes, fixed links only list supported
+    modes = link.advertising;
+    for (int m = 0; m < 2; m++, modes = link.supported) {
+	for (int i = 0; link_to_lldp_mau[i].speed; i++) {
+	    if ((link.speed == link_to_lldp_mau[i].speed) &&
+		netif_link_mode(modes, link_to_lldp_mau[i].bit)) {
+		netif->mau = link_to_lldp_mau[i].mau;
+		return;
+	    }
+	}
+    }
+#else
+    modes = link.advertising;
+#endif /* HAVE_DECL_ETHTOOL_LINK_MODE_10000BASEER_FULL_BIT */
+
+    switch (link.port) {
 	case PORT_MII:
 	    // fallthrough if we're advertising twisted-pair
-	    if (!(ecmd.advertising & ADVERTISED_TP))
+	    if (!(modes[0] & ADVERTISED_TP))
 		break;
 	case PORT_TP:
-	    if (ecmd.speed == SPEED_10)
+	    if (link.speed == SPEED_10)
 		netif->mau = (netif->duplex) ?
 		     LLDP_MAU_TYPE_10BASE_T_FD : LLDP_MAU_TYPE_10BASE_T_HD;
-	    else if (ecmd.speed == SPEED_100)
+	    else if (link.speed == SPEED_100)
 		netif->mau = (netif->duplex) ?
 		     LLDP_MAU_TYPE_100BASE_TX_FD: LLDP_MAU_TYPE_100BASE_TX_HD;
-	    else if (ecmd.speed == SPEED_1000)
+	    else if (link.speed == SPEED_1000)
 		netif->mau = (netif->duplex) ?
 		     LLDP_MAU_TYPE_1000BASE_T_FD: LLDP_MAU_TYPE_1000BASE_T_HD;
 #ifdef SPEED_10000
-	    else if (ecmd.speed == SPEED_10000)
+	    else if (link.speed == SPEED_10000)
 		netif->mau = LLDP_MAU_TYPE_10GBASE_T;
+#endif
+#ifdef SPEED_25000
+	    else if (link.speed == SPEED_25000)
+		netif->mau = LLDP_MAU_TYPE_25GBASE_T;
 #endif
 	    break;
 	case PORT_FIBRE:
-	    if (ecmd.speed == SPEED_10)
+	    if (link.speed == SPEED_10)
 		netif->mau = (netif->duplex) ?
 		     LLDP_MAU_TYPE_10BASE_FL_FD: LLDP_MAU_TYPE_10BASE_FL_HD;
-	    else if (ecmd.speed == SPEED_100)
+	    else if (link.speed == SPEED_100)
 		netif->mau = (netif->duplex) ?
 		     LLDP_MAU_TYPE_100BASE_FX_FD: LLDP_MAU_TYPE_100BASE_FX_HD;
-	    else if (ecmd.speed == SPEED_1000)
+	    else if (link.speed == SPEED_1000)
 		netif->mau = (netif->duplex) ?
 		     LLDP_MAU_TYPE_1000BASE_X_FD: LLDP_MAU_TYPE_1000BASE_X_HD;
 #ifdef SPEED_10000
-	    else if (ecmd.speed == SPEED_10000)
+	    else if (link.speed == SPEED_10000)
 		netif->mau = LLDP_MAU_TYPE_10GBASE_X;
 #endif
 	    break;
 	case PORT_BNC:
-	    if (ecmd.speed == SPEED_10)
+	    if (link.speed == SPEED_10)
 		netif->mau = LLDP_MAU_TYPE_10BASE_2; 
 	    break;
 	case PORT_AUI:
@@ -466,11 +614,508 @@ static void netif_physical(int sockfd, struct netif *netif) {
 	    break;
 #ifdef PORT_DA
 	case PORT_DA:
-	    if (ecmd.speed == SPEED_10000)
+	    if (link.speed == SPEED_10000)
 		netif->mau = LLDP_MAU_TYPE_10GBASE_CX4;
+#ifdef SPEED_25000
+	    else if (link.speed == SPEED_25000)
+		netif->mau = LLDP_MAU_TYPE_25GBASE_CR;
+#endif
+#ifdef SPEED_40000
+	    else if (link.speed == SPEED_40000)
+		netif->mau = LLDP_MAU_TYPE_40GBASE_CR4;
+#endif
+#ifdef SPEED_100000
+	    else if (link.speed == SPEED_100000)
+		netif->mau = LLDP_MAU_TYPE_100GBASE_CR4;
+#endif
 	    break;
 #endif
     }
+
+    if (netif->mau != LLDP_MAU_TYPE_UNKNOWN)
+	return;
+
+    // fall back to the generic pcs types for the faster links
+#ifdef SPEED_25000
+    if (link.speed == SPEED_25000)
+	netif->mau = LLDP_MAU_TYPE_25GBASE_R;
+#endif
+#ifdef SPEED_40000
+    if (link.speed == SPEED_40000)
+	netif->mau = LLDP_MAU_TYPE_40GBASE_R;
+#endif
+#ifdef SPEED_100000
+    if (link.speed == SPEED_100000)
+	netif->mau = LLDP_MAU_TYPE_100GBASE_R;
+#endif
+}
+#endif /* HAVE_LINUX_ETHTOOL_H */
+
+// perform media detection on physical interfaces
+static void netif_physical(int sockfd, struct netif *netif) {
+
+#if HAVE_LINUX_ETHTOOL_H
+    struct netif_facts *nfacts = netif_facts(netif->index, netif->name);
+
+    // the media details are kept until the carrier changes
+    if (!(nfacts->valid & NETIF_FACT_MEDIA)) {
+	netif_link(netif);
+	nfacts->duplex = netif->duplex;
+	nfacts->autoneg_supported = netif->autoneg_supported;
+	nfacts->autoneg_enabled = netif->autoneg_enabled;
+	nfacts->autoneg_pmd = netif->autoneg_pmd;
+	nfacts->mau = netif->mau;
+	nfacts->valid |= NETIF_FACT_MEDIA;
+    }
+
+    netif->duplex = nfacts->duplex;
+    netif->autoneg_supported = nfacts->autoneg_supported;
+    netif->autoneg_enabled = nfacts->autoneg_enabled;
+    netif->autoneg_pmd = nfacts->autoneg_pmd;
+    netif->mau = nfacts->mau;
 #endif /* HAVE_LINUX_ETHTOOL_H */
 }
 
+
+
+#ifdef HAVE_NETIF_EVENTS
+struct netif_nlattrs {
+    const struct nlattr **tb;
+    uint16_t max;
+};
+
+static int netif_nlattr(const struct nlattr *attr, void *data) {
+    struct netif_nlattrs *nla = data;
+    uint16_t type = mnl_attr_get_type(attr);
+
+    if (type <= nla->max)
+	nla->tb[type] = attr;
+    return(MNL_CB_OK);
+}
+
+static void netif_nlnested(const struct nlattr *nest,
+			    const struct nlattr **tb, uint16_t max) {
+    struct netif_nlattrs nla = { .tb = tb, .max = max };
+
+    if (nest != NULL)
+	mnl_attr_parse_nested(nest, netif_nlattr, &nla);
+}
+
+static const char *netif_nlstr(const struct nlattr *attr) {
+    if ((attr == NULL) || (mnl_attr_validate(attr, MNL_TYPE_NUL_STRING) < 0))
+	return(NULL);
+    return(mnl_attr_get_str(attr));
+}
+
+static int netif_nlu32(const struct nlattr *attr, uint32_t *value) {
+    if ((attr == NULL) || (mnl_attr_validate(attr, MNL_TYPE_U32) < 0))
+	return(0);
+    *value = mnl_attr_get_u32(attr);
+    return(1);
+}
+
+#if HAVE_LINUX_IF_BONDING_H
+static int netif_nlu8(const struct nlattr *attr, uint8_t *value) {
+    if ((attr == NULL) || (mnl_attr_validate(attr, MNL_TYPE_U8) < 0))
+	return(0);
+    *value = mnl_attr_get_u8(attr);
+    return(1);
+}
+#endif /* HAVE_LINUX_IF_BONDING_H */
+
+// detect the interface type, the link kind avoids most ioctls
+static int netif_event_type(uint32_t index, const char *name,
+			    const char *kind) {
+    struct ifaddrs ifaddr = { .ifa_name = (char *)name };
+    struct ifreq ifr = {};
+
+    if (kind != NULL) {
+	if (strcmp(kind, "bond") == 0)
+	    return(NETIF_BONDING);
+	else if (strcmp(kind, "team") == 0)
+	    return(NETIF_TEAMING);
+	else if (strcmp(kind, "bridge") == 0)
+	    return(NETIF_BRIDGE);
+	else if (strcmp(kind, "vlan") == 0)
+	    return(NETIF_VLAN);
+	else if (strcmp(kind, "tun") == 0)
+	    return(NETIF_TAP);
+    }
+
+    strlcpy(ifr.ifr_name, name, sizeof(ifr.ifr_name));
+    return(netif_type(sockfd, index, &ifaddr, &ifr));
+}
+
+// add a subif to the end of the parent's subif list
+static void netif_event_enslave(struct netif *parent, struct netif *subif) {
+    struct netif *csubif = parent;
+    uint8_t i = 0;
+
+    for (; csubif->subif != NULL; csubif = csubif->subif)
+	i++;
+
+    my_log(INFO, "found child %s", subif->name);
+    csubif->subif = subif;
+    subif->subif = NULL;
+    subif->parent = parent;
+    subif->child = NETIF_CHILD_ACTIVE;
+    subif->lacp_index = i;
+}
+
+// remove a subif from the parent's subif list
+static void netif_event_release(struct netif *subif) {
+    struct netif *csubif = subif->parent;
+
+    if (csubif == NULL)
+	return;
+
+    for (; csubif->subif != NULL; csubif = csubif->subif) {
+	if (csubif->subif != subif)
+	    continue;
+	csubif->subif = subif->subif;
+	break;
+    }
+    // renumber the remaining subifs
+    for (csubif = subif->subif; csubif != NULL; csubif = csubif->subif)
+	csubif->lacp_index--;
+
+    subif->subif = NULL;
+    subif->parent = NULL;
+    subif->child = 0;
+    subif->lacp_index = 0;
+}
+
+// recalculate the interface derived sysinfo, like netif_fetch the totals
+// include interfaces which are down. returns 1 if they changed
+static int netif_event_sysinfo(struct my_sysinfo *sysinfo,
+				struct nhead *netifs) {
+    struct netif_facts *nfacts;
+    struct netif *netif;
+    uint16_t cap = sysinfo->cap, physif_count = sysinfo->physif_count;
+
+    sysinfo->cap &= (CAP_HOST|CAP_ROUTER);
+    sysinfo->cap_active &= (CAP_HOST|CAP_ROUTER);
+    sysinfo->physif_count = 0;
+
+    for (int i = 0; i < NETIF_FACTS_HASH; i++) {
+	for (nfacts = facts[i]; nfacts != NULL; nfacts = nfacts->next) {
+	    if (!(nfacts->valid & NETIF_FACT_TYPE))
+		continue;
+	    if (nfacts->type == NETIF_REGULAR)
+		sysinfo->physif_count++;
+	    else if (nfacts->type == NETIF_WIRELESS)
+		sysinfo->cap |= CAP_WLAN;
+	    else if (nfacts->type == NETIF_BRIDGE)
+		sysinfo->cap |= CAP_BRIDGE;
+	}
+    }
+
+    // only interfaces which are up are tracked
+    TAILQ_FOREACH(netif, netifs, entries) {
+	if (netif->type == NETIF_WIRELESS)
+	    sysinfo->cap_active |= CAP_WLAN;
+	else if (netif->type == NETIF_BRIDGE)
+	    sysinfo->cap_active |= CAP_BRIDGE;
+    }
+    sysinfo->cap |= sysinfo->cap_active;
+
+    // use the first mac as chassis id
+    if ((netif = TAILQ_FIRST(netifs)) != NULL)
+	memcpy(&sysinfo->hwaddr, &netif->hwaddr, ETHER_ADDR_LEN);
+
+    return((cap != sysinfo->cap) || (physif_count != sysinfo->physif_count));
+}
+
+static int netif_event_link(const struct nlmsghdr *nlh,
+			    struct my_sysinfo *sysinfo, struct nhead *netifs) {
+    struct ifinfomsg *ifm = mnl_nlmsg_get_payload(nlh);
+    const struct nlattr *tb[IFLA_MAX + 1] = {};
+    const struct nlattr *info[IFLA_INFO_MAX + 1] = {};
+    const struct nlattr *vlan[IFLA_VLAN_MAX + 1] = {};
+    struct netif_nlattrs nla = { .tb = tb, .max = IFLA_MAX };
+    struct netif *netif, *subif, *parent = NULL;
+    struct netif_facts *nfacts = NULL;
+    const char *name, *kind, *slave_kind, *alias;
+    uint32_t master = 0, link = 0;
+    int type, tracked, ret = NETIF_EVENT_UPDATE;
+
+    if (mnl_nlmsg_get_payload_len(nlh) < sizeof(struct ifinfomsg))
+	return(0);
+    mnl_attr_parse(nlh, sizeof(struct ifinfomsg), netif_nlattr, &nla);
+
+    netif = netif_byindex(netifs, ifm->ifi_index);
+
+    name = netif_nlstr(tb[IFLA_IFNAME]);
+    netif_nlnested(tb[IFLA_LINKINFO], info, IFLA_INFO_MAX);
+    kind = netif_nlstr(info[IFLA_INFO_KIND]);
+    slave_kind = netif_nlstr(info[IFLA_INFO_SLAVE_KIND]);
+    netif_nlu32(tb[IFLA_MASTER], &master);
+    netif_nlu32(tb[IFLA_LINK], &link);
+
+    if (nlh->nlmsg_type == RTM_DELLINK) {
+	netif_facts_forget(ifm->ifi_index, NETIF_FACT_ALL);
+    } else if ((ifm->ifi_type == ARPHRD_ETHER) && (name != NULL)) {
+	// the sysinfo totals include ethernet interfaces which are down
+	nfacts = netif_facts(ifm->ifi_index, name);
+	if (!(nfacts->valid & NETIF_FACT_TYPE)) {
+	    nfacts->type = netif_event_type(ifm->ifi_index, name, kind);
+	    nfacts->valid |= NETIF_FACT_TYPE;
+	}
+    } else if (ifm->ifi_type != ARPHRD_ETHER) {
+	netif_facts_forget(ifm->ifi_index, NETIF_FACT_TYPE);
+    }
+
+    // removed, disabled or non-ethernet interfaces
+    if ((nlh->nlmsg_type == RTM_DELLINK) ||
+	(ifm->ifi_type != ARPHRD_ETHER) || !(ifm->ifi_flags & IFF_UP)) {
+	tracked = (netif != NULL);
+	if (tracked) {
+	    netif_event_release(netif);
+	    while (netif->subif != NULL)
+		netif_event_release(netif->subif);
+	    netif_forget(netifs, sysinfo, netif);
+	}
+	if (!netif_event_sysinfo(sysinfo, netifs) && !tracked)
+	    return(0);
+	return(ret);
+    }
+
+    if (name == NULL)
+	return(0);
+
+    if (netif == NULL) {
+	type = nfacts->type;
+	if (type == NETIF_INVALID) {
+	    my_log(INFO, "skipping interface %s", name);
+	    return(0);
+	}
+
+	my_log(INFO, "adding interface %s", name);
+	netif = my_malloc(sizeof(struct netif));
+	netif->index = ifm->ifi_index;
+	strlcpy(netif->name, name, sizeof(netif->name));
+	netif->type = type;
+	netif_list_insert(netifs, netif);
+
+	if (netif->type == NETIF_REGULAR) {
+	    struct ifreq ifr = {};
+	    netif_device_id(sockfd, netif, &ifr);
+	}
+
+	// adopt subifs which showed up before their parent
+	if (netif->type > NETIF_PARENT) {
+	    TAILQ_FOREACH(subif, netifs, entries) {
+		if ((subif->master == netif->index) &&
+		    (subif->parent == NULL) && (subif->type < NETIF_PARENT))
+		    netif_event_enslave(netif, subif);
+	    }
+	}
+
+	// the addresses of new interfaces need to be fetched
+	ret |= NETIF_EVENT_ADDRS;
+    } else if (strcmp(netif->name, name) != 0) {
+	my_log(INFO, "renaming interface %s to %s", netif->name, name);
+	strlcpy(netif->name, name, sizeof(netif->name));
+	netif->argv = 0;
+	netif_list_rehash(netifs, netif);
+    }
+
+    if (sysinfo->mifname && (strcmp(netif->name, sysinfo->mifname) == 0))
+	sysinfo->mnetif = netif;
+
+    if ((tb[IFLA_ADDRESS] != NULL) &&
+	(mnl_attr_get_payload_len(tb[IFLA_ADDRESS]) >= ETHER_ADDR_LEN) &&
+	(memcmp(netif->hwaddr, mnl_attr_get_payload(tb[IFLA_ADDRESS]),
+		ETHER_ADDR_LEN) != 0)) {
+	static const uint8_t zero[ETHER_ADDR_LEN] = {};
+	int changed = (memcmp(netif->hwaddr, zero, ETHER_ADDR_LEN) != 0);
+
+	memcpy(netif->hwaddr, mnl_attr_get_payload(tb[IFLA_ADDRESS]),
+		ETHER_ADDR_LEN);
+	netif_list_rehash(netifs, netif);
+
+	// the parent rejects our own frames by hwaddr, bonds rewrite the
+	// hwaddr of their slaves, so have an open socket refresh its filter
+	if (changed && (options & OPT_RECV)) {
+	    struct parent_req mreq = {};
+
+	    mreq.op = PARENT_OPEN;
+	    mreq.index = netif->index;
+	    mreq.len = ETHER_ADDR_LEN;
+	    memcpy(mreq.buf, netif->hwaddr, ETHER_ADDR_LEN);
+	    my_mreq(&mreq);
+	}
+    }
+
+    // media details only change with the carrier
+    nfacts = netif_facts(netif->index, netif->name);
+    if (nfacts->carrier != (ifm->ifi_flags & (IFF_RUNNING|IFF_LOWER_UP))) {
+	nfacts->carrier = ifm->ifi_flags & (IFF_RUNNING|IFF_LOWER_UP);
+	nfacts->valid &= ~NETIF_FACT_MEDIA;
+    }
+
+    // the alias is only included when set
+    memset(nfacts->alias, 0, IFDESCRSIZE);
+    if ((alias = netif_nlstr(tb[IFLA_IFALIAS])) != NULL)
+	strlcpy(nfacts->alias, alias, IFDESCRSIZE);
+    nfacts->valid |= NETIF_FACT_ALIAS;
+    strlcpy(netif->description, nfacts->alias, IFDESCRSIZE);
+
+    if (netif->type == NETIF_VLAN) {
+	netif_nlnested(info[IFLA_INFO_DATA], vlan, IFLA_VLAN_MAX);
+	netif->vlan_parent = link;
+	if ((vlan[IFLA_VLAN_ID] != NULL) &&
+	    (mnl_attr_validate(vlan[IFLA_VLAN_ID], MNL_TYPE_U16) == 0))
+	    netif->vlan_id = mnl_attr_get_u16(vlan[IFLA_VLAN_ID]);
+    }
+
+#if HAVE_LINUX_IF_BONDING_H
+    if ((netif->type == NETIF_BONDING) && (kind != NULL)) {
+	const struct nlattr *bond[IFLA_BOND_MAX + 1] = {};
+	uint8_t mode;
+
+	netif_nlnested(info[IFLA_INFO_DATA], bond, IFLA_BOND_MAX);
+	if (netif_nlu8(bond[IFLA_BOND_MODE], &mode)) {
+	    netif->bonding_mode = 0;
+#if defined(BOND_MODE_8023AD)
+	    if (mode == BOND_MODE_8023AD)
+		netif->bonding_mode = NETIF_BONDING_LACP;
+#endif
+	    if (mode == BOND_MODE_ACTIVEBACKUP)
+		netif->bonding_mode = NETIF_BONDING_FAILOVER;
+	}
+    }
+#endif /* HAVE_LINUX_IF_BONDING_H */
+
+    // update bond, bridge and team membership
+    if (netif->type < NETIF_PARENT) {
+	netif->master = master;
+	if (master)
+	    parent = netif_byindex(netifs, master);
+	// XXX: multi-level bonds and bridges are not supported
+	if ((parent != NULL) && (parent->type <= NETIF_PARENT))
+	    parent = NULL;
+
+	if (netif->parent != parent) {
+	    netif_event_release(netif);
+	    if (parent != NULL)
+		netif_event_enslave(parent, netif);
+	}
+
+	if ((netif->parent != NULL) && (slave_kind != NULL) &&
+	    (strcmp(slave_kind, "bond") == 0)) {
+	    netif->child = NETIF_CHILD_ACTIVE;
+#if HAVE_LINUX_IF_BONDING_H
+	    const struct nlattr *slave[IFLA_BOND_SLAVE_MAX + 1] = {};
+	    uint8_t state;
+
+	    netif_nlnested(info[IFLA_INFO_SLAVE_DATA], slave,
+			   IFLA_BOND_SLAVE_MAX);
+	    if ((netif->parent->bonding_mode == NETIF_BONDING_FAILOVER) &&
+		netif_nlu8(slave[IFLA_BOND_SLAVE_STATE], &state) &&
+		(state == BOND_STATE_BACKUP))
+		netif->child = NETIF_CHILD_BACKUP;
+#endif /* HAVE_LINUX_IF_BONDING_H */
+	}
+    }
+
+    netif_event_sysinfo(sysinfo, netifs);
+    return(ret);
+}
+
+static int netif_event_addr(const struct nlmsghdr *nlh,
+			    struct my_sysinfo *sysinfo, struct nhead *netifs) {
+    struct ifaddrmsg *ifa = mnl_nlmsg_get_payload(nlh);
+    const struct nlattr *tb[IFA_MAX + 1] = {};
+    struct netif_nlattrs nla = { .tb = tb, .max = IFA_MAX };
+    const struct nlattr *attr;
+    struct netif *netif, *mnetif;
+    uint32_t addr[4] = {};
+    int ret = NETIF_EVENT_UPDATE;
+
+    if (mnl_nlmsg_get_payload_len(nlh) < sizeof(struct ifaddrmsg))
+	return(0);
+    mnl_attr_parse(nlh, sizeof(struct ifaddrmsg), netif_nlattr, &nla);
+
+    if ((netif = netif_byindex(netifs, ifa->ifa_index)) == NULL)
+	return(0);
+
+    // the local address is the actual address on point-to-point links
+    if ((attr = tb[IFA_LOCAL]) == NULL)
+	attr = tb[IFA_ADDRESS];
+    if (attr == NULL)
+	return(0);
+
+    if ((ifa->ifa_family == AF_INET) &&
+	(mnl_attr_get_payload_len(attr) >= sizeof(netif->ipaddr4))) {
+	memcpy(addr, mnl_attr_get_payload(attr), sizeof(netif->ipaddr4));
+
+	if (nlh->nlmsg_type == RTM_DELADDR) {
+	    if (netif->ipaddr4 != addr[0])
+		return(0);
+	    // another address might be available
+	    netif->ipaddr4 = 0;
+	    ret |= NETIF_EVENT_ADDRS;
+	} else if (netif->ipaddr4 == 0) {
+	    netif->ipaddr4 = addr[0];
+	    if (!sysinfo->mnetif && sysinfo->maddr4 &&
+		(sysinfo->maddr4 == netif->ipaddr4))
+		sysinfo->mnetif = netif;
+	}
+
+    } else if ((ifa->ifa_family == AF_INET6) &&
+	(mnl_attr_get_payload_len(attr) >= sizeof(netif->ipaddr6))) {
+	memcpy(addr, mnl_attr_get_payload(attr), sizeof(netif->ipaddr6));
+
+	// skip link-local
+	if (IN6_IS_ADDR_LINKLOCAL((struct in6_addr *)addr))
+	    return(0);
+
+	if (nlh->nlmsg_type == RTM_DELADDR) {
+	    if (memcmp(netif->ipaddr6, addr, sizeof(netif->ipaddr6)) != 0)
+		return(0);
+	    memset(netif->ipaddr6, 0, sizeof(netif->ipaddr6));
+	    ret |= NETIF_EVENT_ADDRS;
+	} else if (IN6_IS_ADDR_UNSPECIFIED((struct in6_addr *)netif->ipaddr6)) {
+	    memcpy(netif->ipaddr6, addr, sizeof(netif->ipaddr6));
+	    if (!sysinfo->mnetif &&
+		!IN6_IS_ADDR_UNSPECIFIED((struct in6_addr *)sysinfo->maddr6) &&
+		(memcmp(sysinfo->maddr6, netif->ipaddr6,
+			sizeof(sysinfo->maddr6)) == 0))
+		sysinfo->mnetif = netif;
+	}
+    } else {
+	return(0);
+    }
+
+    // use management address when requested
+    if (!(options & OPT_MADDR) || !sysinfo->mnetif)
+	return(ret);
+    mnetif = sysinfo->mnetif;
+
+    TAILQ_FOREACH(netif, netifs, entries) {
+	netif->ipaddr4 = mnetif->ipaddr4;
+	memcpy(&netif->ipaddr6, &mnetif->ipaddr6, sizeof(mnetif->ipaddr6));
+    }
+    return(ret);
+}
+
+// apply a rtnetlink link or address event to the netif list
+int netif_event(const struct nlmsghdr *nlh, struct my_sysinfo *sysinfo,
+		struct nhead *netifs) {
+
+    if (sockfd == -1)
+	my_fatal("please call netif_init first");
+
+    switch (nlh->nlmsg_type) {
+	case RTM_NEWLINK:
+	case RTM_DELLINK:
+	    return(netif_event_link(nlh, sysinfo, netifs));
+	case RTM_NEWADDR:
+	case RTM_DELADDR:
+	    return(netif_event_addr(nlh, sysinfo, netifs));
+	default:
+	    return(0);
+    }
+}
+#endif /* HAVE_NETIF_EVENTS */
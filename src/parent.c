@@ -32,11 +32,9 @@
 #include <sys/capability.h>
 #endif
 
-#ifdef HAVE_NETPACKET_PACKET_H
-#include <netpacket/packet.h>
-#endif /* HAVE_NETPACKET_PACKET_H */
 #ifdef HAVE_NET_IF_DL_H
 #include <net/if_dl.h>
+#include <ifaddrs.h>
 #endif /* HAVE_NET_IF_DL_H */
 
 #if HAVE_LINUX_SOCKIOS_H
@@ -58,6 +56,14 @@
 #include <pci/pci.h>
 #endif /* HAVE_PCI_PCI_H */
 
+#ifdef HAVE_RXRING
+#include <sys/mman.h>
+#include <linux/filter.h>
+#ifndef ETH_P_ALL
+#define ETH_P_ALL	0x0003
+#endif
+#endif /* HAVE_RXRING */
+
 #include "filter.h"
 
 #ifdef HAVE_SYSFS
@@ -70,11 +76,27 @@
 #endif /* HAVE_SYSFS */
 
 struct rfdhead rawfds;
+#ifdef HAVE_RXRING
+struct rxring rxring = { .fd = -1 };
+#endif /* HAVE_RXRING */
 
 static int sock = -1;
 int mfd = -1;
 int dfd = -1;
 
+// received messages pending delivery to the child
+static struct parent_msg mbatch[PARENT_MSG_BATCH];
+static int mcount = 0;
+unsigned int rcount = 0, rbatch = 0, rdrops = 0;
+
+static uint64_t parent_recv_now();
+static void parent_recv_msg(struct parent_msg *, int proto);
+static void parent_recv_flush();
+static void parent_hwaddr(const char *name, uint8_t *hwaddr);
+#ifdef HAVE_RXRING
+static void parent_ring_flush();
+#endif /* HAVE_RXRING */
+
 extern struct proto protos[];
 
 void parent_init(int reqfd, int msgfd, pid_t child) {
@@ -138,7 +160,7 @@ void parent_init(int reqfd, int msgfd, pid_t child) {
     signal_set(&ev_sigchld, SIGCHLD, parent_signal, &child);
     signal_set(&ev_sigint, SIGINT, parent_signal, &child);
     signal_set(&ev_sigterm, SIGTERM, parent_signal, &child);
-    signal_set(&ev_sighup, SIGHUP, parent_signal, NULL);
+    signal_set(&ev_sighup, SIGHUP, parent_signal, &child);
     signal_add(&ev_sigchld, NULL);
     signal_add(&ev_sigint, NULL);
     signal_add(&ev_sigterm, NULL);
@@ -182,6 +204,9 @@ void parent_signal(int sig, short event, void *pid) {
 	    exit(EXIT_SUCCESS);
 	    break;
 	case SIGHUP:
+	    // ask the child to rescan all interfaces
+	    if (pid != NULL)
+		kill(*(pid_t *)pid, sig);
 	    break;
 	default:
 	    my_fatal("unexpected signal");
@@ -190,74 +215,103 @@ void parent_signal(int sig, short event, void *pid) {
 
 
 void parent_req(int reqfd, short event) {
-    struct parent_req mreq = {};
-    struct rawfd *rfd;
+    static struct parent_req mreqs[PARENT_REQ_BATCH];
+    int count = 0, flags = 0;
     ssize_t len;
 
-    // receive request
-    len = read(reqfd, &mreq, PARENT_REQ_MAX);
+    // handle all queued requests
+    for (; count < PARENT_REQ_BATCH; count++) {
+	memset(&mreqs[count], 0, PARENT_REQ_MAX);
+	len = recv(reqfd, &mreqs[count], PARENT_REQ_MAX, flags);
+
+	// nothing left
+	if ((count > 0) && (len == -1) &&
+	    ((errno == EAGAIN) || (errno == EWOULDBLOCK)))
+	    break;
+
+	// check request size
+	if (len < PARENT_REQ_MIN || len != PARENT_REQ_LEN(mreqs[count].len))
+	    my_fatal("invalid request received");
+
+	parent_req_op(&mreqs[count]);
+	flags = MSG_DONTWAIT;
+    }
 
-    // check request size
-    if (len < PARENT_REQ_MIN || len != PARENT_REQ_LEN(mreq.len))
-	my_fatal("invalid request received");
+#ifdef HAVE_RXRING
+    // once for all interfaces opened or closed by the batch
+    parent_ring_flush();
+#endif /* HAVE_RXRING */
+
+    // and return the replies
+    for (int i = 0; i < count; i++) {
+	len = write(reqfd, &mreqs[i], PARENT_REQ_LEN(mreqs[i].len));
+	if (len != PARENT_REQ_LEN(mreqs[i].len))
+	    my_fatal("failed to return request to child");
+    }
+}
+
+
+void parent_req_op(struct parent_req *mreq) {
+    struct rawfd *rfd;
 
     // validate ifindex
-    if (if_indextoname(mreq.index, mreq.name) == NULL) {
-	mreq.len = 0;
-	goto out;
+    if (if_indextoname(mreq->index, mreq->name) == NULL) {
+	mreq->len = 0;
+	return;
     }
 
     // validate request
-    if (parent_check(&mreq) != EXIT_SUCCESS)
+    if (parent_check(mreq) != EXIT_SUCCESS)
 	my_fatal("invalid request supplied");
 
-    switch (mreq.op) {
-	// open socket
+    switch (mreq->op) {
+	// open socket, or refresh the filter of an open one
 	case PARENT_OPEN:
-	    if ((rfd = rfd_byindex(&rawfds, mreq.index)) == NULL)
-		parent_open(mreq.index, mreq.name);
+	    rfd = rfd_byindex(&rawfds, mreq->index);
+	    if ((rfd == NULL) && (mreq->len == 0))
+		parent_open(mreq->index, mreq->name);
+	    else if ((rfd != NULL) && (mreq->len == ETHER_ADDR_LEN) &&
+		(memcmp(rfd->hwaddr, mreq->buf, ETHER_ADDR_LEN) != 0)) {
+		strlcpy(rfd->name, mreq->name, IFNAMSIZ);
+		parent_refresh(rfd);
+	    }
 	    break;
 	// close socket
 	case PARENT_CLOSE:
-	    if ((rfd = rfd_byindex(&rawfds, mreq.index)) != NULL)
+	    if ((rfd = rfd_byindex(&rawfds, mreq->index)) != NULL)
 		parent_close(rfd);
 	    break;
 #if HAVE_LINUX_ETHTOOL_H
 	// fetch ethtool details
-	case PARENT_ETHTOOL_GSET:
+	case PARENT_ETHTOOL_GLINK:
 	case PARENT_ETHTOOL_GDRV:
-	    mreq.len = parent_ethtool(&mreq);
+	    mreq->len = parent_ethtool(mreq);
 	    break;
 #endif /* HAVE_LINUX_ETHTOOL_H */
 	// manage interface description
 	case PARENT_DESCR:
 	case PARENT_ALIAS:
-	    mreq.len = parent_descr(&mreq);
+	    mreq->len = parent_descr(mreq);
 	    break;
 #ifdef HAVE_SYSFS
 	case PARENT_DEVICE:
-	    mreq.len = parent_device(&mreq);
+	    mreq->len = parent_device(mreq);
 	    break;
 #endif /* HAVE_SYSFS */
 #if defined(HAVE_SYSFS) && defined(HAVE_PCI_PCI_H)
 	case PARENT_DEVICE_ID:
-	    mreq.len = parent_device_id(&mreq);
+	    mreq->len = parent_device_id(mreq);
 	    break;
 #endif /* HAVE_SYSFS && HAVE_PCI_PCI_H */
 #if defined(HAVE_LIBTEAM)
 	case PARENT_TEAMNL:
-	    mreq.len = parent_libteam(&mreq);
+	    mreq->len = parent_libteam(mreq);
 	    break;
 #endif /* HAVE_LIBTEAM */
 	// invalid request
 	default:
 	    my_fatal("invalid request received");
     }
-
-out:
-    len = write(reqfd, &mreq, PARENT_REQ_LEN(mreq.len));
-    if (len != PARENT_REQ_LEN(mreq.len))
-	    my_fatal("failed to return request to child");
 }
 
 
@@ -269,12 +323,14 @@ int parent_check(struct parent_req *mreq) {
 
     switch (mreq->op) {
 	case PARENT_OPEN:
+	    // optionally with the hwaddr the child expects
+	    assert((mreq->len == 0) || (mreq->len == ETHER_ADDR_LEN));
 	    return(EXIT_SUCCESS);
 	case PARENT_CLOSE:
 	    return(EXIT_SUCCESS);
 #if HAVE_LINUX_ETHTOOL_H
-	case PARENT_ETHTOOL_GSET:
-	    assert(mreq->len == sizeof(struct ethtool_cmd));
+	case PARENT_ETHTOOL_GLINK:
+	    assert(mreq->len == sizeof(struct parent_link_info));
 	    return(EXIT_SUCCESS);
 	case PARENT_ETHTOOL_GDRV:
 	    assert(mreq->len == sizeof(struct ethtool_drvinfo));
@@ -307,50 +363,152 @@ int parent_check(struct parent_req *mreq) {
 
 
 void parent_send(int msgfd, short event) {
-    struct parent_msg msend = {};
-    struct rawfd *rfd = NULL;
-    ssize_t len;
-
-    // receive request
-    len = read(msgfd, &msend, PARENT_MSG_MAX);
+    static struct parent_msg msgs[PARENT_MSG_BATCH];
+    struct parent_msg *group[PARENT_MSG_BATCH];
+    uint8_t done[PARENT_MSG_BATCH] = {};
+    int count, gcount;
 
-    // check request size
-    if (len < PARENT_MSG_MIN || len != PARENT_MSG_LEN(msend.len))
+    // receive a batch of messages
+    if ((count = my_mrecv(msgfd, msgs, PARENT_MSG_BATCH)) == 0)
 	return;
 
-    if (if_indextoname(msend.index, msend.name) == NULL) {
-	my_log(CRIT, "invalid ifindex supplied");
-	return;
+    // group messages per interface
+    for (int i = 0; i < count; i++) {
+	if (done[i])
+	    continue;
+
+	gcount = 0;
+	for (int j = i; j < count; j++) {
+	    if (msgs[j].index != msgs[i].index)
+		continue;
+	    group[gcount++] = &msgs[j];
+	    done[j] = 1;
+	}
+
+	parent_send_group(group, gcount);
     }
 
-    assert(msend.len >= (ETHER_MIN_LEN - ETHER_VLAN_ENCAP_LEN));
-    assert(msend.proto < PROTO_MAX);
-    assert(protos[msend.proto].check(msend.msg, msend.len) != NULL);
+#ifdef HAVE_RXRING
+    parent_ring_flush();
+#endif /* HAVE_RXRING */
+}
+
+void parent_send_group(struct parent_msg *msgs[], int count) {
+    struct rawfd *rfd = NULL;
+    uint32_t index = msgs[0]->index;
+    char name[IFNAMSIZ];
+
+    // only resolve the name for new interfaces
+    if ((rfd = rfd_byindex(&rawfds, index)) == NULL) {
+	if (if_indextoname(index, name) == NULL) {
+	    my_log(CRIT, "invalid ifindex supplied");
+	    return;
+	}
+    }
+
+    for (int i = 0; i < count; i++) {
+	assert(msgs[i]->len >= (ETHER_MIN_LEN - ETHER_VLAN_ENCAP_LEN));
+	assert(msgs[i]->proto < PROTO_MAX);
+	assert(protos[msgs[i]->proto].check(msgs[i]->msg, msgs[i]->len) != NULL);
+    }
 
     // debug
     if (options & OPT_DEBUG) {
-	my_pcap_write(&msend);
+	for (int i = 0; i < count; i++)
+	    my_pcap_write(msgs[i]);
 	return;
     }
 
     // create rfd if needed
-    if (rfd_byindex(&rawfds, msend.index) == NULL)
+    if (rfd == NULL) {
 	// bail if that fails
-	if (parent_open(msend.index, msend.name) < 0)
+	if (parent_open(index, name) < 0)
 	    return;
+	assert((rfd = rfd_byindex(&rawfds, index)) != NULL);
+    }
+
+#if defined(HAVE_SENDMMSG) && defined(AF_PACKET)
+    struct mmsghdr mmsg[PARENT_MSG_BATCH];
+    struct iovec iov[PARENT_MSG_BATCH];
+    struct sockaddr_ll sll = {};
+    int ret, sent = 0;
+
+    // the shared ring socket isn't bound to an interface
+    sll.sll_family = AF_PACKET;
+    sll.sll_ifindex = index;
+
+    memset(mmsg, 0, sizeof(mmsg));
+    for (int i = 0; i < count; i++) {
+	iov[i].iov_base = msgs[i]->msg;
+	iov[i].iov_len = msgs[i]->len;
+	mmsg[i].msg_hdr.msg_iov = &iov[i];
+	mmsg[i].msg_hdr.msg_iovlen = 1;
+#ifdef HAVE_RXRING
+	if (rfd->ring) {
+	    mmsg[i].msg_hdr.msg_name = &sll;
+	    mmsg[i].msg_hdr.msg_namelen = sizeof(sll);
+	}
+#endif /* HAVE_RXRING */
+    }
 
-    assert((rfd = rfd_byindex(&rawfds, msend.index)) != NULL);
-    len = write(rfd->fd, msend.msg, msend.len);
+    while (sent < count) {
+	ret = sendmmsg(rfd->fd, mmsg + sent, count - sent, 0);
 
-    // close the socket if the device vanished
-    // if needed a new socket will be created on the next run
-    if ((len == -1) && ((errno == ENODEV) || (errno == EIO)))
-	parent_close(rfd);
+	if (ret == -1) {
+	    if (errno == EINTR)
+		continue;
 
-    if (len != msend.len)
-	my_loge(WARN, "only %zi bytes written", len);
+	    // close the socket if the device vanished
+	    // if needed a new socket will be created on the next run
+	    if ((errno == ENODEV) || (errno == EIO)) {
+		parent_close(rfd);
+		return;
+	    }
 
-    return;
+	    // skip the failed frame
+	    my_loge(WARN, "failed to send %s frame on %s",
+		    protos[msgs[sent]->proto].name, rfd->name);
+	    sent++;
+	    continue;
+	}
+
+	for (int i = sent; i < sent + ret; i++) {
+	    if (mmsg[i].msg_len != msgs[i]->len)
+		my_log(WARN, "only %u bytes written", mmsg[i].msg_len);
+	}
+	sent += ret;
+    }
+#else
+    ssize_t len;
+
+    for (int i = 0; i < count; i++) {
+#ifdef HAVE_RXRING
+	// the shared ring socket isn't bound to an interface
+	if (rfd->ring) {
+	    struct sockaddr_ll sll = {};
+
+	    sll.sll_family = AF_PACKET;
+	    sll.sll_ifindex = index;
+	    len = sendto(rfd->fd, msgs[i]->msg, msgs[i]->len, 0,
+			(struct sockaddr *)&sll, sizeof(sll));
+	} else
+#endif /* HAVE_RXRING */
+	len = write(rfd->fd, msgs[i]->msg, msgs[i]->len);
+
+	// close the socket if the device vanished
+	// if needed a new socket will be created on the next run
+	if ((len == -1) && ((errno == ENODEV) || (errno == EIO))) {
+	    parent_close(rfd);
+	    return;
+	}
+
+	if (len == -1)
+	    my_loge(WARN, "failed to send %s frame on %s",
+		    protos[msgs[i]->proto].name, rfd->name);
+	else if (len != msgs[i]->len)
+	    my_log(WARN, "only %zi bytes written", len);
+    }
+#endif /* HAVE_SENDMMSG && AF_PACKET */
 }
 
 
@@ -371,7 +529,7 @@ int parent_open(const uint32_t index, const char *name) {
 	return(-1);
     }
 
-    TAILQ_INSERT_TAIL(&rawfds, rfd, entries);
+    rfd_insert(&rawfds, rfd);
 
     if (!(options & OPT_RECV) || (options & OPT_DEBUG))
 	return(0);
@@ -379,6 +537,14 @@ int parent_open(const uint32_t index, const char *name) {
     // register multicast membership
     parent_multi(rfd, protos, 1);
 
+#ifdef HAVE_RXRING
+    // the ring has a single event and filter for all interfaces
+    if (rfd->ring) {
+	rfd->ring->dirty = 1;
+	return(0);
+    }
+#endif /* HAVE_RXRING */
+
     // listen for received packets
     event_set(&rfd->event, rfd->fd, EV_READ|EV_PERSIST,
 	(void *)parent_recv, rfd);
@@ -387,44 +553,204 @@ int parent_open(const uint32_t index, const char *name) {
     return(0);
 }
 
+// rebuild the own hwaddr filter of a socket after the hwaddr changed
+void parent_refresh(struct rawfd *rfd) {
+    struct bpf_program fprog = {};
+    struct bpf_insn filter[FILTER_MAX];
+    uint8_t hwaddr[ETHER_ADDR_LEN];
+
+    assert(rfd != NULL);
+
+    if (!(options & OPT_RECV) || (options & OPT_DEBUG))
+	return;
+
+    memcpy(hwaddr, rfd->hwaddr, ETHER_ADDR_LEN);
+    parent_hwaddr(rfd->name, rfd->hwaddr);
+    if (memcmp(hwaddr, rfd->hwaddr, ETHER_ADDR_LEN) == 0)
+	return;
+
+    my_log(INFO, "refreshing the receive filter of %s", rfd->name);
+
+#ifdef HAVE_RXRING
+    if (rfd->ring) {
+	rfd->ring->dirty = 1;
+	return;
+    }
+#endif /* HAVE_RXRING */
+
+    if (rfd->p_handle == NULL)
+	return;
+
+    fprog.bf_insns = filter;
+    fprog.bf_len = parent_filter(filter, rfd->hwaddr, 1);
+    if (pcap_setfilter(rfd->p_handle, &fprog) != 0)
+	my_log(CRIT, "unable to configure socket filter for %s", rfd->name);
+}
+
 void parent_close(struct rawfd *rfd) {
+#ifdef HAVE_RXRING
+    struct rxring *ring;
+#endif /* HAVE_RXRING */
+
     assert(rfd != NULL);
+#ifdef HAVE_RXRING
+    ring = rfd->ring;
+#endif /* HAVE_RXRING */
+
+    for (int p = 0; p < PROTO_MAX; p++) {
+	if (rfd->buckets[p].drops)
+	    my_log(INFO, "dropped %u %s frames on %s in total",
+		rfd->buckets[p].drops, protos[p].name, rfd->name);
+    }
 
     if ((options & OPT_RECV) && !(options & OPT_DEBUG)) {
 	// unregister multicast membership
 	parent_multi(rfd, protos, 0);
 	// delete event
+#ifdef HAVE_RXRING
+	if (!rfd->ring)
+#endif /* HAVE_RXRING */
 	event_del(&rfd->event);
     }
 
     // cleanup
-    TAILQ_REMOVE(&rawfds, rfd, entries);
+    rfd_remove(&rawfds, rfd);
     if (rfd->p_handle)
 	pcap_close(rfd->p_handle);
     free(rfd);
 
+#ifdef HAVE_RXRING
+    // drop the hwaddr from the shared filter
+    if (ring)
+	ring->dirty = 1;
+#endif /* HAVE_RXRING */
+
     return;
 }
 
+// (re)build the index for all rawfds on the list
+static void rfd_hash_resize(struct rfdhead *rawfds, uint32_t size) {
+    struct rawfd *rfd, **bucket;
+
+    free(rawfds->hbuckets);
+    rawfds->hbuckets = my_calloc(size, sizeof(struct rawfd *));
+    rawfds->hsize = size;
+    rawfds->hcount = 0;
+
+    TAILQ_FOREACH(rfd, rawfds, entries) {
+	bucket = &rawfds->hbuckets[netif_hash_index(rfd->index) & (size - 1)];
+	rfd->hnext = *bucket;
+	*bucket = rfd;
+	rawfds->hcount++;
+    }
+}
+
+// rfd_byindex is used per frame, so the rawfds are indexed by ifindex
+void rfd_insert(struct rfdhead *rawfds, struct rawfd *rfd) {
+    struct rawfd **bucket;
+
+    assert((rawfds != NULL) && (rfd != NULL));
+
+    TAILQ_INSERT_TAIL(rawfds, rfd, entries);
+
+    // grow the index when it's fully loaded
+    if ((rawfds->hbuckets == NULL) || (rawfds->hcount >= rawfds->hsize)) {
+	rfd_hash_resize(rawfds,
+	    (rawfds->hbuckets) ? rawfds->hsize * 2 : RFD_HASH_MIN);
+	return;
+    }
+
+    bucket = &rawfds->hbuckets[netif_hash_index(rfd->index) &
+				(rawfds->hsize - 1)];
+    rfd->hnext = *bucket;
+    *bucket = rfd;
+    rawfds->hcount++;
+}
+
+void rfd_remove(struct rfdhead *rawfds, struct rawfd *rfd) {
+    struct rawfd **rp;
+
+    assert((rawfds != NULL) && (rfd != NULL));
+
+    rp = &rawfds->hbuckets[netif_hash_index(rfd->index) &
+			    (rawfds->hsize - 1)];
+    for (; *rp != NULL; rp = &(*rp)->hnext) {
+	if (*rp != rfd)
+	    continue;
+	*rp = rfd->hnext;
+	rawfds->hcount--;
+	break;
+    }
+    rfd->hnext = NULL;
+    TAILQ_REMOVE(rawfds, rfd, entries);
+}
+
 #if HAVE_LINUX_ETHTOOL_H
 ssize_t parent_ethtool(struct parent_req *mreq) {
     struct ifreq ifr = {};
     struct ethtool_cmd ecmd = {};
     struct ethtool_drvinfo edrvinfo = {};
+    struct parent_link_info link = {};
 
     assert(mreq != NULL);
 
     // prepare ifr struct
     strlcpy(ifr.ifr_name, mreq->name, IFNAMSIZ);
 
-    if (mreq->op == PARENT_ETHTOOL_GSET) { 
+    if (mreq->op == PARENT_ETHTOOL_GLINK) { 
+#if HAVE_DECL_ETHTOOL_GLINKSETTINGS
+	uint32_t ebuf[sizeof(struct ethtool_link_settings) / 4 + 3 * SCHAR_MAX];
+	struct ethtool_link_settings *elink = (void *)ebuf;
+	int nwords;
+
+	// the kernel reports the mask size on the first call
+	memset(ebuf, 0, sizeof(ebuf));
+	elink->cmd = ETHTOOL_GLINKSETTINGS;
+	ifr.ifr_data = (caddr_t)elink;
+
+	if ((ioctl(sock, SIOCETHTOOL, &ifr) == -1) ||
+	    (elink->link_mode_masks_nwords >= 0))
+	    goto legacy;
+
+	nwords = -elink->link_mode_masks_nwords;
+	memset(ebuf, 0, sizeof(ebuf));
+	elink->cmd = ETHTOOL_GLINKSETTINGS;
+	elink->link_mode_masks_nwords = nwords;
+
+	if (ioctl(sock, SIOCETHTOOL, &ifr) == -1)
+	    goto legacy;
+
+	link.speed = elink->speed;
+	link.duplex = elink->duplex;
+	link.port = elink->port;
+	link.autoneg = elink->autoneg;
+	for (int i = 0; (i < nwords) && (i < PARENT_LINK_NWORDS); i++) {
+	    link.supported[i] = elink->link_mode_masks[i];
+	    link.advertising[i] = elink->link_mode_masks[nwords + i];
+	}
+	goto out;
+
+legacy:
+#endif /* HAVE_DECL_ETHTOOL_GLINKSETTINGS */
+	// fallback for older kernels and drivers
 	ecmd.cmd = ETHTOOL_GSET;
 	ifr.ifr_data = (caddr_t)&ecmd;
 
 	if (ioctl(sock, SIOCETHTOOL, &ifr) == -1)
 	    return(0);
-	memcpy(mreq->buf, &ecmd, sizeof(ecmd));
-	return(sizeof(ecmd));
+
+	// the legacy masks match the first word of the link modes
+	link.speed = ethtool_cmd_speed(&ecmd);
+	link.duplex = ecmd.duplex;
+	link.port = ecmd.port;
+	link.autoneg = ecmd.autoneg;
+	link.supported[0] = ecmd.supported;
+	link.advertising[0] = ecmd.advertising;
+#if HAVE_DECL_ETHTOOL_GLINKSETTINGS
+out:
+#endif /* HAVE_DECL_ETHTOOL_GLINKSETTINGS */
+	memcpy(mreq->buf, &link, sizeof(link));
+	return(sizeof(link));
     } else if (mreq->op == PARENT_ETHTOOL_GDRV) { 
 	edrvinfo.cmd = ETHTOOL_GDRVINFO;
 	ifr.ifr_data = (caddr_t)&edrvinfo;
@@ -621,14 +947,167 @@ ssize_t parent_device_id(struct parent_req *mreq) {
 }
 #endif /* HAVE_SYSFS && HAVE_PCI_PCI_H */
 
+// generate the receive filter for the enabled protocols, frames sent
+// from hwaddr are rejected as well. returns the number of instructions
+int parent_filter(struct bpf_insn *insns, const uint8_t *hwaddrs, int count) {
+    static const uint8_t zero[ETHER_ADDR_LEN] = {};
+    struct bpf_insn *insn = insns;
+    const uint8_t *dst, *org, *hwaddr;
+    int h, p, q, llc;
+
+    assert((count == 0) || (hwaddrs != NULL));
+    assert(count <= FILTER_HWADDRS);
+
+#define FILTER(i)	(*insn++ = (struct bpf_insn)i)
+
+    // .1q vlan header
+    FILTER(BPF_STMT(BPF_LD+BPF_H+BPF_ABS, ETHER_ADDR_LEN * 2));
+    FILTER(BPF_JUMP(BPF_JMP+BPF_JEQ+BPF_K, ETHERTYPE_VLAN, 0, 1));
+    FILTER(BPF_STMT(BPF_LDX+BPF_W+BPF_IMM, ETHER_VLAN_ENCAP_LEN));
+
+    // frames we sent ourselves, skipping unknown and shared hwaddrs
+    for (h = 0; h < count; h++) {
+	hwaddr = hwaddrs + h * ETHER_ADDR_LEN;
+	if (memcmp(hwaddr, zero, ETHER_ADDR_LEN) == 0)
+	    continue;
+	for (q = 0; q < h; q++) {
+	    if (memcmp(hwaddrs + q * ETHER_ADDR_LEN, hwaddr,
+		    ETHER_ADDR_LEN) == 0)
+		break;
+	}
+	if (q < h)
+	    continue;
+
+	FILTER(BPF_STMT(BPF_LD+BPF_W+BPF_ABS, ETHER_ADDR_LEN));
+	FILTER(BPF_JUMP(BPF_JMP+BPF_JEQ+BPF_K, FILTER_W(hwaddr), 0, 3));
+	FILTER(BPF_STMT(BPF_LD+BPF_H+BPF_ABS, ETHER_ADDR_LEN + 4));
+	FILTER(BPF_JUMP(BPF_JMP+BPF_JEQ+BPF_K, FILTER_H(hwaddr + 4), 0, 1));
+	// reject
+	FILTER(BPF_STMT(BPF_RET+BPF_K, 0));
+    }
+
+    // lldp first, followed by the llc based protocols
+    for (llc = 0; llc <= 1; llc++) {
+
+	// llc dsap & ssap
+	if (llc) {
+	    FILTER(BPF_STMT(BPF_LD+BPF_H+BPF_IND, ETHER_HDR_LEN));
+	    FILTER(BPF_JUMP(BPF_JMP+BPF_JEQ+BPF_K, 0xAAAA, 1, 0));
+	    // reject
+	    FILTER(BPF_STMT(BPF_RET+BPF_K, 0));
+	}
+
+	for (p = 0; protos[p].name != NULL; p++) {
+
+	    // only enabled protos
+	    if ((protos[p].enabled == 0) && !(options & OPT_AUTO))
+		continue;
+	    if ((p != PROTO_LLDP) != llc)
+		continue;
+
+	    // protocol versions sharing an encapsulation
+	    for (q = 0; q < p; q++) {
+		if ((memcmp(protos[q].dst_addr, protos[p].dst_addr,
+			ETHER_ADDR_LEN) == 0) &&
+		    (memcmp(protos[q].llc_org, protos[p].llc_org,
+			sizeof(protos[p].llc_org)) == 0) &&
+		    (protos[q].llc_pid == protos[p].llc_pid) &&
+		    ((protos[q].enabled != 0) || (options & OPT_AUTO)))
+		    break;
+	    }
+	    if (q < p)
+		continue;
+
+	    // ether dst
+	    dst = protos[p].dst_addr;
+	    FILTER(BPF_STMT(BPF_LD+BPF_W+BPF_ABS, 0));
+	    FILTER(BPF_JUMP(BPF_JMP+BPF_JEQ+BPF_K, FILTER_W(dst), 0,
+		   (llc) ? 7 : 5));
+	    FILTER(BPF_STMT(BPF_LD+BPF_H+BPF_ABS, 4));
+	    FILTER(BPF_JUMP(BPF_JMP+BPF_JEQ+BPF_K, FILTER_H(dst + 4), 0,
+		   (llc) ? 5 : 3));
+
+	    if (llc) {
+		// llc control + org
+		org = protos[p].llc_org;
+		FILTER(BPF_STMT(BPF_LD+BPF_W+BPF_IND, ETH_LLC_CONTROL));
+		FILTER(BPF_JUMP(BPF_JMP+BPF_JEQ+BPF_K, FILTER_ORG(org), 0, 3));
+		// llc protoid
+		FILTER(BPF_STMT(BPF_LD+BPF_H+BPF_IND, ETH_LLC_PROTOID));
+		FILTER(BPF_JUMP(BPF_JMP+BPF_JEQ+BPF_K,
+		       protos[p].llc_pid, 0, 1));
+	    } else {
+		// ether proto
+		FILTER(BPF_STMT(BPF_LD+BPF_H+BPF_IND, ETHER_ADDR_LEN * 2));
+		FILTER(BPF_JUMP(BPF_JMP+BPF_JEQ+BPF_K, ETHERTYPE_LLDP, 0, 1));
+	    }
+	    // accept
+	    FILTER(BPF_STMT(BPF_RET+BPF_K, (u_int)-1));
+	}
+    }
+
+    // reject
+    FILTER(BPF_STMT(BPF_RET+BPF_K, 0));
+#undef FILTER
+
+    assert(insn - insns <= FILTER_MAX);
+    return(insn - insns);
+}
+
+// the hwaddr of an interface, left untouched when unknown
+static void parent_hwaddr(const char *name, uint8_t *hwaddr) {
+#if defined(SIOCGIFHWADDR)
+    struct ifreq ifr = {};
+
+    strlcpy(ifr.ifr_name, name, IFNAMSIZ);
+    if (ioctl(sock, SIOCGIFHWADDR, &ifr) == 0)
+	memcpy(hwaddr, ifr.ifr_hwaddr.sa_data, ETHER_ADDR_LEN);
+#elif defined(AF_LINK)
+    struct ifaddrs *ifaddrs, *ifaddr;
+    struct sockaddr_dl *saddrdl;
+
+    if (getifaddrs(&ifaddrs) < 0)
+	return;
+
+    for (ifaddr = ifaddrs; ifaddr != NULL; ifaddr = ifaddr->ifa_next) {
+	if ((ifaddr->ifa_addr == NULL) ||
+	    (ifaddr->ifa_addr->sa_family != AF_LINK) ||
+	    (strcmp(ifaddr->ifa_name, name) != 0))
+	    continue;
+	saddrdl = (struct sockaddr_dl *)ifaddr->ifa_addr;
+	if (saddrdl->sdl_alen == ETHER_ADDR_LEN)
+	    memcpy(hwaddr, LLADDR(saddrdl), ETHER_ADDR_LEN);
+	break;
+    }
+    freeifaddrs(ifaddrs);
+#endif
+}
+
 int parent_socket(struct rawfd *rfd) {
     pcap_t *p_handle = NULL;
     char p_errbuf[PCAP_ERRBUF_SIZE] = {};
     struct bpf_program fprog = {};
+    struct bpf_insn filter[FILTER_MAX];
 
     if (options & OPT_DEBUG)
 	return(dup(STDIN_FILENO));
 
+    // used to reject our own frames
+    if (options & OPT_RECV)
+	parent_hwaddr(rfd->name, rfd->hwaddr);
+
+#ifdef HAVE_RXRING
+    // all interfaces share a single packet ring
+    if ((options & OPT_RING) && (options & OPT_RECV)) {
+	if ((rxring.fd != -1) || (parent_ring_init(&rxring) == 0)) {
+	    rfd->ring = &rxring;
+	    return(rxring.fd);
+	}
+	my_log(CRIT, "packet ring unavailable, falling back to pcap");
+	options &= ~OPT_RING;
+    }
+#endif /* HAVE_RXRING */
+
     // newer libpcap versions need immediate_mode to work
     // so we use pcap_create/pcap_activate to set this up
 #if defined(HAVE_PCAP_CREATE)
@@ -663,8 +1142,8 @@ int parent_socket(struct rawfd *rfd) {
 
     // setup bpf receive
     if (options & OPT_RECV) {
-	fprog.bf_insns = proto_filter; 
-	fprog.bf_len = sizeof(proto_filter) / sizeof(struct bpf_insn);
+	fprog.bf_insns = filter;
+	fprog.bf_len = parent_filter(filter, rfd->hwaddr, 1);
     } else {
 	fprog.bf_insns = reject_filter; 
 	fprog.bf_len = sizeof(reject_filter) / sizeof(struct bpf_insn);
@@ -763,58 +1242,352 @@ void parent_multi(struct rawfd *rfd, struct proto *protos, int op) {
 }
 
 
+// detect the protocol of a frame, -1 if unknown
+int parent_recv_proto(const uint8_t *data) {
+    const struct ether_hdr *ether = (const struct ether_hdr *)data;
+
+    for (int p = 0; protos[p].name != NULL; p++) {
+	if (memcmp(protos[p].dst_addr, ether->dst, ETHER_ADDR_LEN) == 0)
+	    return(p);
+    }
+
+    my_log(INFO, "unknown message type received");
+    return(-1);
+}
+
+static uint64_t parent_recv_now() {
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0)
+	return(0);
+    return((uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+// token bucket per interface and protocol, returns 0 if the frame
+// should be dropped before it is copied for the child
+int parent_recv_limit(struct rawfd *rfd, int p, uint64_t now) {
+    struct rfd_bucket *bucket = &rfd->buckets[p];
+    uint32_t rate = (protos[p].rate) ? protos[p].rate : PARENT_RECV_RATE;
+    uint64_t max = (uint64_t)rate * PARENT_RECV_BURST * 1000;
+    uint64_t tokens = max;
+
+    // new buckets start full
+    if ((bucket->updated != 0) && (now >= bucket->updated))
+	tokens = bucket->tokens + (now - bucket->updated) * rate;
+    if (tokens > max)
+	tokens = max;
+    bucket->updated = now;
+
+    if (tokens < 1000) {
+	bucket->tokens = tokens;
+	if (bucket->drops++ == bucket->logged)
+	    my_log(WARN, "rate limiting %s frames on %s",
+		protos[p].name, rfd->name);
+	rdrops++;
+	return(0);
+    }
+    bucket->tokens = tokens - 1000;
+
+    // report the storm once it calmed down
+    if (bucket->drops != bucket->logged) {
+	my_log(WARN, "dropped %u %s frames on %s",
+	    bucket->drops - bucket->logged, protos[p].name, rfd->name);
+	bucket->logged = bucket->drops;
+    }
+    return(1);
+}
+
+// queue a received message for the child
+static void parent_recv_msg(struct parent_msg *mrecv, int p) {
+
+    mrecv->proto = p;
+    my_log(INFO, "received %s message (%zu bytes)",
+	    protos[p].name, mrecv->len);
+
+    if (++mcount == PARENT_MSG_BATCH)
+	parent_recv_flush();
+}
+
+// deliver the queued messages to the child in one go
+static void parent_recv_flush() {
+    int count = mcount;
+
+    if (count == 0)
+	return;
+    mcount = 0;
+
+    if (my_msend(mfd, mbatch, count) != count)
+	my_fatal("failed to send message to child");
+
+    rcount += count;
+    rbatch++;
+    my_log(DEBUG, "sent %d messages to child (%u messages in %u batches, "
+	    "%u dropped)", count, rcount, rbatch, rdrops);
+}
+
+
 void parent_recv(int fd, short event, struct rawfd *rfd) {
     // packet
-    struct parent_msg mrecv = {};
+    struct parent_msg *mrecv;
     struct pcap_pkthdr p_pkthdr = {};
     const unsigned char *data = NULL;
-    struct ether_hdr *ether;
-    static unsigned int rcount = 0;
+    uint64_t now = parent_recv_now();
     int p;
-    ssize_t len = 0;
 
     assert(rfd);
     assert(rfd->p_handle);
 
     while ((data = pcap_next(rfd->p_handle, &p_pkthdr)) != NULL) {
 
+	// skip small packets
+	if (p_pkthdr.caplen < (ETHER_MIN_LEN - ETHER_VLAN_ENCAP_LEN))
+	    continue;
+
+	if ((p = parent_recv_proto(data)) == -1)
+	    break;
+
+	// drop floods before copying them
+	if (!parent_recv_limit(rfd, p, now))
+	    continue;
+
+	mrecv = &mbatch[mcount];
+
 	// with valid sizes
 	if (p_pkthdr.caplen < ETHER_MAX_LEN)
-	    mrecv.len = p_pkthdr.caplen;
+	    mrecv->len = p_pkthdr.caplen;
 	else
-	    mrecv.len = ETHER_MAX_LEN;
+	    mrecv->len = ETHER_MAX_LEN;
 
-	memcpy(mrecv.msg, data, mrecv.len);
-
-	// skip small packets
-        if (mrecv.len < (ETHER_MIN_LEN - ETHER_VLAN_ENCAP_LEN))
-	    continue;
+	memcpy(mrecv->msg, data, mrecv->len);
 
 	// note the ifindex
-	mrecv.index = rfd->index;
+	mrecv->index = rfd->index;
 
-	ether = (struct ether_hdr *)mrecv.msg;
-	// detect the protocol
-	for (p = 0; protos[p].name != NULL; p++) {
-	    if (memcmp(protos[p].dst_addr, ether->dst, ETHER_ADDR_LEN) != 0)
-		continue;
+	parent_recv_msg(mrecv, p);
+    }
 
-	    mrecv.proto = p;
-	    break;
-	}
+    parent_recv_flush();
+}
 
-	if (protos[p].name == NULL) {
-	    my_log(INFO, "unknown message type received");
-	    return;
+#ifdef HAVE_RXRING
+int parent_ring_init(struct rxring *ring) {
+    struct tpacket_req3 req = {};
+    struct sockaddr_ll sll = {};
+    int version = TPACKET_V3;
+
+    assert(ring);
+
+    // the protocol is only set on bind, after the filter is in place
+    if ((ring->fd = socket(AF_PACKET, SOCK_RAW, 0)) == -1) {
+	my_loge(CRIT, "unable to open packet socket");
+	return(-1);
+    }
+
+    // no interfaces yet, updated by parent_open and parent_close
+    if (parent_ring_filter(ring) == -1)
+	goto failed;
+
+    if (setsockopt(ring->fd, SOL_PACKET, PACKET_VERSION,
+		&version, sizeof(version)) == -1) {
+	my_loge(CRIT, "unable to select TPACKET_V3");
+	goto failed;
+    }
+
+    req.tp_block_size = RXRING_BLOCK_SIZE;
+    req.tp_block_nr = RXRING_BLOCK_NR;
+    req.tp_frame_size = RXRING_FRAME_SIZE;
+    req.tp_frame_nr = (RXRING_BLOCK_SIZE / RXRING_FRAME_SIZE) * RXRING_BLOCK_NR;
+    req.tp_retire_blk_tov = RXRING_BLOCK_TMO;
+
+    if (setsockopt(ring->fd, SOL_PACKET, PACKET_RX_RING,
+		&req, sizeof(req)) == -1) {
+	my_loge(CRIT, "unable to configure packet ring");
+	goto failed;
+    }
+
+    ring->bsize = req.tp_block_size;
+    ring->bnum = req.tp_block_nr;
+    ring->block = 0;
+    ring->size = ring->bsize * ring->bnum;
+    ring->map = mmap(NULL, ring->size, PROT_READ|PROT_WRITE, MAP_SHARED,
+		     ring->fd, 0);
+    if (ring->map == MAP_FAILED) {
+	my_loge(CRIT, "unable to map packet ring");
+	ring->map = NULL;
+	goto failed;
+    }
+
+    // receive on all interfaces
+    sll.sll_family = AF_PACKET;
+    sll.sll_protocol = htons(ETH_P_ALL);
+    sll.sll_ifindex = 0;
+    if (bind(ring->fd, (struct sockaddr *)&sll, sizeof(sll)) == -1) {
+	my_loge(CRIT, "unable to bind packet ring");
+	goto failed;
+    }
+
+    // listen for received blocks
+    event_set(&ring->event, ring->fd, EV_READ|EV_PERSIST,
+	(void *)parent_ring_recv, ring);
+    event_add(&ring->event, NULL);
+
+    return(0);
+
+failed:
+    if (ring->map)
+	munmap(ring->map, ring->size);
+    ring->map = NULL;
+    close(ring->fd);
+    ring->fd = -1;
+    return(-1);
+}
+
+// the ring filter rejects frames sent from any of the ring interfaces,
+// subifs often share a hwaddr so each one is only included once
+int parent_ring_filter(struct rxring *ring) {
+    static const uint8_t zero[ETHER_ADDR_LEN] = {};
+    struct sock_fprog fprog = {};
+    struct bpf_insn filter[FILTER_MAX];
+    uint8_t hwaddrs[FILTER_HWADDRS][ETHER_ADDR_LEN] = {};
+    struct rawfd *rfd;
+    int count = 0, h, overflow = 0;
+
+    assert(ring);
+
+    TAILQ_FOREACH(rfd, &rawfds, entries) {
+	if ((rfd->ring != ring) ||
+	    (memcmp(rfd->hwaddr, zero, ETHER_ADDR_LEN) == 0))
+	    continue;
+	for (h = 0; h < count; h++) {
+	    if (memcmp(hwaddrs[h], rfd->hwaddr, ETHER_ADDR_LEN) == 0)
+		break;
 	}
-	my_log(INFO, "received %s message (%zu bytes)",
-		protos[p].name, mrecv.len);
+	if (h < count)
+	    continue;
+	if (count == FILTER_HWADDRS) {
+	    overflow = 1;
+	    continue;
+	}
+	memcpy(hwaddrs[count++], rfd->hwaddr, ETHER_ADDR_LEN);
+    }
 
-	len = write(mfd, &mrecv, PARENT_MSG_LEN(mrecv.len));
-	if (len != PARENT_MSG_LEN(mrecv.len))
-	    my_fatal("failed to send message to child");
-	rcount++;
+    if (overflow && !ring->overflow)
+	my_log(INFO, "more than %d hwaddrs on the packet ring, "
+	       "not all own frames are filtered", FILTER_HWADDRS);
+    ring->overflow = overflow;
+
+    // replaces the previous filter
+    fprog.filter = (struct sock_filter *)filter;
+    fprog.len = parent_filter(filter, hwaddrs[0], count);
+
+    if (setsockopt(ring->fd, SOL_SOCKET, SO_ATTACH_FILTER,
+		&fprog, sizeof(fprog)) == -1) {
+	my_loge(CRIT, "unable to configure packet ring filter");
+	return(-1);
     }
+
+    ring->dirty = 0;
+    return(0);
 }
 
+// rebuild the ring filter after interfaces were opened or closed
+static void parent_ring_flush() {
+    if ((rxring.fd != -1) && rxring.dirty)
+	parent_ring_filter(&rxring);
+}
+
+void parent_ring_recv(int fd, short event, struct rxring *ring) {
+    struct parent_msg *mrecv;
+    struct tpacket_block_desc *pbd;
+    struct tpacket3_hdr *hdr;
+    struct sockaddr_ll *sll;
+    struct rawfd *rfd;
+    uint8_t *data;
+    uint16_t tpid, tci;
+    size_t len, off;
+    uint64_t now = parent_recv_now();
+    int p;
+
+    assert(ring);
+    assert(ring->map);
+
+    // walk all the blocks handed to us by the kernel
+    for (;;) {
+	pbd = (struct tpacket_block_desc *)
+		(ring->map + (ring->block * ring->bsize));
+
+	if (!(pbd->hdr.bh1.block_status & TP_STATUS_USER))
+	    break;
+	__sync_synchronize();
+
+	hdr = (struct tpacket3_hdr *)
+		((uint8_t *)pbd + pbd->hdr.bh1.offset_to_first_pkt);
+
+	for (uint32_t i = 0; i < pbd->hdr.bh1.num_pkts; i++,
+	     hdr = (struct tpacket3_hdr *)((uint8_t *)hdr + hdr->tp_next_offset)) {
+
+	    sll = (struct sockaddr_ll *)
+		((uint8_t *)hdr + TPACKET_ALIGN(sizeof(struct tpacket3_hdr)));
+
+	    // only incoming packets on known interfaces
+	    if (sll->sll_pkttype == PACKET_OUTGOING)
+		continue;
+	    if ((rfd = rfd_byindex(&rawfds, sll->sll_ifindex)) == NULL)
+		continue;
+
+	    // drop unknown frames and floods before copying them
+	    data = (uint8_t *)hdr + hdr->tp_mac;
+	    if (hdr->tp_snaplen < ETHER_ADDR_LEN)
+		continue;
+	    if ((p = parent_recv_proto(data)) == -1)
+		continue;
+	    if (!parent_recv_limit(rfd, p, now))
+		continue;
+
+	    mrecv = &mbatch[mcount];
+	    len = hdr->tp_snaplen;
+	    off = 0;
+
+	    // re-insert the vlan tag stripped by the kernel
+	    if ((hdr->tp_status & TP_STATUS_VLAN_VALID) &&
+		(len >= ETHER_ADDR_LEN * 2)) {
+		tpid = htons(ETHERTYPE_VLAN);
+		if (hdr->tp_status & TP_STATUS_VLAN_TPID_VALID)
+		    tpid = htons(hdr->hv1.tp_vlan_tpid);
+		tci = htons(hdr->hv1.tp_vlan_tci);
+
+		memcpy(mrecv->msg, data, ETHER_ADDR_LEN * 2);
+		memcpy(mrecv->msg + ETHER_ADDR_LEN * 2, &tpid, sizeof(tpid));
+		memcpy(mrecv->msg + ETHER_ADDR_LEN * 2 + sizeof(tpid),
+			&tci, sizeof(tci));
+		off = ETHER_ADDR_LEN * 2;
+		data += off;
+		len -= off;
+		off += ETHER_VLAN_ENCAP_LEN;
+	    }
+
+	    // with valid sizes
+	    if (len > ETHER_MAX_LEN - off)
+		len = ETHER_MAX_LEN - off;
+	    memcpy(mrecv->msg + off, data, len);
+	    mrecv->len = off + len;
 
+	    // skip small packets
+	    if (mrecv->len < (ETHER_MIN_LEN - ETHER_VLAN_ENCAP_LEN))
+		continue;
+
+	    // note the ifindex
+	    mrecv->index = sll->sll_ifindex;
+
+	    parent_recv_msg(mrecv, p);
+	}
+
+	// return the block to the kernel
+	__sync_synchronize();
+	pbd->hdr.bh1.block_status = TP_STATUS_KERNEL;
+	ring->block = (ring->block + 1) % ring->bnum;
+    }
+
+    parent_recv_flush();
+}
+#endif /* HAVE_RXRING */
@@ -20,12 +20,60 @@
 #ifndef _parent_h
 #define _parent_h
 
-#ifdef HAVE_NETPACKET_PACKET_H
+#ifdef HAVE_LINUX_IF_PACKET_H
+#include <linux/if_packet.h>
+#elif defined(HAVE_NETPACKET_PACKET_H)
 #include <netpacket/packet.h>
 #endif /* HAVE_NETPACKET_PACKET_H */
 #include <pcap.h>
 #include <sys/ioctl.h>
 
+#if defined(HAVE_LINUX_IF_PACKET_H) && defined(HAVE_LINUX_FILTER_H) && \
+    HAVE_DECL_TPACKET_V3
+#define HAVE_RXRING	1
+#endif
+
+#ifdef HAVE_RXRING
+// shared TPACKET_V3 receive ring
+#define RXRING_BLOCK_SIZE	(1 << 16)
+#define RXRING_BLOCK_NR		16
+#define RXRING_FRAME_SIZE	(1 << 11)
+#define RXRING_BLOCK_TMO	10
+
+struct rxring {
+    int fd;
+    struct event event;
+
+    uint8_t *map;
+    size_t size;
+    unsigned int bsize;
+    unsigned int bnum;
+    unsigned int block;
+
+    // the filter needs a rebuild, see parent_ring_filter
+    uint8_t dirty;
+    uint8_t overflow;
+};
+#endif /* HAVE_RXRING */
+
+// received frames per second per interface and protocol,
+// bursts of up to PARENT_RECV_BURST seconds are accepted
+#define PARENT_RECV_RATE	10
+#define PARENT_RECV_BURST	2
+
+// token bucket, in thousandths of a frame
+struct rfd_bucket {
+    uint32_t tokens;
+    uint64_t updated;
+    uint32_t drops;
+    uint32_t logged;
+};
+
+// room for the receive filter generated by parent_filter(), at most
+// 3 vlan + 5 per hwaddr + 3 llc + 9 per protocol + 1 reject instructions
+#define FILTER_HWADDRS	32
+#define FILTER_MAX	(3 + 5 * FILTER_HWADDRS + 3 + 9 * PROTO_MAX + 1)
+
 struct rawfd {
     uint32_t index;
     char name[IFNAMSIZ];
@@ -33,16 +81,45 @@ struct rawfd {
     struct event event;
 
     pcap_t *p_handle;
+    uint8_t hwaddr[ETHER_ADDR_LEN];
+#ifdef HAVE_RXRING
+    struct rxring *ring;
+#endif /* HAVE_RXRING */
+
+    // receive rate limits, see parent_recv_limit
+    struct rfd_bucket buckets[PROTO_MAX];
+
+    // hashed index chain, see rfd_insert
+    struct rawfd *hnext;
 
     // should be last
     TAILQ_ENTRY(rawfd) entries;
 };
 
-TAILQ_HEAD(rfdhead, rawfd);
+#define RFD_HASH_MIN	64
+
+// a TAILQ_HEAD with a hashed index by ifindex
+struct rfdhead {
+    struct rawfd *tqh_first;
+    struct rawfd **tqh_last;
+
+    struct rawfd **hbuckets;
+    uint32_t hsize;
+    uint32_t hcount;
+};
 
 void parent_req(int fd, short event);
+void parent_req_op(struct parent_req *mreq);
 void parent_send(int fd, short event);
+void parent_send_group(struct parent_msg *msgs[], int count);
 void parent_recv(int fd, short event, struct rawfd *rfd);
+int parent_recv_proto(const uint8_t *data);
+int parent_recv_limit(struct rawfd *rfd, int proto, uint64_t now);
+#ifdef HAVE_RXRING
+int parent_ring_init(struct rxring *ring);
+int parent_ring_filter(struct rxring *ring);
+void parent_ring_recv(int fd, short event, struct rxring *ring);
+#endif /* HAVE_RXRING */
 
 int parent_open(const uint32_t index, const char *name);
 #if HAVE_LINUX_ETHTOOL_H
@@ -58,17 +135,25 @@ ssize_t parent_device(struct parent_req *mreq);
 #if defined(HAVE_SYSFS) && defined(HAVE_PCI_PCI_H)
 ssize_t parent_device_id(struct parent_req *mreq);
 #endif /* HAVE_SYSFS && HAVE_PCI_PCI_H */
+void parent_refresh(struct rawfd *rfd);
 void parent_close(struct rawfd *rfd);
+void rfd_insert(struct rfdhead *rawfds, struct rawfd *rfd);
+void rfd_remove(struct rfdhead *rawfds, struct rawfd *rfd);
 
 int parent_check(struct parent_req *mreq);
 int parent_socket(struct rawfd *rfd);
+int parent_filter(struct bpf_insn *, const uint8_t *hwaddrs, int count);
 void parent_multi(struct rawfd *rfd, struct proto *protos, int op);
 
 static inline
 struct rawfd *rfd_byindex(struct rfdhead *rawfds, uint32_t index) {
     struct rawfd *rfd = NULL;
 
-    TAILQ_FOREACH(rfd, rawfds, entries) {
+    if (rawfds->hbuckets == NULL)
+	return(NULL);
+
+    rfd = rawfds->hbuckets[netif_hash_index(index) & (rawfds->hsize - 1)];
+    for (; rfd != NULL; rfd = rfd->hnext) {
 	if (rfd->index == index)
 	    break;
     }
@@ -499,15 +499,13 @@ static int cdp_system_name(struct parent_msg *msg,
 
     char *str = NULL;
 
-    str = tlv_str_copy(pos, length);
+    str = tlv_str_copy(msg, pos, length);
 
-    if (msg->decode == DECODE_PRINT) {
+    if (msg->decode == DECODE_PRINT)
     	printf("%s: %s\n", 
 	    (tlv_type == CDP_TYPE_DEVICE_ID)? "Device ID":"System Name", str);
-	free(str);
-    } else {
+    else
 	PEER_STR(msg->peer[PEER_HOSTNAME], str);
-    }
 
     return 1;
 }
@@ -517,15 +515,13 @@ static int cdp_port_id(struct parent_msg *msg,
 
     char *str = NULL;
 
-    str = tlv_str_copy(pos, length);
+    str = tlv_str_copy(msg, pos, length);
 
-    if (msg->decode == DECODE_PRINT) {
+    if (msg->decode == DECODE_PRINT)
 	printf("Interface: %s, Port ID (outgoing port): %s\n",
 	    msg->name, str);
-	free(str);
-    } else {
+    else
 	PEER_STR(msg->peer[PEER_PORTNAME], str);
-    }
 
     return 1;
 }
@@ -582,13 +578,11 @@ static int cdp_system_cap(struct parent_msg *msg,
     cap |= (cdp_cap & CDP_CAP_REPEATER) ? CAP_REPEATER : 0;
     cap |= (cdp_cap & CDP_CAP_PHONE) ? CAP_PHONE : 0;
 
-    str = tlv_str_cap(cap);
-    if (msg->decode == DECODE_PRINT) {
+    str = tlv_str_cap(msg, cap);
+    if (msg->decode == DECODE_PRINT)
         printf("Capabilities: %s\n", str);
-        free(str);
-    } else {
+    else
         PEER_STR(msg->peer[PEER_CAP], str);
-    }
 
     return 1;
 }
@@ -644,18 +638,16 @@ next_addr:
     }
 
     if (af) {
-	if ((str = tlv_str_addr(af, pos, al)) == NULL) {
+	if ((str = tlv_str_addr(msg, af, pos, al)) == NULL) {
 	    my_log(INFO, "Corrupt CDP packet: invalid address TLV");
 	    return 0;
 	}
 
-	if (msg->decode == DECODE_PRINT) {
+	if (msg->decode == DECODE_PRINT)
 	    printf("  IP%s address: %s\n", 
 		(af == PEER_ADDR_INET6)? "v6":"", str);
-	    free(str);
-	} else {
+	else
 	    PEER_STR(msg->peer[af], str);
-	}
     } 
     if (!SKIP(al)) {
 	my_log(INFO, "Corrupt CDP packet: invalid TLV length");
@@ -682,9 +674,11 @@ static int cdp_vlan(struct parent_msg *msg,
 
     if (msg->decode == DECODE_PRINT)
 	printf("Native VLAN: %" PRIu16 "\n", vlan);
-    else
-	if (asprintf(&str, "%" PRIu16, vlan) > 0)
-	    PEER_STR(msg->peer[PEER_VLAN_ID], str);
+    else {
+	str = peer_alloc(msg, sizeof("65535"));
+	snprintf(str, sizeof("65535"), "%" PRIu16, vlan);
+	PEER_STR(msg->peer[PEER_VLAN_ID], str);
+    }
 
     return 1;
 }
@@ -708,14 +702,12 @@ static int cdp_vtp(struct parent_msg *msg,
 
     char *str = NULL;
 
-    str = tlv_str_copy(pos, length);
+    str = tlv_str_copy(msg, pos, length);
 
-    if (msg->decode == DECODE_PRINT) {
+    if (msg->decode == DECODE_PRINT)
 	printf("VTP Management Domain: '%s'\n", str);
-	free(str);
-    } else {
+    else
 	PEER_STR(msg->peer[PEER_VTP_MD], str);
-    }
 
     return 1;
 }
@@ -752,9 +744,11 @@ static int cdp_duplex(struct parent_msg *msg,
 
     if (msg->decode == DECODE_PRINT)
 	printf("Duplex: %" PRIu8 "\n", duplex);
-    else
-        if (asprintf(&str, "%" PRIu8, duplex) > 0)
-		PEER_STR(msg->peer[PEER_DUPLEX], str);
+    else {
+	str = peer_alloc(msg, sizeof("255"));
+	snprintf(str, sizeof("255"), "%" PRIu8, duplex);
+	PEER_STR(msg->peer[PEER_DUPLEX], str);
+    }
 
     return 1;
 }
@@ -765,14 +759,12 @@ static int cdp_platform(struct parent_msg *msg,
 
     char *str = NULL;
 
-    str = tlv_str_copy(pos, length);
+    str = tlv_str_copy(msg, pos, length);
 
-    if (msg->decode == DECODE_PRINT) {
+    if (msg->decode == DECODE_PRINT)
 	printf("Platform: %s\n", str);
-	free(str);
-    } else {
+    else
 	PEER_STR(msg->peer[PEER_PLATFORM], str);
-    }
 
     return 1;
 }
@@ -289,7 +289,6 @@ size_t fdp_decode(struct parent_msg *msg) {
 		else if (strcmp(cap_str, "Host") == 0)
 		   cap |= CAP_HOST; 
 		tlv_value_str(msg, PEER_CAP, sizeof(cap), &cap);
-		free(cap_str);
 		break;
 	default:
 		my_log(DEBUG, "unknown TLV: type %d, length %d, leaves %zu",
@@ -45,7 +45,8 @@ static tlv_t type;
 static int lldp_port_id(struct parent_msg *, unsigned char *, size_t);
 static int lldp_chassis_id(struct parent_msg *, unsigned char *, size_t);
 static int lldp_system_name(struct parent_msg *, unsigned char *, size_t);
-static int lldp_descr_print(uint16_t, unsigned char *, size_t);
+static int lldp_descr_print(struct parent_msg *, uint16_t,
+	unsigned char *, size_t);
 static int lldp_ttl_print(struct parent_msg *msg);
 static int lldp_system_cap(struct parent_msg *, unsigned char *, size_t);
 static int lldp_mgmt_addr(struct parent_msg *msg, unsigned char *, size_t);
@@ -546,11 +547,11 @@ size_t lldp_decode(struct parent_msg *msg) {
 	    case LLDP_TYPE_PORT_DESCR:
 		if (msg->decode == DECODE_STR)
 		    PEER_STR(msg->peer[PEER_PORTDESCR], 
-			     tlv_str_copy(pos, tlv_length));
+			     tlv_str_copy(msg, pos, tlv_length));
 		/* FALLTHROUGH */
 	    case LLDP_TYPE_SYSTEM_DESCR:
 		if ((msg->decode == DECODE_PRINT) && 
-		    !lldp_descr_print(tlv_type, pos, tlv_length))
+		    !lldp_descr_print(msg, tlv_type, pos, tlv_length))
 		    return 0;
 		break;
 	    case LLDP_TYPE_SYSTEM_CAP:
@@ -616,25 +617,23 @@ static int lldp_chassis_id(struct parent_msg *msg,
 	case LLDP_CHASSIS_PORT_COMP_SUBTYPE:
 	case LLDP_CHASSIS_INTF_NAME_SUBTYPE:
 	case LLDP_CHASSIS_LOCAL_SUBTYPE:
-	    str = tlv_str_copy(pos, length);
+	    str = tlv_str_copy(msg, pos, length);
 	    break;
 	case LLDP_CHASSIS_MAC_ADDR_SUBTYPE:
-	    str = tlv_str_addr(PEER_ADDR_802, pos, length);
+	    str = tlv_str_addr(msg, PEER_ADDR_802, pos, length);
 	    break;
 	case LLDP_CHASSIS_NETWORK_ADDR_SUBTYPE:
 	    if (!GRAB_UINT8(lldp_afnum)) {
 		my_log(INFO, "Invalid LLDP packet: invalid Chassis ID TLV");
 		return 0;
 	    }
-	    str = tlv_str_addr(lldp_afnum, pos, length);
+	    str = tlv_str_addr(msg, lldp_afnum, pos, length);
 	    break;
 	default:
 	    break;
     }
-    if (str) {
+    if (str)
 	printf("Chassis id: %s\n", str);
-	free(str);
-    }
     return 1;
 }
 
@@ -661,19 +660,16 @@ static int lldp_port_id(struct parent_msg *msg,
 	case LLDP_PORT_INTF_NAME_SUBTYPE:
 	case LLDP_PORT_AGENT_CIRC_ID_SUBTYPE:
 	case LLDP_PORT_LOCAL_SUBTYPE:
-	    str = tlv_str_copy(pos, length);
-	    if (msg->decode == DECODE_PRINT) {
+	    str = tlv_str_copy(msg, pos, length);
+	    if (msg->decode == DECODE_PRINT)
 	    	printf("Port id: %s\n", str);
-		free(str);
-	    } else {
+	    else
 		PEER_STR(msg->peer[PEER_PORTNAME], str);
-	    }
 	    break;
 	case LLDP_PORT_MAC_ADDR_SUBTYPE:
 	    if (msg->decode == DECODE_PRINT) {
-		str = tlv_str_addr(PEER_ADDR_802, pos, length);
+		str = tlv_str_addr(msg, PEER_ADDR_802, pos, length);
 	    	printf("Port id: %s\n", str);
-		free(str);
 	    }
 	    break;
 	default:
@@ -697,7 +693,7 @@ static int lldp_system_name(struct parent_msg *msg,
 	return 0;
     }
 
-    str = tlv_str_copy(pos, length);
+    str = tlv_str_copy(msg, pos, length);
 
     if (msg->decode == DECODE_PRINT)
     	printf("System Name: %s\n", str);
@@ -708,7 +704,7 @@ static int lldp_system_name(struct parent_msg *msg,
     return 1;
 }
 
-static int lldp_descr_print(uint16_t tlv_type,
+static int lldp_descr_print(struct parent_msg *msg, uint16_t tlv_type,
     unsigned char *pos, size_t length) {
 
     const struct type_str *token;
@@ -727,7 +723,7 @@ static int lldp_descr_print(uint16_t tlv_type,
     if (!type_str)
 	type_str = "Unknown";
 
-    str = tlv_str_copy(pos, length);
+    str = tlv_str_copy(msg, pos, length);
     if (strchr(str, '\n')) {
 	printf("%s:\n", type_str);
 	while ((token_str = strsep(&str, "\n")) != NULL)
@@ -735,7 +731,6 @@ static int lldp_descr_print(uint16_t tlv_type,
     } else {
 	printf("%s: %s\n", type_str, str);
     }
-    free(str);
 
     return 1;
 }
@@ -790,9 +785,8 @@ static int lldp_system_cap(struct parent_msg *msg,
     }
 
     if (msg->decode == DECODE_PRINT) {
-	str = tlv_str_cap(cap_avail);
+	str = tlv_str_cap(msg, cap_avail);
 	printf("System Capabilities: %s\n", str);
-	free(str);
     }
 
     if (lldp_cap == LLDP_CAP_STATION_ONLY) {
@@ -807,13 +801,11 @@ static int lldp_system_cap(struct parent_msg *msg,
 	cap |= (lldp_cap & LLDP_CAP_DOCSIS) ? CAP_DOCSIS : 0;
     }
 
-    str = tlv_str_cap(cap);
-    if (msg->decode == DECODE_PRINT) {
+    str = tlv_str_cap(msg, cap);
+    if (msg->decode == DECODE_PRINT)
 	printf("Enabled Capabilities: %s\n", str);
-	free(str);
-    } else {
+    else
 	PEER_STR(msg->peer[PEER_CAP], str);
-    }
 
     return 1;
 }
@@ -864,17 +856,15 @@ static int lldp_mgmt_addr(struct parent_msg *msg,
     if ((msg->decode == DECODE_STR) && msg->peer[af]) 
 	return 1;
 
-    if ((str = tlv_str_addr(af, pos, lldp_aflen)) == NULL) {
+    if ((str = tlv_str_addr(msg, af, pos, lldp_aflen)) == NULL) {
 	my_log(INFO, "Invalid LLDP packet: invalid mgmt addr");
 	return 0;
     }
 
-    if (msg->decode == DECODE_PRINT) {
+    if (msg->decode == DECODE_PRINT)
 	printf("Management Address %s: %s\n", astr, str);
-	free(str);
-    } else {
+    else
 	PEER_STR(msg->peer[af], str);
-    }
 
     return 1;
 }
@@ -892,7 +882,6 @@ static int lldp_private(struct parent_msg *msg,
     if (memcmp(oui, OUI_IEEE_8021_PRIVATE, OUI_LEN) == 0)
 	ret = lldp_private_8021(msg, pos, length);
 
-    free(oui);
     return ret;
 }
 
@@ -917,9 +906,11 @@ static int lldp_private_8021(struct parent_msg *msg,
 
 	    if (msg->decode == DECODE_PRINT)
 		printf("Port VLAN ID: %" PRIu16 "\n", vlan_id);
-	    else
-		if (asprintf(&str, "%" PRIu16, vlan_id) > 0)
-		    PEER_STR(msg->peer[PEER_VLAN_ID], str);
+	    else {
+		str = peer_alloc(msg, sizeof("65535"));
+		snprintf(str, sizeof("65535"), "%" PRIu16, vlan_id);
+		PEER_STR(msg->peer[PEER_VLAN_ID], str);
+	    }
 	    break;
 	default:
 	    break;
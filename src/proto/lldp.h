@@ -158,6 +158,31 @@
 #define LLDP_MAU_TYPE_10GBASE_PR_D3	67
 #define LLDP_MAU_TYPE_10GBASE_PR_U1	68
 #define LLDP_MAU_TYPE_10GBASE_PR_U3	69
+// From the IANA-MAU-MIB revisions by RFC 7257 and later
+#define LLDP_MAU_TYPE_40GBASE_KR4	70
+#define LLDP_MAU_TYPE_40GBASE_CR4	71
+#define LLDP_MAU_TYPE_40GBASE_SR4	72
+#define LLDP_MAU_TYPE_40GBASE_FR	73
+#define LLDP_MAU_TYPE_40GBASE_LR4	74
+#define LLDP_MAU_TYPE_100GBASE_CR10	75
+#define LLDP_MAU_TYPE_100GBASE_SR10	76
+#define LLDP_MAU_TYPE_100GBASE_LR4	77
+#define LLDP_MAU_TYPE_100GBASE_ER4	78
+#define LLDP_MAU_TYPE_25GBASE_CR	87
+#define LLDP_MAU_TYPE_25GBASE_CR_S	88
+#define LLDP_MAU_TYPE_25GBASE_KR	89
+#define LLDP_MAU_TYPE_25GBASE_KR_S	90
+#define LLDP_MAU_TYPE_25GBASE_R		91
+#define LLDP_MAU_TYPE_25GBASE_SR	92
+#define LLDP_MAU_TYPE_25GBASE_T		93
+#define LLDP_MAU_TYPE_40GBASE_ER4	94
+#define LLDP_MAU_TYPE_40GBASE_R		95
+#define LLDP_MAU_TYPE_40GBASE_T		96
+#define LLDP_MAU_TYPE_100GBASE_CR4	97
+#define LLDP_MAU_TYPE_100GBASE_KR4	98
+#define LLDP_MAU_TYPE_100GBASE_KP4	99
+#define LLDP_MAU_TYPE_100GBASE_R	100
+#define LLDP_MAU_TYPE_100GBASE_SR4	101
 
 // From RFC 3636 - ifMauAutoNegCapAdvertisedBits
 #define	LLDP_MAU_PMD_OTHER		(1 <<  15)
@@ -27,11 +27,9 @@
 
 void tlv_value_str(struct parent_msg *msg,
 	    uint16_t type, uint16_t length, void *value) {
-    char src[TLV_LEN], *str = NULL;
-    size_t srclen, len;
+    char vis[TLV_LEN * 4], *str = NULL;
     uint16_t cap, i, j = 0;
     const char *cap_str = CAP_STRING;
-    uint8_t *addr = NULL;
 
     // skip if not wanted or already decoded
     if (msg->peer[type])
@@ -40,46 +38,22 @@ void tlv_value_str(struct parent_msg *msg,
     switch (type) {
 	case PEER_HOSTNAME:
 	case PEER_PORTNAME:
-	    srclen = MIN(length, TLV_LEN - 1);
-	    memcpy(src, value, srclen);
-	    *(src + srclen) = '\0';
-	    len = srclen * 4 + 1;
-	    str = my_malloc(len);
-	    strnvis(str, src, len, VIS_NL|VIS_TAB|VIS_GLOB|VIS_OCTAL);
+	    my_strnvis(vis, value, MIN(length, TLV_LEN - 1),
+		       VIS_NL|VIS_TAB|VIS_GLOB|VIS_OCTAL);
+	    str = peer_strdup(msg, vis);
 	    break;
 	case PEER_CAP:
 	    memcpy(&cap, value, sizeof(uint16_t));
-	    str = my_malloc(CAP_MAX + 1);
+	    str = peer_alloc(msg, CAP_MAX + 1);
 	    for (i = 0; i < CAP_MAX; i++) {
 		if (cap & (1 << i))
 		    str[j++] = cap_str[i];
 	    }
 	    break;
 	case PEER_ADDR_INET4:
-	    if (length != 4)
-		return;
-	    str = my_malloc(INET_ADDRSTRLEN);
-	    if (!inet_ntop(AF_INET, value, str, INET_ADDRSTRLEN)) {
-		free(str);
-		str = NULL;
-	    }
-	    break;
 	case PEER_ADDR_INET6:
-	    if (length != 16)
-		return;
-	    str = my_malloc(INET6_ADDRSTRLEN);
-	    if (!inet_ntop(AF_INET6, value, str, INET6_ADDRSTRLEN)) {
-		free(str);
-		str = NULL;
-	    }
-	    break;
 	case PEER_ADDR_802:
-	    addr = value;
-	    if (length != ETHER_ADDR_LEN)
-		return;
-	    if (asprintf(&str, "%02x:%02x:%02x:%02x:%02x:%02x",
-		addr[0], addr[1], addr[2], addr[3], addr[4], addr[5]) == -1)
-		str = NULL;
+	    str = tlv_str_addr(msg, type, value, length);
 	    break;
 	default:
 	    my_fatal("unhandled type %d", type);
@@ -89,25 +63,19 @@ void tlv_value_str(struct parent_msg *msg,
 	msg->peer[type] = str;
 }
 
-char * tlv_str_copy(void *pos, size_t length) {
-    char str[TLV_LEN], *safe = NULL;
-    size_t srclen, len;
+char * tlv_str_copy(struct parent_msg *msg, void *pos, size_t length) {
+    char safe[TLV_LEN * 4];
 
-    srclen = MIN(length, TLV_LEN - 1);
-    memcpy(str, pos, srclen);
-    *(str + srclen) = '\0';
-    len = srclen * 4 + 1;
-    safe = my_malloc(len);
-    strnvis(safe, str, len, VIS_SAFE|VIS_OCTAL);
-    return safe;
+    my_strnvis(safe, pos, MIN(length, TLV_LEN - 1), VIS_SAFE|VIS_OCTAL);
+    return peer_strdup(msg, safe);
 }
 
-char * tlv_str_cap(uint16_t cap) {
+char * tlv_str_cap(struct parent_msg *msg, uint16_t cap) {
     char *str = NULL;
     uint16_t i, j = 0;
     const char *cap_str = CAP_STRING;
 
-    str = my_malloc(CAP_MAX + 1);
+    str = peer_alloc(msg, CAP_MAX + 1);
     for (i = 0; i < CAP_MAX; i++) {
 	if (cap & (1 << i))
 	    str[j++] = cap_str[i];
@@ -115,42 +83,36 @@ char * tlv_str_cap(uint16_t cap) {
     return str;
 }
 
-char * tlv_str_addr(uint8_t type, void *pos, size_t length) {
-    char *str = NULL;
+char * tlv_str_addr(struct parent_msg *msg, uint8_t type,
+		    void *pos, size_t length) {
+    char str[INET6_ADDRSTRLEN];
     uint8_t *addr = NULL;
 
     switch(type) {
 	case PEER_ADDR_INET4:
 	    if (length != 4)
 		return NULL;
-	    str = my_malloc(INET_ADDRSTRLEN);
-	    if (!inet_ntop(AF_INET, pos, str, INET_ADDRSTRLEN)) {
-		free(str);
+	    if (!inet_ntop(AF_INET, pos, str, sizeof(str)))
 		return NULL;
-	    }
 	    break;
 	case PEER_ADDR_INET6:
 	    if (length != 16)
 		return NULL;
-	    str = my_malloc(INET6_ADDRSTRLEN);
-	    if (!inet_ntop(AF_INET6, pos, str, INET6_ADDRSTRLEN)) {
-		free(str);
+	    if (!inet_ntop(AF_INET6, pos, str, sizeof(str)))
 		return NULL;
-	    }
 	    break;
 	case PEER_ADDR_802:
 	    addr = pos;
 	    if (length != ETHER_ADDR_LEN)
 		return NULL;
-	    if (asprintf(&str, "%02x:%02x:%02x:%02x:%02x:%02x",
-		addr[0], addr[1], addr[2], addr[3], addr[4], addr[5]) == -1)
-		str = NULL;
+	    snprintf(str, sizeof(str), "%02x:%02x:%02x:%02x:%02x:%02x",
+		addr[0], addr[1], addr[2], addr[3], addr[4], addr[5]);
 	    break;
 	default:
 	    // unhandled type
 	    return NULL;
     }
 
-    return str;
+    return peer_strdup(msg, str);
 }
 
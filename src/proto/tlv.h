@@ -29,9 +29,9 @@
  */
 
 void tlv_value_str(struct parent_msg *, uint16_t, uint16_t, void *);
-char * tlv_str_copy(void *pos, size_t length);
-char * tlv_str_cap(uint16_t cap);
-char * tlv_str_addr(uint8_t type, void *pos, size_t length);
+char * tlv_str_copy(struct parent_msg *, void *pos, size_t length);
+char * tlv_str_cap(struct parent_msg *, uint16_t cap);
+char * tlv_str_addr(struct parent_msg *, uint8_t type, void *pos, size_t length);
 #define TLV_LEN	    512
 
 #define VOIDP_DIFF(P, Q) ((uintptr_t)((char *)(P) - (char *)(Q)))
@@ -78,7 +78,7 @@ typedef union {
 #define GRAB_BYTES(d, b) \
 	((length >= (b)) && \
 	    ( \
-		d = my_malloc((b)), \
+		d = peer_alloc(msg, (b)), \
 		memcpy((d), pos, (b)), \
 		length -= (b), \
 		pos += (b), \
@@ -87,9 +87,8 @@ typedef union {
 #define GRAB_STRING(d, b) \
 	((length >= (b)) && \
 	    ( \
-		d = my_malloc((b) + 1), \
+		d = peer_alloc(msg, (b) + 1), \
 		memcpy((d), pos, (b)), \
-		*(d + b) = '\0', \
 		length -= (b), \
 		pos += (b), \
 		1 \
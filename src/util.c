@@ -22,8 +22,19 @@
 #include <syslog.h>
 #include <grp.h>
 #include <sys/resource.h>
+#include <sys/mman.h>
 #include <pcap.h>
 
+// simd kernels for the codec path, see my_simd_select
+#if defined(__GNUC__) && \
+    (defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__)))
+#define HAVE_SIMD_X86	1
+#include <immintrin.h>
+#elif defined(__GNUC__) && defined(__aarch64__) && defined(__ARM_NEON)
+#define HAVE_SIMD_NEON	1
+#include <arm_neon.h>
+#endif
+
 int8_t loglevel = CRIT;
 int msock = -1;
 pid_t pid = 0;
@@ -94,6 +105,14 @@ void * my_calloc(size_t nmemb, size_t size) {
     return(ptr);
 }
 
+void * my_realloc(void *ptr, size_t size) {
+
+    if ((ptr = realloc(ptr, size)) == NULL)
+	my_fatal("realloc failed");
+
+    return(ptr);
+}
+
 char * my_strdup(const char *str) {
     char *cstr;
 
@@ -255,48 +274,1460 @@ int write_line(const char *path, char *line, uint16_t len) {
     return(0);
 }
 
+// crc-32 (ieee 802.3), the table is built on first use
+uint32_t my_crc32(const void *data, size_t length) {
+    static uint32_t table[256];
+    const uint8_t *d = data;
+    uint32_t crc = 0xffffffff;
+
+    if (unlikely(table[1] == 0)) {
+	for (uint32_t i = 0; i < 256; i++) {
+	    uint32_t c = i;
+	    for (int k = 0; k < 8; k++)
+		c = (c & 1) ? (0xedb88320 ^ (c >> 1)) : (c >> 1);
+	    table[i] = c;
+	}
+    }
+
+    while (length--)
+	crc = table[(crc ^ *d++) & 0xff] ^ (crc >> 8);
+    return(~crc);
+}
+
+// the ones' complement sum doesn't depend on the word size, so the
+// kernels add up 32-bit lanes and my_chksum folds the result
+static uint64_t chksum_scalar(const uint8_t *d, size_t len) {
+    uint64_t sum = 0;
+    uint32_t w32;
+    uint16_t w16;
+
+    for (; len >= sizeof(w32); d += sizeof(w32), len -= sizeof(w32)) {
+	memcpy(&w32, d, sizeof(w32));
+	sum += w32;
+    }
+    if (len >= sizeof(w16)) {
+	memcpy(&w16, d, sizeof(w16));
+	sum += w16;
+    }
+    return(sum);
+}
+
+// bytes copied as is by my_strnvis, everything else goes via vis()
+static inline int vis_plain(uint8_t c, int flag) {
+    if ((c < ' ') || (c > '~') || (c == '\\'))
+	return(0);
+    if ((flag & VIS_SP) && (c == ' '))
+	return(0);
+    if ((flag & VIS_GLOB) &&
+	((c == '*') || (c == '?') || (c == '[') || (c == '#')))
+	return(0);
+    return(1);
+}
+
+static size_t vis_run_scalar(char *dst, const uint8_t *s, size_t len,
+			     int flag) {
+    size_t n;
+
+    for (n = 0; (n < len) && vis_plain(s[n], flag); n++)
+	dst[n] = s[n];
+    return(n);
+}
+
+// the 32-bit lanes are flushed before they can overflow
+#define SIMD_FLUSH	0x8000
+
+#ifdef HAVE_SIMD_X86
+__attribute__((target("sse2")))
+static uint64_t chksum_sse2(const uint8_t *d, size_t len) {
+    __m128i zero = _mm_setzero_si128(), acc = zero, v;
+    uint32_t lanes[4];
+    uint64_t sum = 0;
+    size_t n = 0;
+
+    for (; len >= sizeof(v); d += sizeof(v), len -= sizeof(v)) {
+	v = _mm_loadu_si128((const __m128i *)d);
+	acc = _mm_add_epi32(acc, _mm_unpacklo_epi16(v, zero));
+	acc = _mm_add_epi32(acc, _mm_unpackhi_epi16(v, zero));
+	if ((++n == SIMD_FLUSH) || (len < 2 * sizeof(v))) {
+	    _mm_storeu_si128((__m128i *)lanes, acc);
+	    sum += (uint64_t)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+	    acc = zero;
+	    n = 0;
+	}
+    }
+    return(sum + chksum_scalar(d, len));
+}
+
+__attribute__((target("avx2")))
+static uint64_t chksum_avx2(const uint8_t *d, size_t len) {
+    __m256i zero = _mm256_setzero_si256(), acc = zero, v;
+    uint32_t lanes[8];
+    uint64_t sum = 0;
+    size_t n = 0;
+
+    for (; len >= sizeof(v); d += sizeof(v), len -= sizeof(v)) {
+	v = _mm256_loadu_si256((const __m256i *)d);
+	acc = _mm256_add_epi32(acc, _mm256_unpacklo_epi16(v, zero));
+	acc = _mm256_add_epi32(acc, _mm256_unpackhi_epi16(v, zero));
+	if ((++n == SIMD_FLUSH) || (len < 2 * sizeof(v))) {
+	    _mm256_storeu_si256((__m256i *)lanes, acc);
+	    for (int i = 0; i < 8; i++)
+		sum += lanes[i];
+	    acc = zero;
+	    n = 0;
+	}
+    }
+    // avoid the avx to sse transition penalty in the tail
+    _mm256_zeroupper();
+    return(sum + chksum_sse2(d, len));
+}
+
+// returns a bitmask of the bytes which need vis()
+__attribute__((target("sse2")))
+static inline uint32_t vis_mask_sse2(__m128i v, int flag) {
+    __m128i plain, bad;
+
+    plain = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(' ' - 1)),
+			  _mm_cmplt_epi8(v, _mm_set1_epi8('~' + 1)));
+    bad = _mm_cmpeq_epi8(v, _mm_set1_epi8('\\'));
+    if (flag & VIS_SP)
+	bad = _mm_or_si128(bad, _mm_cmpeq_epi8(v, _mm_set1_epi8(' ')));
+    if (flag & VIS_GLOB) {
+	bad = _mm_or_si128(bad, _mm_cmpeq_epi8(v, _mm_set1_epi8('*')));
+	bad = _mm_or_si128(bad, _mm_cmpeq_epi8(v, _mm_set1_epi8('?')));
+	bad = _mm_or_si128(bad, _mm_cmpeq_epi8(v, _mm_set1_epi8('[')));
+	bad = _mm_or_si128(bad, _mm_cmpeq_epi8(v, _mm_set1_epi8('#')));
+    }
+    return(~_mm_movemask_epi8(_mm_andnot_si128(bad, plain)) & 0xffff);
+}
+
+__attribute__((target("sse2")))
+static size_t vis_run_sse2(char *dst, const uint8_t *s, size_t len,
+			   int flag) {
+    __m128i v;
+    uint32_t mask;
+    size_t n;
+
+    for (n = 0; len - n >= sizeof(v); n += sizeof(v)) {
+	v = _mm_loadu_si128((const __m128i *)(s + n));
+	if ((mask = vis_mask_sse2(v, flag)) != 0) {
+	    memcpy(dst + n, s + n, __builtin_ctz(mask));
+	    return(n + __builtin_ctz(mask));
+	}
+	_mm_storeu_si128((__m128i *)(dst + n), v);
+    }
+    return(n + vis_run_scalar(dst + n, s + n, len - n, flag));
+}
+
+__attribute__((target("avx2")))
+static size_t vis_run_avx2(char *dst, const uint8_t *s, size_t len,
+			   int flag) {
+    __m256i v, plain, bad;
+    uint32_t mask;
+    size_t n;
+
+    for (n = 0; len - n >= sizeof(v); n += sizeof(v)) {
+	v = _mm256_loadu_si256((const __m256i *)(s + n));
+	plain = _mm256_and_si256(
+		    _mm256_cmpgt_epi8(v, _mm256_set1_epi8(' ' - 1)),
+		    _mm256_cmpgt_epi8(_mm256_set1_epi8('~' + 1), v));
+	bad = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\'));
+	if (flag & VIS_SP)
+	    bad = _mm256_or_si256(bad,
+		    _mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')));
+	if (flag & VIS_GLOB) {
+	    bad = _mm256_or_si256(bad,
+		    _mm256_cmpeq_epi8(v, _mm256_set1_epi8('*')));
+	    bad = _mm256_or_si256(bad,
+		    _mm256_cmpeq_epi8(v, _mm256_set1_epi8('?')));
+	    bad = _mm256_or_si256(bad,
+		    _mm256_cmpeq_epi8(v, _mm256_set1_epi8('[')));
+	    bad = _mm256_or_si256(bad,
+		    _mm256_cmpeq_epi8(v, _mm256_set1_epi8('#')));
+	}
+	mask = ~(uint32_t)_mm256_movemask_epi8(_mm256_andnot_si256(bad, plain));
+	if (mask != 0) {
+	    memcpy(dst + n, s + n, __builtin_ctz(mask));
+	    return(n + __builtin_ctz(mask));
+	}
+	_mm256_storeu_si256((__m256i *)(dst + n), v);
+    }
+    _mm256_zeroupper();
+    return(n + vis_run_sse2(dst + n, s + n, len - n, flag));
+}
+#endif /* HAVE_SIMD_X86 */
+
+#ifdef HAVE_SIMD_NEON
+static uint64_t chksum_neon(const uint8_t *d, size_t len) {
+    uint32x4_t zero = vdupq_n_u32(0), acc = zero;
+    uint64_t sum = 0;
+    size_t n = 0;
+
+    for (; len >= 16; d += 16, len -= 16) {
+	acc = vpadalq_u16(acc, vreinterpretq_u16_u8(vld1q_u8(d)));
+	if ((++n == SIMD_FLUSH) || (len < 32)) {
+	    sum += vaddlvq_u32(acc);
+	    acc = zero;
+	    n = 0;
+	}
+    }
+    return(sum + chksum_scalar(d, len));
+}
+
+static size_t vis_run_neon(char *dst, const uint8_t *s, size_t len,
+			   int flag) {
+    uint8x16_t v, plain, bad;
+    size_t n;
+
+    for (n = 0; len - n >= 16; n += 16) {
+	v = vld1q_u8(s + n);
+	plain = vandq_u8(vcgeq_u8(v, vdupq_n_u8(' ')),
+			 vcleq_u8(v, vdupq_n_u8('~')));
+	bad = vceqq_u8(v, vdupq_n_u8('\\'));
+	if (flag & VIS_SP)
+	    bad = vorrq_u8(bad, vceqq_u8(v, vdupq_n_u8(' ')));
+	if (flag & VIS_GLOB) {
+	    bad = vorrq_u8(bad, vceqq_u8(v, vdupq_n_u8('*')));
+	    bad = vorrq_u8(bad, vceqq_u8(v, vdupq_n_u8('?')));
+	    bad = vorrq_u8(bad, vceqq_u8(v, vdupq_n_u8('[')));
+	    bad = vorrq_u8(bad, vceqq_u8(v, vdupq_n_u8('#')));
+	}
+	// the block holds an exception, find it the slow way
+	if (vminvq_u8(vbicq_u8(plain, bad)) == 0)
+	    break;
+	vst1q_u8((uint8_t *)dst + n, v);
+    }
+    return(n + vis_run_scalar(dst + n, s + n, len - n, flag));
+}
+#endif /* HAVE_SIMD_NEON */
+
+static int simd_level = -1;
+static uint64_t (*chksum_kernel)(const uint8_t *, size_t) = chksum_scalar;
+static size_t (*vis_run_kernel)(char *, const uint8_t *, size_t, int) =
+    vis_run_scalar;
+
+// select the kernels used by my_chksum and my_strnvis, MY_SIMD_AUTO picks
+// the fastest one supported by the cpu. returns -1 if level is unsupported
+int my_simd_select(int level) {
+    int best = MY_SIMD_SCALAR;
+
+#ifdef HAVE_SIMD_X86
+    __builtin_cpu_init();
+    best = MY_SIMD_SSE2;
+    if (__builtin_cpu_supports("avx2"))
+	best = MY_SIMD_AVX2;
+#elif defined(HAVE_SIMD_NEON)
+    best = MY_SIMD_NEON;
+#endif
+
+    if (level == MY_SIMD_AUTO)
+	level = best;
+
+    switch (level) {
+	case MY_SIMD_SCALAR:
+	    chksum_kernel = chksum_scalar;
+	    vis_run_kernel = vis_run_scalar;
+	    break;
+#ifdef HAVE_SIMD_X86
+	case MY_SIMD_SSE2:
+	    chksum_kernel = chksum_sse2;
+	    vis_run_kernel = vis_run_sse2;
+	    break;
+	case MY_SIMD_AVX2:
+	    if (best != MY_SIMD_AVX2)
+		return(-1);
+	    chksum_kernel = chksum_avx2;
+	    vis_run_kernel = vis_run_avx2;
+	    break;
+#endif /* HAVE_SIMD_X86 */
+#ifdef HAVE_SIMD_NEON
+	case MY_SIMD_NEON:
+	    chksum_kernel = chksum_neon;
+	    vis_run_kernel = vis_run_neon;
+	    break;
+#endif /* HAVE_SIMD_NEON */
+	default:
+	    return(-1);
+    }
+
+    simd_level = level;
+    return(level);
+}
+
 /*
  * Actually, this is the standard IP checksum algorithm.
  */
 __nonnull()
 uint16_t my_chksum(const void *data, size_t length, int cisco) {
-    uint32_t sum = 0;
-    const uint16_t *d = (const uint16_t *)data;
+    const uint8_t *d = data;
+    uint64_t sum;
 
-    while (length > 1) {
-	sum += *d++;
-	length -= 2;
-    }
-    if (length) {
+    if (simd_level == -1)
+	my_simd_select(MY_SIMD_AUTO);
+
+    sum = chksum_kernel(d, length & ~1);
+    if (length & 1) {
+	d += length - 1;
 	if (cisco) {
-	    sum += htons(*(const uint8_t *)d);
+	    sum += htons(*d);
 	} else {
-	    sum += htons(*(const uint8_t *)d << 8);
+	    sum += htons(*d << 8);
 	}
     }
 
-    sum = (sum >> 16) + (sum & 0xffff);
-    sum += (sum >> 16);
+    while (sum >> 16)
+	sum = (sum >> 16) + (sum & 0xffff);
     return (uint16_t)~sum;
 }
 
+// strnvis() for at most len bytes of src, stopping at a NUL like strnvis.
+// printable runs are copied as is, dst must hold len * 4 + 1 bytes.
+// returns the length of dst
+size_t my_strnvis(char *dst, const void *src, size_t len, int flag) {
+    const uint8_t *s = src;
+    char *start = dst;
+    size_t n;
+
+    if (simd_level == -1)
+	my_simd_select(MY_SIMD_AUTO);
+
+    while (len > 0) {
+	n = vis_run_kernel(dst, s, len, flag);
+	dst += n;
+	s += n;
+	len -= n;
+
+	if ((len == 0) || (*s == '\0'))
+	    break;
+
+	// vis() expects the sign extended char just like strnvis passes it
+	dst = vis(dst, (char)*s, flag, (len > 1) ? (char)s[1] : '\0');
+	s++;
+	len--;
+    }
+
+    *dst = '\0';
+    return(dst - start);
+}
+
+// pipelined requests, replies are matched on the request id
+#define MREQ_FREE	0
+#define MREQ_QUEUED	1
+#define MREQ_SENT	2
+#define MREQ_DONE	3
+
+struct mreq_slot {
+    uint8_t state;
+    struct parent_req mreq;
+};
+
+static struct mreq_slot *mreqs = NULL;
+static size_t mreq_size = 0;
+static uint32_t mreq_id = 0;
+uint32_t mreq_trips = 0;
+
+static struct mreq_slot *my_mreq_slot(uint8_t state, uint32_t id) {
+    for (size_t i = 0; i < mreq_size; i++) {
+	if (mreqs[i].state != state)
+	    continue;
+	if ((state == MREQ_FREE) || (mreqs[i].mreq.id == id))
+	    return(&mreqs[i]);
+    }
+    return(NULL);
+}
+
+// returns a free slot, the queue grows to hold a full scan
+static struct mreq_slot *my_mreq_alloc() {
+    struct mreq_slot *slot;
+    size_t size = (mreq_size) ? mreq_size * 2 : PARENT_REQ_QUEUE;
+
+    if ((slot = my_mreq_slot(MREQ_FREE, 0)) != NULL)
+	return(slot);
+
+    mreqs = my_realloc(mreqs, size * sizeof(struct mreq_slot));
+    memset(mreqs + mreq_size, 0,
+	    (size - mreq_size) * sizeof(struct mreq_slot));
+    slot = &mreqs[mreq_size];
+    mreq_size = size;
+
+    return(slot);
+}
+
+// the channel is out of sync, forget everything in flight
+static void my_mreq_reset() {
+    for (size_t i = 0; i < mreq_size; i++)
+	mreqs[i].state = MREQ_FREE;
+}
+
+// queue a request, the reply is picked up by a later my_mreq
+uint32_t my_mreq_queue(struct parent_req *mreq) {
+    struct mreq_slot *slot;
+
+    assert(mreq != NULL);
+
+    // id 0 is used for synchronous requests
+    if (++mreq_id == 0)
+	mreq_id++;
+
+    slot = my_mreq_alloc();
+    memcpy(&slot->mreq, mreq, PARENT_REQ_LEN(mreq->len));
+    slot->mreq.id = mreq_id;
+    slot->state = MREQ_QUEUED;
+
+    return(mreq_id);
+}
+
+// send all queued requests and collect the replies,
+// returns the number of replies received
+int my_mreq_flush() {
+    struct parent_req mreq;
+    struct mreq_slot *slot;
+    size_t i = 0;
+    int sent, count = 0;
+    ssize_t len;
+
+    while (i < mreq_size) {
+
+	// send a window of requests
+	for (sent = 0; (i < mreq_size) && (sent < PARENT_REQ_BATCH); i++) {
+	    slot = &mreqs[i];
+	    if (slot->state != MREQ_QUEUED)
+		continue;
+
+	    len = write(msock, &slot->mreq, PARENT_REQ_LEN(slot->mreq.len));
+	    if (len < PARENT_REQ_MIN ||
+		len != PARENT_REQ_LEN(slot->mreq.len)) {
+		my_mreq_reset();
+		my_fatale("only %zi bytes written", len);
+	    }
+	    slot->state = MREQ_SENT;
+	    sent++;
+	}
+
+	if (sent == 0)
+	    break;
+	mreq_trips++;
+
+	// and wait for all of them
+	for (; sent > 0; sent--) {
+	    memset(&mreq, 0, PARENT_REQ_MAX);
+	    len = read(msock, &mreq, PARENT_REQ_MAX);
+	    if (len < PARENT_REQ_MIN || len != PARENT_REQ_LEN(mreq.len) ||
+		(slot = my_mreq_slot(MREQ_SENT, mreq.id)) == NULL) {
+		my_mreq_reset();
+		my_fatal("invalid reply received from parent");
+	    }
+
+	    memcpy(&slot->mreq, &mreq, len);
+	    slot->state = MREQ_DONE;
+	    count++;
+	}
+    }
+
+    return(count);
+}
+
+// discard replies nobody asked for
+void my_mreq_drop() {
+    for (size_t i = 0; i < mreq_size; i++) {
+	if (mreqs[i].state == MREQ_DONE)
+	    mreqs[i].state = MREQ_FREE;
+    }
+}
+
 ssize_t my_mreq(struct parent_req *mreq) {
-    ssize_t len = 0;
+    struct mreq_slot *slot = NULL;
 
     assert(mreq != NULL);
 
-    len = write(msock, mreq, PARENT_REQ_LEN(mreq->len));
-    if (len < PARENT_REQ_MIN || len != PARENT_REQ_LEN(mreq->len))
-	my_fatale("only %zi bytes written", len);
+    // use a queued request for the same interface if there is one
+    for (size_t i = 0; (slot == NULL) && (i < mreq_size); i++) {
+	if ((mreqs[i].state == MREQ_FREE) || (mreqs[i].mreq.id == 0))
+	    continue;
+	if ((mreqs[i].mreq.op == mreq->op) &&
+	    (mreqs[i].mreq.index == mreq->index))
+	    slot = &mreqs[i];
+    }
+
+    // otherwise send it along with the queue
+    if (slot == NULL) {
+	slot = my_mreq_alloc();
+	memcpy(&slot->mreq, mreq, PARENT_REQ_LEN(mreq->len));
+	slot->mreq.id = 0;
+	slot->state = MREQ_QUEUED;
+    }
+
+    // slots don't move while flushing
+    if (slot->state != MREQ_DONE)
+	my_mreq_flush();
 
-    memset(mreq, 0, PARENT_REQ_MAX);
-    len = read(msock, mreq, PARENT_REQ_MAX);
-    if (len < PARENT_REQ_MIN || len != PARENT_REQ_LEN(mreq->len))
-	my_fatal("invalid reply received from parent");
+    memcpy(mreq, &slot->mreq, PARENT_REQ_LEN(slot->mreq.len));
+    slot->state = MREQ_FREE;
 
     return(mreq->len);
 };
 
+// send a batch of messages, returns the number of messages sent
+int my_msend(int fd, struct parent_msg *msgs, int count) {
+    int sent = 0;
+
+    assert(msgs != NULL);
+    assert(count <= PARENT_MSG_BATCH);
+
+#ifdef HAVE_SENDMMSG
+    struct mmsghdr mmsg[PARENT_MSG_BATCH];
+    struct iovec iov[PARENT_MSG_BATCH];
+    int ret;
+
+    memset(mmsg, 0, sizeof(mmsg));
+    for (int i = 0; i < count; i++) {
+	iov[i].iov_base = &msgs[i];
+	iov[i].iov_len = PARENT_MSG_LEN(msgs[i].len);
+	mmsg[i].msg_hdr.msg_iov = &iov[i];
+	mmsg[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    while (sent < count) {
+	ret = sendmmsg(fd, mmsg + sent, count - sent, 0);
+	if (ret == -1) {
+	    if (errno == EINTR)
+		continue;
+	    // use plain writes for the remainder
+	    if ((errno == ENOSYS) || (errno == ENOTSOCK))
+		break;
+	    return(sent);
+	}
+	sent += ret;
+    }
+#endif /* HAVE_SENDMMSG */
+
+    for (; sent < count; sent++) {
+	ssize_t len = write(fd, &msgs[sent], PARENT_MSG_LEN(msgs[sent].len));
+	if (len != PARENT_MSG_LEN(msgs[sent].len))
+	    break;
+    }
+
+    return(sent);
+}
+
+// receive a batch of messages, returns the number of valid messages
+int my_mrecv(int fd, struct parent_msg *msgs, int count) {
+    struct peer_arena *arena;
+    ssize_t len[PARENT_MSG_BATCH];
+    int recvd = 0, valid = 0;
+
+    assert(msgs != NULL);
+    assert(count <= PARENT_MSG_BATCH);
+
+#ifdef HAVE_RECVMMSG
+    struct mmsghdr mmsg[PARENT_MSG_BATCH];
+    struct iovec iov[PARENT_MSG_BATCH];
+
+    memset(mmsg, 0, sizeof(mmsg));
+    for (int i = 0; i < count; i++) {
+	iov[i].iov_base = &msgs[i];
+	iov[i].iov_len = PARENT_MSG_MAX;
+	mmsg[i].msg_hdr.msg_iov = &iov[i];
+	mmsg[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    if ((recvd = recvmmsg(fd, mmsg, count, MSG_DONTWAIT, NULL)) == -1)
+	return(0);
+    for (int i = 0; i < recvd; i++)
+	len[i] = mmsg[i].msg_len;
+#else
+    // one message per call
+    if ((len[0] = read(fd, msgs, PARENT_MSG_MAX)) == -1)
+	return(0);
+    recvd = 1;
+#endif /* HAVE_RECVMMSG */
+
+    for (int i = 0; i < recvd; i++) {
+	// skip invalid messages
+	if (len[i] < PARENT_MSG_MIN || len[i] != PARENT_MSG_LEN(msgs[i].len))
+	    continue;
+	if (valid != i)
+	    memcpy(&msgs[valid], &msgs[i], len[i]);
+
+	// clear the remainder, the peer arena is kept for reuse
+	arena = msgs[valid].arena;
+	memset((uint8_t *)&msgs[valid] + len[i], 0,
+		sizeof(struct parent_msg) - len[i]);
+	msgs[valid].arena = arena;
+	valid++;
+    }
+
+    return(valid);
+}
+
+// allocate zeroed memory for decoded peer strings from the message arena
+char *peer_alloc(struct parent_msg *msg, size_t len) {
+    struct peer_arena *arena, **ap = &msg->arena;
+    char *str;
+
+    for (; (arena = *ap) != NULL; ap = &arena->next) {
+	if (arena->size - arena->used >= len)
+	    break;
+    }
+
+    // oversized strings get a block of their own
+    if (arena == NULL) {
+	size_t size = (len > PEER_ARENA_SIZE) ? len : PEER_ARENA_SIZE;
+	arena = *ap = my_malloc(sizeof(struct peer_arena) + size);
+	arena->size = size;
+    }
+
+    str = arena->buf + arena->used;
+    arena->used += len;
+    memset(str, 0, len);
+    return(str);
+}
+
+char *peer_strdup(struct parent_msg *msg, const char *src) {
+    size_t len = strlen(src) + 1;
+    return(memcpy(peer_alloc(msg, len), src, len));
+}
+
+void peer_free(struct parent_msg *msg) {
+    struct peer_arena *arena, *next;
+
+    memset(msg->peer, 0, sizeof(msg->peer));
+    msg->record = NULL;
+    for (arena = msg->arena; arena != NULL; arena = next) {
+	next = arena->next;
+	free(arena);
+    }
+    msg->arena = NULL;
+}
+
+// render the decoded peer fields into a record for the control socket,
+// fields which don't fit in PEER_RECORD_MAX are left out
+struct peer_record *peer_record(struct parent_msg *msg) {
+    struct peer_record *rec;
+    size_t len = PEER_RECORD_MIN, slen;
+    uintptr_t align = sizeof(time_t) - 1;
+    int i;
+
+    if (msg->record)
+	return(msg->record);
+
+    for (i = 0; i < PEER_MAX; i++) {
+	if (msg->peer[i])
+	    len += strlen(msg->peer[i]) + 1;
+    }
+    if (len > PEER_RECORD_MAX)
+	len = PEER_RECORD_MAX;
+
+    rec = (struct peer_record *)
+	(((uintptr_t)peer_alloc(msg, len + align) + align) & ~align);
+    rec->index = msg->index;
+    strlcpy(rec->name, msg->name, IFNAMSIZ);
+    rec->proto = msg->proto;
+    rec->ttl = msg->ttl;
+    rec->received = msg->received;
+
+    len = PEER_RECORD_MIN;
+    for (i = 0; i < PEER_MAX; i++) {
+	if (!msg->peer[i])
+	    continue;
+	slen = strlen(msg->peer[i]) + 1;
+	if (len + slen > PEER_RECORD_MAX)
+	    continue;
+	memcpy((char *)rec + len, msg->peer[i], slen);
+	rec->peer[i] = len;
+	len += slen;
+    }
+    rec->len = len;
+
+    msg->record = rec;
+    return(rec);
+}
+
+// copy the requested fields of the msg record into dst,
+// the cached record is returned when it matches the request
+struct peer_record *peer_record_fields(struct parent_msg *msg,
+    uint16_t fields, struct peer_record *dst) {
+    struct peer_record *rec = peer_record(msg);
+    size_t len = PEER_RECORD_MIN, slen;
+    int i;
+
+    if (fields == CLI_FIELDS_PEER)
+	return(rec);
+
+    memcpy(dst, rec, PEER_RECORD_MIN);
+    memset(dst->peer, 0, sizeof(dst->peer));
+    dst->frame = dst->frame_len = 0;
+
+    // the frame goes first, it always fits
+    if ((fields & CLI_FIELD_FRAME) && (msg->len > 0)) {
+	memcpy(dst->data, msg->msg, msg->len);
+	dst->frame = len;
+	dst->frame_len = msg->len;
+	len += msg->len;
+    }
+
+    for (i = 0; i < PEER_MAX; i++) {
+	if (!(fields & CLI_FIELD(i)) || !rec->peer[i])
+	    continue;
+	slen = strlen((char *)rec + rec->peer[i]) + 1;
+	if (len + slen > PEER_RECORD_MAX)
+	    continue;
+	memcpy((char *)dst + len, (char *)rec + rec->peer[i], slen);
+	dst->peer[i] = len;
+	len += slen;
+    }
+    dst->len = len;
+
+    return(dst);
+}
+
+// generations handed out to frame inputs, see netif_gen
+uint32_t netif_gens = 0;
+
+// returns the generation of the netif fields used by the protocol builders,
+// a new one is handed out whenever they differ from the previous call
+uint32_t netif_gen(struct netif *netif) {
+    struct netif *input = netif->gen_input;
+
+    if ((input != NULL) &&
+	(memcmp(input, netif, offsetof(struct netif, protos)) == 0) &&
+	(input->parent == netif->parent) &&
+	(strcmp(input->device_name, netif->device_name) == 0))
+	return(netif->gen);
+
+    if (input == NULL)
+	input = netif->gen_input = my_malloc(sizeof(struct netif));
+    memcpy(input, netif, offsetof(struct netif, protos));
+    input->parent = netif->parent;
+    strlcpy(input->device_name, netif->device_name, IFDESCRSIZE);
+
+    netif->gen = ++netif_gens;
+    return(netif->gen);
+}
+
+void netif_frames_free(struct netif *netif) {
+    for (int p = 0; p < NETIF_FRAMES; p++) {
+	free(netif->frames[p]);
+	netif->frames[p] = NULL;
+    }
+    free(netif->gen_input);
+    netif->gen_input = NULL;
+}
+
+void netif_list_init(struct nhead *netifs) {
+    assert(netifs != NULL);
+
+    TAILQ_INIT(netifs);
+    netifs->hash = NULL;
+}
+
+static void netif_hash_keys(struct netif *netif) {
+    netif->hkey[NETIF_HASH_INDEX] = netif_hash_index(netif->index);
+    netif->hkey[NETIF_HASH_NAME] =
+	netif_hash_bytes((uint8_t *)netif->name, IFNAMSIZ);
+    netif->hkey[NETIF_HASH_ADDR] = netif_hash_addr(netif->hwaddr);
+}
+
+static void netif_hash_link(struct netif_hash *hash, struct netif *netif) {
+    struct netif **bucket;
+
+    for (int k = 0; k < NETIF_HASH_KEYS; k++) {
+	bucket = &hash->buckets[k][netif->hkey[k] & (hash->size - 1)];
+	netif->hnext[k] = *bucket;
+	*bucket = netif;
+    }
+}
+
+static void netif_hash_unlink(struct netif_hash *hash, struct netif *netif) {
+    struct netif **np;
+
+    for (int k = 0; k < NETIF_HASH_KEYS; k++) {
+	np = &hash->buckets[k][netif->hkey[k] & (hash->size - 1)];
+	for (; *np != NULL; np = &(*np)->hnext[k]) {
+	    if (*np != netif)
+		continue;
+	    *np = netif->hnext[k];
+	    break;
+	}
+	netif->hnext[k] = NULL;
+    }
+}
+
+// (re)build the index for all netifs on the list
+static void netif_hash_resize(struct nhead *netifs, uint32_t size) {
+    struct netif_hash *hash = netifs->hash;
+    struct netif *netif;
+
+    if (hash == NULL)
+	hash = netifs->hash = my_malloc(sizeof(struct netif_hash));
+
+    for (int k = 0; k < NETIF_HASH_KEYS; k++) {
+	free(hash->buckets[k]);
+	hash->buckets[k] = my_calloc(size, sizeof(struct netif *));
+    }
+    hash->size = size;
+    hash->count = 0;
+
+    TAILQ_FOREACH(netif, netifs, entries) {
+	netif_hash_keys(netif);
+	netif_hash_link(hash, netif);
+	hash->count++;
+    }
+}
+
+void netif_list_insert(struct nhead *netifs, struct netif *netif) {
+    struct netif_hash *hash = netifs->hash;
+
+    assert((netifs != NULL) && (netif != NULL));
+
+    TAILQ_INSERT_TAIL(netifs, netif, entries);
+
+    // grow the index when it's fully loaded
+    if ((hash == NULL) || (hash->count >= hash->size)) {
+	netif_hash_resize(netifs, (hash) ? hash->size * 2 : NETIF_HASH_MIN);
+	return;
+    }
+
+    netif_hash_keys(netif);
+    netif_hash_link(hash, netif);
+    hash->count++;
+}
+
+void netif_list_remove(struct nhead *netifs, struct netif *netif) {
+    struct netif_hash *hash = netifs->hash;
+
+    assert((netifs != NULL) && (netif != NULL));
+
+    if (hash != NULL) {
+	netif_hash_unlink(hash, netif);
+	hash->count--;
+	hash->gen = ++netif_gens;
+    }
+    TAILQ_REMOVE(netifs, netif, entries);
+}
+
+// update the index after changing the index, name or hwaddr
+void netif_list_rehash(struct nhead *netifs, struct netif *netif) {
+    struct netif_hash *hash = netifs->hash;
+
+    assert((netifs != NULL) && (netif != NULL));
+
+    if (hash == NULL)
+	return;
+
+    netif_hash_unlink(hash, netif);
+    netif_hash_keys(netif);
+    netif_hash_link(hash, netif);
+}
+
+void netif_list_free(struct nhead *netifs) {
+    struct netif_hash *hash = netifs->hash;
+
+    if (hash == NULL)
+	return;
+
+    for (int k = 0; k < NETIF_HASH_KEYS; k++)
+	free(hash->buckets[k]);
+    free(hash);
+    netifs->hash = NULL;
+}
+
+void mqueue_init(struct mhead *mqueue) {
+    assert(mqueue != NULL);
+
+    TAILQ_INIT(mqueue);
+    mqueue->index = NULL;
+    mqueue->gen = 0;
+    mqueue->snap = NULL;
+}
+
+// hash of (ifindex, proto, src)
+static uint32_t mqueue_hash_key(struct parent_msg *msg) {
+    uint32_t h = netif_hash_index(msg->index) ^ msg->proto;
+    const uint8_t *src = msg->msg + ETHER_ADDR_LEN;
+
+    for (int i = 0; i < ETHER_ADDR_LEN; i++)
+	h = (h ^ src[i]) * 16777619U;
+    return(h);
+}
+
+static inline
+int mqueue_match(struct parent_msg *qmsg, struct parent_msg *msg) {
+    // identical ifindex, protocol, source & destination
+    return((qmsg->index == msg->index) && (qmsg->proto == msg->proto) &&
+	(memcmp(qmsg->msg, msg->msg, ETHER_ADDR_LEN * 2) == 0));
+}
+
+static inline
+int mqueue_peer(struct parent_msg *qmsg, struct parent_msg *msg) {
+    return(memcmp(qmsg->msg + ETHER_ADDR_LEN, msg->msg + ETHER_ADDR_LEN,
+		ETHER_ADDR_LEN) == 0);
+}
+
+static inline
+int mqueue_before(struct parent_msg *a, struct parent_msg *b) {
+    return((a->received + a->ttl) < (b->received + b->ttl));
+}
+
+static void mqueue_heap_set(struct mqueue_index *idx, uint32_t pos,
+			    struct parent_msg *msg) {
+    idx->heap[pos] = msg;
+    msg->hpos = pos;
+}
+
+static void mqueue_heap_up(struct mqueue_index *idx, uint32_t pos) {
+    struct parent_msg *msg = idx->heap[pos];
+    uint32_t parent;
+
+    for (; pos > 0; pos = parent) {
+	parent = (pos - 1) / 2;
+	if (!mqueue_before(msg, idx->heap[parent]))
+	    break;
+	mqueue_heap_set(idx, pos, idx->heap[parent]);
+    }
+    mqueue_heap_set(idx, pos, msg);
+}
+
+static void mqueue_heap_down(struct mqueue_index *idx, uint32_t pos) {
+    struct parent_msg *msg = idx->heap[pos];
+    uint32_t child;
+
+    for (; (child = pos * 2 + 1) < idx->hcount; pos = child) {
+	if ((child + 1 < idx->hcount) &&
+	    mqueue_before(idx->heap[child + 1], idx->heap[child]))
+	    child++;
+	if (!mqueue_before(idx->heap[child], msg))
+	    break;
+	mqueue_heap_set(idx, pos, idx->heap[child]);
+    }
+    mqueue_heap_set(idx, pos, msg);
+}
+
+static void mqueue_heap_push(struct mqueue_index *idx, struct parent_msg *msg) {
+    mqueue_heap_set(idx, idx->hcount++, msg);
+    mqueue_heap_up(idx, msg->hpos);
+}
+
+static void mqueue_heap_del(struct mqueue_index *idx, struct parent_msg *msg) {
+    uint32_t pos = msg->hpos;
+
+    assert((pos < idx->hcount) && (idx->heap[pos] == msg));
+
+    idx->hcount--;
+    if (pos != idx->hcount) {
+	// the moved message might need to go either way
+	mqueue_heap_set(idx, pos, idx->heap[idx->hcount]);
+	mqueue_heap_up(idx, pos);
+	mqueue_heap_down(idx, idx->heap[pos]->hpos);
+    }
+    idx->heap[idx->hcount] = NULL;
+}
+
+static struct mqueue_if *mqueue_if_get(struct mqueue_index *idx,
+					uint32_t index) {
+    struct mqueue_if *mif;
+
+    mif = idx->ibuckets[netif_hash_index(index) & (idx->isize - 1)];
+    for (; mif != NULL; mif = mif->next) {
+	if (mif->index == index)
+	    break;
+    }
+    return(mif);
+}
+
+static void mqueue_if_link(struct mqueue_index *idx, struct mqueue_if *mif) {
+    struct mqueue_if **bucket;
+
+    bucket = &idx->ibuckets[netif_hash_index(mif->index) & (idx->isize - 1)];
+    mif->next = *bucket;
+    *bucket = mif;
+}
+
+static struct mqueue_if *mqueue_if_add(struct mqueue_index *idx,
+					uint32_t index) {
+    struct mqueue_if *mif, *nmif, **ibuckets = idx->ibuckets;
+    uint32_t isize = idx->isize;
+
+    if ((mif = mqueue_if_get(idx, index)) != NULL)
+	return(mif);
+
+    // grow the interface table when it's fully loaded
+    if (idx->icount >= idx->isize) {
+	idx->isize *= 2;
+	idx->ibuckets = my_calloc(idx->isize, sizeof(struct mqueue_if *));
+	for (uint32_t i = 0; i < isize; i++) {
+	    for (mif = ibuckets[i]; mif != NULL; mif = nmif) {
+		nmif = mif->next;
+		mqueue_if_link(idx, mif);
+	    }
+	}
+	free(ibuckets);
+    }
+
+    mif = my_malloc(sizeof(struct mqueue_if));
+    mif->index = index;
+    TAILQ_INIT(&mif->msgs);
+    mqueue_if_link(idx, mif);
+    idx->icount++;
+
+    return(mif);
+}
+
+static void mqueue_if_del(struct mqueue_index *idx, struct mqueue_if *mif) {
+    struct mqueue_if **mp;
+
+    mp = &idx->ibuckets[netif_hash_index(mif->index) & (idx->isize - 1)];
+    for (; *mp != NULL; mp = &(*mp)->next) {
+	if (*mp != mif)
+	    continue;
+	*mp = mif->next;
+	break;
+    }
+    idx->icount--;
+    free(mif);
+}
+
+static void mqueue_hash_link(struct mqueue_index *idx, struct parent_msg *msg) {
+    struct parent_msg **bucket;
+
+    bucket = &idx->buckets[msg->hkey & (idx->size - 1)];
+    msg->hnext = *bucket;
+    *bucket = msg;
+}
+
+static void mqueue_hash_unlink(struct mqueue_index *idx,
+				struct parent_msg *msg) {
+    struct parent_msg **mp;
+
+    mp = &idx->buckets[msg->hkey & (idx->size - 1)];
+    for (; *mp != NULL; mp = &(*mp)->hnext) {
+	if (*mp != msg)
+	    continue;
+	*mp = msg->hnext;
+	break;
+    }
+    msg->hnext = NULL;
+}
+
+// (re)size the message table and the heap
+static void mqueue_index_resize(struct mhead *mqueue, uint32_t size) {
+    struct mqueue_index *idx = mqueue->index;
+    struct parent_msg *msg, **heap = idx->heap;
+
+    free(idx->buckets);
+    idx->buckets = my_calloc(size, sizeof(struct parent_msg *));
+    idx->heap = my_calloc(size, sizeof(struct parent_msg *));
+    idx->size = size;
+
+    if (heap != NULL)
+	memcpy(idx->heap, heap, idx->hcount * sizeof(struct parent_msg *));
+    free(heap);
+
+    TAILQ_FOREACH(msg, mqueue, entries)
+	mqueue_hash_link(idx, msg);
+}
+
+struct parent_msg *mqueue_lookup(struct mhead *mqueue, struct parent_msg *msg) {
+    struct parent_msg *qmsg;
+
+    assert((mqueue != NULL) && (msg != NULL));
+
+    if (mqueue->index == NULL) {
+	TAILQ_FOREACH(qmsg, mqueue, entries) {
+	    if (mqueue_match(qmsg, msg))
+		break;
+	}
+	return(qmsg);
+    }
+
+    qmsg = mqueue->index->buckets[mqueue_hash_key(msg) &
+				 (mqueue->index->size - 1)];
+    for (; qmsg != NULL; qmsg = qmsg->hnext) {
+	if (mqueue_match(qmsg, msg))
+	    break;
+    }
+    return(qmsg);
+}
+
+void mqueue_insert(struct mhead *mqueue, struct parent_msg *msg) {
+    struct mqueue_index *idx = mqueue->index;
+    struct mqueue_if *mif;
+    struct parent_msg *qmsg, *pmsg = NULL;
+
+    assert((mqueue != NULL) && (msg != NULL));
+
+    if (idx == NULL) {
+	assert(TAILQ_EMPTY(mqueue));
+	idx = mqueue->index = my_malloc(sizeof(struct mqueue_index));
+	idx->isize = MQUEUE_HASH_MIN;
+	idx->ibuckets = my_calloc(idx->isize, sizeof(struct mqueue_if *));
+	mqueue_index_resize(mqueue, MQUEUE_HASH_MIN);
+    }
+
+    // grow the index when it's fully loaded
+    if (idx->count >= idx->size)
+	mqueue_index_resize(mqueue, idx->size * 2);
+
+    mif = mqueue_if_add(idx, msg->index);
+
+    // group messages per peer
+    TAILQ_FOREACH(qmsg, &mif->msgs, ientries) {
+	if (mqueue_peer(qmsg, msg))
+	    pmsg = qmsg;
+	else if (pmsg)
+	    break;
+    }
+
+    if (pmsg) {
+	TAILQ_INSERT_AFTER(mqueue, pmsg, msg, entries);
+	TAILQ_INSERT_AFTER(&mif->msgs, pmsg, msg, ientries);
+    } else {
+	TAILQ_INSERT_TAIL(mqueue, msg, entries);
+	TAILQ_INSERT_TAIL(&mif->msgs, msg, ientries);
+    }
+    mif->count++;
+
+    msg->hkey = mqueue_hash_key(msg);
+    mqueue_hash_link(idx, msg);
+    mqueue_heap_push(idx, msg);
+    idx->count++;
+
+    // the queue holds a reference, dropped via mqueue_unref after removal
+    msg->refs++;
+    mqueue->gen++;
+}
+
+void mqueue_remove(struct mhead *mqueue, struct parent_msg *msg) {
+    struct mqueue_index *idx = mqueue->index;
+    struct mqueue_if *mif;
+
+    assert((mqueue != NULL) && (msg != NULL));
+
+    TAILQ_REMOVE(mqueue, msg, entries);
+    mqueue->gen++;
+
+    if (idx == NULL)
+	return;
+
+    mqueue_hash_unlink(idx, msg);
+    mqueue_heap_del(idx, msg);
+    idx->count--;
+
+    mif = mqueue_if_get(idx, msg->index);
+    assert(mif != NULL);
+    TAILQ_REMOVE(&mif->msgs, msg, ientries);
+    if (--mif->count == 0)
+	mqueue_if_del(idx, mif);
+}
+
+// update the heap after changing the received timestamp or ttl
+void mqueue_update(struct mhead *mqueue, struct parent_msg *msg) {
+    struct mqueue_index *idx = mqueue->index;
+
+    assert((mqueue != NULL) && (msg != NULL));
+
+    mqueue->gen++;
+    if (idx == NULL)
+	return;
+
+    mqueue_heap_up(idx, msg->hpos);
+    mqueue_heap_down(idx, msg->hpos);
+}
+
+// put nmsg in the place of msg, which needs to be dropped via mqueue_unref
+// both messages are expected to share the same (ifindex, proto, src)
+void mqueue_replace(struct mhead *mqueue, struct parent_msg *msg,
+		    struct parent_msg *nmsg) {
+    struct mqueue_index *idx = mqueue->index;
+    struct mqueue_if *mif;
+
+    assert((mqueue != NULL) && (msg != NULL) && (nmsg != NULL));
+
+    TAILQ_INSERT_AFTER(mqueue, msg, nmsg, entries);
+    TAILQ_REMOVE(mqueue, msg, entries);
+    nmsg->refs++;
+
+    if (idx != NULL) {
+	mif = mqueue_if_get(idx, msg->index);
+	assert(mif != NULL);
+	TAILQ_INSERT_AFTER(&mif->msgs, msg, nmsg, ientries);
+	TAILQ_REMOVE(&mif->msgs, msg, ientries);
+
+	mqueue_hash_unlink(idx, msg);
+	nmsg->hkey = msg->hkey;
+	mqueue_hash_link(idx, nmsg);
+	mqueue_heap_set(idx, msg->hpos, nmsg);
+    }
+
+    mqueue_update(mqueue, nmsg);
+}
+
+// drop a reference, the message is freed with the last one
+void mqueue_unref(struct parent_msg *msg) {
+    assert((msg != NULL) && (msg->refs > 0));
+
+    if (--msg->refs)
+	return;
+    peer_free(msg);
+    free(msg);
+}
+
+// return a snapshot of the queued messages, which stays valid while the
+// queue changes. Unchanged queues share the last snapshot.
+struct mqueue_snap *mqueue_snapshot(struct mhead *mqueue) {
+    struct mqueue_snap *snap = mqueue->snap;
+    struct parent_msg *msg;
+    uint32_t count = 0;
+
+    if ((snap != NULL) && (snap->gen == mqueue->gen)) {
+	snap->refs++;
+	return(snap);
+    }
+
+    TAILQ_FOREACH(msg, mqueue, entries)
+	count++;
+
+    snap = my_malloc(sizeof(struct mqueue_snap) +
+		     count * sizeof(struct parent_msg *));
+    snap->refs = 1;
+    snap->gen = mqueue->gen;
+    TAILQ_FOREACH(msg, mqueue, entries) {
+	snap->msgs[snap->count++] = msg;
+	msg->refs++;
+    }
+
+    mqueue->snap = snap;
+    return(snap);
+}
+
+void mqueue_snap_unref(struct mhead *mqueue, struct mqueue_snap *snap) {
+    assert((snap != NULL) && (snap->refs > 0));
+
+    if (--snap->refs)
+	return;
+
+    for (uint32_t i = 0; i < snap->count; i++)
+	mqueue_unref(snap->msgs[i]);
+    if (mqueue->snap == snap)
+	mqueue->snap = NULL;
+    free(snap);
+}
+
+// return the next expired message
+struct parent_msg *mqueue_expired(struct mhead *mqueue, time_t now) {
+    struct mqueue_index *idx = mqueue->index;
+    struct parent_msg *msg;
+
+    assert(mqueue != NULL);
+
+    if (idx == NULL) {
+	TAILQ_FOREACH(msg, mqueue, entries) {
+	    if ((msg->received + msg->ttl) < now)
+		break;
+	}
+	return(msg);
+    }
+
+    if (idx->hcount == 0)
+	return(NULL);
+
+    msg = idx->heap[0];
+    if (likely((msg->received + msg->ttl) >= now))
+	return(NULL);
+    return(msg);
+}
+
+// iterate over the messages received on an interface
+struct parent_msg *mqueue_iter(struct parent_msg *msg, struct mhead *mqueue,
+				uint32_t index) {
+    struct mqueue_if *mif;
+
+    assert(mqueue != NULL);
+
+    if (mqueue->index == NULL) {
+	msg = (msg) ? TAILQ_NEXT(msg, entries) : TAILQ_FIRST(mqueue);
+	for (; msg != NULL; msg = TAILQ_NEXT(msg, entries)) {
+	    if (msg->index == index)
+		break;
+	}
+	return(msg);
+    }
+
+    if (msg)
+	return(TAILQ_NEXT(msg, ientries));
+    if ((mif = mqueue_if_get(mqueue->index, index)) == NULL)
+	return(NULL);
+    return(TAILQ_FIRST(&mif->msgs));
+}
+
+void mqueue_free(struct mhead *mqueue) {
+    struct mqueue_index *idx = mqueue->index;
+    struct mqueue_if *mif, *nmif;
+
+    if (idx == NULL)
+	return;
+
+    for (uint32_t i = 0; i < idx->isize; i++) {
+	for (mif = idx->ibuckets[i]; mif != NULL; mif = nmif) {
+	    nmif = mif->next;
+	    free(mif);
+	}
+    }
+    free(idx->ibuckets);
+    free(idx->buckets);
+    free(idx->heap);
+    free(idx);
+    mqueue->index = NULL;
+}
+
+// check the header of a snapshot slot against the file size
+static int mqueue_file_valid(const struct mqueue_file *hdr, size_t fsize) {
+    return((hdr->magic == MQUEUE_FILE_MAGIC) &&
+	   (hdr->version == MQUEUE_FILE_VERSION) &&
+	   (hdr->hdrlen == sizeof(struct mqueue_file)) &&
+	   (hdr->offset >= MQUEUE_FILE_SLOTS * sizeof(struct mqueue_file)) &&
+	   ((hdr->offset & 7) == 0) && (hdr->offset <= fsize) &&
+	   (hdr->size <= fsize - hdr->offset));
+}
+
+// write the unexpired messages to a snapshot file. The slot with the
+// newest snapshot is left untouched, the records go to free space before or
+// after it and only then the header of the other slot is replaced. A save
+// which is interrupted at any point keeps the previous snapshot loadable.
+int mqueue_save(struct mhead *mqueue, int fd, time_t now) {
+    struct mqueue_file hdrs[MQUEUE_FILE_SLOTS] = {}, *cur = NULL;
+    struct mqueue_file hdr = { .magic = MQUEUE_FILE_MAGIC,
+			       .version = MQUEUE_FILE_VERSION,
+			       .hdrlen = sizeof(struct mqueue_file) };
+    const size_t base = MQUEUE_FILE_SLOTS * sizeof(struct mqueue_file);
+    struct mqueue_file_rec *rec;
+    struct parent_msg *msg;
+    struct stat sb;
+    char *buf;
+    size_t size = 0, reclen, end = base;
+    int slot = 0;
+
+    // find the current snapshot, an empty file has none
+    if (fstat(fd, &sb) == -1)
+	return(-1);
+    if (pread(fd, hdrs, sizeof(hdrs), 0) != (ssize_t)sizeof(hdrs))
+	memset(hdrs, 0, sizeof(hdrs));
+    for (int s = 0; s < MQUEUE_FILE_SLOTS; s++) {
+	if (!mqueue_file_valid(&hdrs[s], sb.st_size))
+	    continue;
+	if ((cur == NULL) || (hdrs[s].gen > cur->gen)) {
+	    cur = &hdrs[s];
+	    slot = (s + 1) % MQUEUE_FILE_SLOTS;
+	}
+    }
+
+    TAILQ_FOREACH(msg, mqueue, entries)
+	size += MQUEUE_FILE_RECLEN(msg->len);
+    buf = my_malloc(size ? size : 1);
+
+    TAILQ_FOREACH(msg, mqueue, entries) {
+	if ((msg->received + msg->ttl) < now)
+	    continue;
+	reclen = MQUEUE_FILE_RECLEN(msg->len);
+	rec = (struct mqueue_file_rec *)(buf + hdr.size);
+	rec->reclen = reclen;
+	rec->len = msg->len;
+	rec->index = msg->index;
+	rec->received = msg->received;
+	rec->ttl = msg->ttl;
+	rec->proto = msg->proto;
+	strlcpy(rec->name, msg->name, sizeof(rec->name));
+	memcpy(rec->msg, msg->msg, msg->len);
+	hdr.size += reclen;
+	hdr.count++;
+    }
+    hdr.crc = my_crc32(buf, hdr.size);
+    hdr.written = now;
+    hdr.gen = (cur != NULL) ? cur->gen + 1 : 1;
+
+    // in front of the current records when they fit, behind them otherwise
+    hdr.offset = base;
+    if (cur != NULL) {
+	end = cur->offset + cur->size;
+	if (hdr.size > cur->offset - base)
+	    hdr.offset = end;
+    }
+    end = MAX(end, hdr.offset + hdr.size);
+
+    if ((pwrite(fd, buf, hdr.size, hdr.offset) != (ssize_t)hdr.size) ||
+	(pwrite(fd, &hdr, hdr.hdrlen, slot * hdr.hdrlen) != hdr.hdrlen) ||
+	(ftruncate(fd, end) == -1)) {
+	free(buf);
+	return(-1);
+    }
+
+    free(buf);
+    return(hdr.count);
+}
+
+// map a snapshot file and pass every unexpired message of the newest
+// valid slot to queue, returns the number of messages or -1 when no slot
+// is valid
+int mqueue_load(int fd, time_t now,
+		void (*queue)(struct parent_msg *, time_t)) {
+    struct mqueue_file *hdr = NULL, *shdr;
+    struct mqueue_file_rec *rec;
+    struct parent_msg *msg;
+    struct stat sb;
+    char *buf;
+    size_t off, end;
+    int count = 0;
+
+    if ((fstat(fd, &sb) == -1) ||
+	(sb.st_size < MQUEUE_FILE_SLOTS * sizeof(struct mqueue_file)))
+	return(-1);
+
+    buf = mmap(NULL, sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (buf == MAP_FAILED)
+	return(-1);
+
+    for (int s = 0; s < MQUEUE_FILE_SLOTS; s++) {
+	shdr = (struct mqueue_file *)buf + s;
+	if (!mqueue_file_valid(shdr, sb.st_size) ||
+	    (shdr->crc != my_crc32(buf + shdr->offset, shdr->size)))
+	    continue;
+	if ((hdr == NULL) || (shdr->gen > hdr->gen))
+	    hdr = shdr;
+    }
+    if (hdr == NULL) {
+	munmap(buf, sb.st_size);
+	return(-1);
+    }
+
+    msg = my_malloc(PARENT_MSG_SIZ);
+    end = hdr->offset + hdr->size;
+    for (off = hdr->offset; off < end; off += rec->reclen) {
+	rec = (struct mqueue_file_rec *)(buf + off);
+	if ((end - off < MQUEUE_FILE_RECLEN(0)) ||
+	    (rec->len > ETHER_MAX_LEN) ||
+	    (rec->reclen != MQUEUE_FILE_RECLEN(rec->len)) ||
+	    (rec->reclen > end - off))
+	    break;
+	if ((rec->received + rec->ttl) < now)
+	    continue;
+
+	memset(msg, 0, offsetof(struct parent_msg, peer));
+	msg->index = rec->index;
+	strlcpy(msg->name, rec->name, sizeof(msg->name));
+	msg->proto = rec->proto;
+	msg->ttl = rec->ttl;
+	msg->len = rec->len;
+	memcpy(msg->msg, rec->msg, rec->len);
+	queue(msg, rec->received);
+	count++;
+    }
+
+    peer_free(msg);
+    free(msg);
+    munmap(buf, sb.st_size);
+    return(count);
+}
+
 struct netif *netif_iter(struct netif *netif, struct nhead *netifs) {
 
     if (netifs == NULL)
@@ -308,24 +1739,31 @@ struct netif *netif_iter(struct netif *netif, struct nhead *netifs) {
 	netif = TAILQ_NEXT(netif, entries);
 
     for (; netif != NULL; netif = TAILQ_NEXT(netif, entries)) {
-	// skip autodetected children
-	if (!(options & OPT_ARGV) && netif->child)
-	    continue;
+	if (netif_listed(netif))
+	    break;
+    }
 
-	// skip unlisted interfaces
-	if ((options & OPT_ARGV) && (netif->argv == 0))
-	    continue;
+    return(netif);
+}
 
-	// skip parents without subifs
-	if ((netif->type > NETIF_PARENT) && (netif->subif == NULL)) {
-	    my_log(INFO, "skipping interface %s", netif->name);
-	    continue;
-	}
+// check if netif_iter would return the given netif
+int netif_listed(struct netif *netif) {
 
-	break;
+    // skip autodetected children
+    if (!(options & OPT_ARGV) && netif->child)
+	return(0);
+
+    // skip unlisted interfaces
+    if ((options & OPT_ARGV) && (netif->argv == 0))
+	return(0);
+
+    // skip parents without subifs
+    if ((netif->type > NETIF_PARENT) && (netif->subif == NULL)) {
+	my_log(INFO, "skipping interface %s", netif->name);
+	return(0);
     }
 
-    return(netif);
+    return(1);
 }
 
 struct netif *subif_iter(struct netif *subif, struct netif *netif) {
@@ -362,10 +1800,9 @@ void netif_protos(struct netif *netif, struct mhead *mqueue) {
     uint16_t protos = 0;
     
     while ((subif = subif_iter(subif, netif)) != NULL) {
-	TAILQ_FOREACH(qmsg, mqueue, entries) {
-	    if (subif->index == qmsg->index)
-		protos |= (1 << qmsg->proto);
-	}
+	qmsg = NULL;
+	while ((qmsg = mqueue_iter(qmsg, mqueue, subif->index)) != NULL)
+	    protos |= (1 << qmsg->proto);
     }
     netif->protos = protos;
 }
@@ -382,10 +1819,7 @@ void netif_descr(struct netif *netif, struct mhead *mqueue) {
     if (options & OPT_USEDESCR)
 	peer_suffix = PEER_PORTDESCR;
 
-    TAILQ_FOREACH(qmsg, mqueue, entries) {
-	if (netif->index != qmsg->index)
-	    continue;
-
+    while ((qmsg = mqueue_iter(qmsg, mqueue, netif->index)) != NULL) {
 	if (!peer && qmsg->peer[PEER_HOSTNAME]) {
 	    peer = my_strdup(qmsg->peer[PEER_HOSTNAME]);
 	    peer[strcspn(peer, ".")] = '\0';
@@ -434,6 +1868,8 @@ void netif_descr(struct netif *netif, struct mhead *mqueue) {
 
     if (!my_mreq(mreq))
 	my_log(CRIT, "ifdescr ioctl failed on %s", netif->name);
+    else
+	netif_facts_forget(netif->index, NETIF_FACT_ALIAS);
 
     free(mreq);
 }
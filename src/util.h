@@ -38,6 +38,7 @@ void __my_fatal(const char *func, int err, const char *fmt, ...) __noreturn;
 
 void *my_malloc(size_t size);
 void *my_calloc(size_t, size_t);
+void *my_realloc(void *, size_t);
 char *my_strdup(const char *str);
 int my_socket(int af, int type, int proto);
 void my_socketpair(int spair[]);
@@ -49,24 +50,109 @@ void my_rlimit_child();
 
 int read_line(const char *path, char *line, uint16_t len) __nonnull();
 int write_line(const char *path, char *line, uint16_t len) __nonnull();
+// simd kernels, see my_simd_select
+#define MY_SIMD_AUTO	-1
+#define MY_SIMD_SCALAR	0
+#define MY_SIMD_SSE2	1
+#define MY_SIMD_AVX2	2
+#define MY_SIMD_NEON	3
+int my_simd_select(int level);
 uint16_t my_chksum(const void *data, size_t length, int cisco) __nonnull();
+size_t my_strnvis(char *dst, const void *src, size_t len, int flag)
+    __nonnull();
+uint32_t my_crc32(const void *data, size_t length) __nonnull();
 
 ssize_t my_mreq(struct parent_req *mreq);
+uint32_t my_mreq_queue(struct parent_req *mreq);
+int my_mreq_flush();
+void my_mreq_drop();
+int my_msend(int fd, struct parent_msg *msgs, int count);
+int my_mrecv(int fd, struct parent_msg *msgs, int count);
+char *peer_alloc(struct parent_msg *, size_t len);
+char *peer_strdup(struct parent_msg *, const char *);
+void peer_free(struct parent_msg *);
+struct peer_record *peer_record(struct parent_msg *);
+struct peer_record *peer_record_fields(struct parent_msg *, uint16_t fields,
+    struct peer_record *);
 
 struct netif *netif_iter(struct netif *netif, struct nhead *);
+int netif_listed(struct netif *);
 struct netif *subif_iter(struct netif *subif, struct netif *netif);
 int netif_excluded(struct netif *netif, struct ehead *);
 void netif_protos(struct netif *netif, struct mhead *mqueue);
 void netif_descr(struct netif *netif, struct mhead *mqueue);
+uint32_t netif_gen(struct netif *);
+void netif_frames_free(struct netif *);
 void portname_abbr(char *);
 
+void netif_list_init(struct nhead *);
+void netif_list_insert(struct nhead *, struct netif *);
+void netif_list_remove(struct nhead *, struct netif *);
+void netif_list_rehash(struct nhead *, struct netif *);
+void netif_list_free(struct nhead *);
+
+void mqueue_init(struct mhead *);
+struct parent_msg *mqueue_lookup(struct mhead *, struct parent_msg *);
+void mqueue_insert(struct mhead *, struct parent_msg *);
+void mqueue_remove(struct mhead *, struct parent_msg *);
+void mqueue_update(struct mhead *, struct parent_msg *);
+void mqueue_replace(struct mhead *, struct parent_msg *, struct parent_msg *);
+void mqueue_unref(struct parent_msg *);
+struct mqueue_snap *mqueue_snapshot(struct mhead *);
+void mqueue_snap_unref(struct mhead *, struct mqueue_snap *);
+struct parent_msg *mqueue_expired(struct mhead *, time_t now);
+struct parent_msg *mqueue_iter(struct parent_msg *, struct mhead *,
+				uint32_t index);
+void mqueue_free(struct mhead *);
+int mqueue_save(struct mhead *, int fd, time_t now);
+int mqueue_load(int fd, time_t now, void (*)(struct parent_msg *, time_t));
+
+static inline
+uint32_t netif_hash_index(uint32_t index) {
+    return(index * 2654435761U);
+}
+
+// fnv-1a
+static inline
+uint32_t netif_hash_bytes(const uint8_t *data, size_t len) {
+    uint32_t h = 2166136261U;
+
+    for (size_t i = 0; i < len && data[i] != 0; i++)
+	h = (h ^ data[i]) * 16777619U;
+    return(h);
+}
+
+static inline
+uint32_t netif_hash_addr(const uint8_t *hwaddr) {
+    uint32_t h = 2166136261U;
+
+    for (int i = 0; i < ETHER_ADDR_LEN; i++)
+	h = (h ^ hwaddr[i]) * 16777619U;
+    return(h);
+}
+
+static inline
+struct netif *netif_hash_bucket(struct netif_hash *hash, int key, uint32_t h) {
+    return(hash->buckets[key][h & (hash->size - 1)]);
+}
+
 static inline
 struct netif *netif_byindex(struct nhead *netifs, uint32_t index) {
     struct netif *netif = NULL;
 
     assert(netifs);
 
-    TAILQ_FOREACH(netif, netifs, entries) {
+    if (netifs->hash == NULL) {
+	TAILQ_FOREACH(netif, netifs, entries) {
+	    if (netif->index == index)
+		break;
+	}
+	return(netif);
+    }
+
+    netif = netif_hash_bucket(netifs->hash, NETIF_HASH_INDEX,
+		netif_hash_index(index));
+    for (; netif != NULL; netif = netif->hnext[NETIF_HASH_INDEX]) {
 	if (netif->index == index)
 	    break;
     }
@@ -79,7 +165,17 @@ struct netif *netif_byname(struct nhead *netifs, char *name) {
 
     assert((netifs != NULL) && (name != NULL));
 
-    TAILQ_FOREACH(netif, netifs, entries) {
+    if (netifs->hash == NULL) {
+	TAILQ_FOREACH(netif, netifs, entries) {
+	    if (strcmp(netif->name, name) == 0)
+		break;
+	}
+	return(netif);
+    }
+
+    netif = netif_hash_bucket(netifs->hash, NETIF_HASH_NAME,
+		netif_hash_bytes((uint8_t *)name, IFNAMSIZ));
+    for (; netif != NULL; netif = netif->hnext[NETIF_HASH_NAME]) {
 	if (strcmp(netif->name, name) == 0)
 	    break;
     }
@@ -92,7 +188,17 @@ struct netif *netif_byaddr(struct nhead *netifs, uint8_t *hwaddr) {
 
     assert((netifs != NULL) && (hwaddr != NULL));
 
-    TAILQ_FOREACH(netif, netifs, entries) {
+    if (netifs->hash == NULL) {
+	TAILQ_FOREACH(netif, netifs, entries) {
+	    if (memcmp(netif->hwaddr, hwaddr, ETHER_ADDR_LEN) == 0)
+		break;
+	}
+	return(netif);
+    }
+
+    netif = netif_hash_bucket(netifs->hash, NETIF_HASH_ADDR,
+		netif_hash_addr(hwaddr));
+    for (; netif != NULL; netif = netif->hnext[NETIF_HASH_ADDR]) {
 	if (memcmp(netif->hwaddr, hwaddr, ETHER_ADDR_LEN) == 0)
 	    break;
     }
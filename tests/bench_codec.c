@@ -0,0 +1,165 @@
+/*
+ * $Id$
+ *
+ * Copyright (c) 2008, 2009, 2010
+ *      Sten Spans <sten@blinkenlights.nl>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "common.h"
+#include "util.h"
+#include "proto/protos.h"
+#include "main.h"
+#include "check_wrap.h"
+#include <pcap.h>
+#include <time.h>
+
+uint32_t options = OPT_DAEMON;
+
+#define BENCH_ROUNDS	2000
+#define BENCH_STRLEN	511
+#define BENCH_FRAMES	1024
+
+struct bench_frame {
+    uint8_t *data;
+    size_t len;
+};
+
+static struct bench_frame frames[BENCH_FRAMES];
+static struct bench_frame strings[BENCH_FRAMES];
+static size_t nframes, nstrings;
+
+static const char *levels[] = { "scalar", "sse2", "avx2", "neon" };
+
+static double bench_now() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return(ts.tv_sec * 1e9 + ts.tv_nsec);
+}
+
+// load the frames of the protocol corpus, the printable runs in them
+// stand in for the hostname and description tlvs
+static void bench_frame(const struct pcap_pkthdr *p_pkthdr,
+			const u_char *data, void *arg) {
+    size_t i, start;
+
+    if ((p_pkthdr->caplen <= ETHER_HDR_LEN) || (nframes == BENCH_FRAMES))
+	return;
+
+    frames[nframes].len = p_pkthdr->caplen - ETHER_HDR_LEN;
+    frames[nframes].data = my_malloc(frames[nframes].len);
+    memcpy(frames[nframes].data, data + ETHER_HDR_LEN, frames[nframes].len);
+
+    for (i = ETHER_HDR_LEN; i < p_pkthdr->caplen; i++) {
+	for (start = i; (i < p_pkthdr->caplen) &&
+	     (data[i] >= ' ') && (data[i] <= '~'); i++);
+	if ((i - start < 4) || (nstrings == BENCH_FRAMES))
+	    continue;
+	// include the terminating byte, it's escaped as well
+	strings[nstrings].len = MIN(i - start + 1, BENCH_STRLEN);
+	strings[nstrings].len = MIN(strings[nstrings].len,
+				    p_pkthdr->caplen - start);
+	strings[nstrings].data = my_malloc(BENCH_STRLEN + 1);
+	memcpy(strings[nstrings].data, data + start, strings[nstrings].len);
+	nstrings++;
+    }
+    nframes++;
+}
+
+// the 16-bit loop my_chksum used before the kernels
+static uint16_t chksum_legacy(const void *data, size_t length) {
+    const uint16_t *d = (const uint16_t *)data;
+    uint32_t sum = 0;
+
+    while (length > 1) {
+	sum += *d++;
+	length -= 2;
+    }
+    if (length)
+	sum += htons(*(const uint8_t *)d << 8);
+
+    sum = (sum >> 16) + (sum & 0xffff);
+    sum += (sum >> 16);
+    return (uint16_t)~sum;
+}
+
+static double bench_chksum(int legacy) {
+    volatile uint16_t sum = 0;
+    double start, bytes = 0;
+
+    start = bench_now();
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+	for (size_t i = 0; i < nframes; i++) {
+	    if (legacy)
+		sum += chksum_legacy(frames[i].data, frames[i].len);
+	    else
+		sum += my_chksum(frames[i].data, frames[i].len, 0);
+	    bytes += frames[i].len;
+	}
+    }
+    return((bench_now() - start) / bytes);
+}
+
+static double bench_strnvis(int legacy) {
+    char str[BENCH_STRLEN + 1], vis[BENCH_STRLEN * 4 + 1];
+    volatile size_t len = 0;
+    double start, bytes = 0;
+
+    start = bench_now();
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+	for (size_t i = 0; i < nstrings; i++) {
+	    // the copy to a terminated buffer tlv_str_copy used to make
+	    if (legacy) {
+		memcpy(str, strings[i].data, strings[i].len);
+		str[strings[i].len] = '\0';
+		len += strnvis(vis, str, sizeof(vis), VIS_SAFE|VIS_OCTAL);
+	    } else {
+		len += my_strnvis(vis, strings[i].data, strings[i].len,
+				  VIS_SAFE|VIS_OCTAL);
+	    }
+	    bytes += strings[i].len;
+	}
+    }
+    return((bench_now() - start) / bytes);
+}
+
+int main() {
+    const char *dirs[] = { "lldp", "cdp", "edp", "fdp", NULL };
+    double chksum_base, vis_base, chksum, vis;
+
+    for (int d = 0; dirs[d] != NULL; d++) {
+	if (read_corpus(dirs[d], bench_frame, NULL) == -1)
+	    exit(EXIT_FAILURE);
+    }
+
+    printf("%zu frames, %zu strings\n", nframes, nstrings);
+
+    chksum_base = bench_chksum(1);
+    vis_base = bench_strnvis(1);
+    printf("%-8s chksum %6.3f ns/byte, strnvis %6.3f ns/byte\n",
+	"legacy", chksum_base, vis_base);
+
+    for (int l = MY_SIMD_SCALAR; l <= MY_SIMD_NEON; l++) {
+	if (my_simd_select(l) == -1)
+	    continue;
+	chksum = bench_chksum(0);
+	vis = bench_strnvis(0);
+	printf("%-8s chksum %6.3f ns/byte (%4.1fx), "
+	       "strnvis %6.3f ns/byte (%4.1fx)\n", levels[l],
+	       chksum, chksum_base / chksum, vis, vis_base / vis);
+    }
+
+    return(EXIT_SUCCESS);
+}
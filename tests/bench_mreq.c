@@ -0,0 +1,106 @@
+/*
+ * $Id$
+ *
+ * Copyright (c) 2008, 2009, 2010
+ *      Sten Spans <sten@blinkenlights.nl>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "common.h"
+#include "util.h"
+#include "proto/protos.h"
+#include "main.h"
+#include "parent.h"
+#include <signal.h>
+#include <time.h>
+
+uint32_t options = OPT_DAEMON;
+
+// the requests made per interface on every tick
+#define BENCH_NETIFS	48
+#define BENCH_TICKS	200
+#define BENCH_INDEX	1000000
+
+static uint8_t bench_ops[] = { PARENT_ETHTOOL_GDRV, PARENT_DEVICE,
+			       PARENT_ALIAS, PARENT_ETHTOOL_GLINK };
+#define BENCH_OPS	(sizeof(bench_ops) / sizeof(bench_ops[0]))
+
+extern int msock;
+extern uint32_t mreq_trips;
+
+static double bench_now() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return(ts.tv_sec * 1e9 + ts.tv_nsec);
+}
+
+static void bench_run(const char *desc, int pipelined) {
+    struct parent_req mreq = {};
+    uint32_t trips = mreq_trips;
+    double start, elapsed;
+
+    start = bench_now();
+    for (int t = 0; t < BENCH_TICKS; t++) {
+
+	// queue everything up front
+	for (int i = 0; pipelined && (i < BENCH_NETIFS); i++) {
+	    for (int o = 0; o < BENCH_OPS; o++) {
+		memset(&mreq, 0, PARENT_REQ_MAX);
+		mreq.op = bench_ops[o];
+		mreq.index = BENCH_INDEX + i;
+		my_mreq_queue(&mreq);
+	    }
+	}
+	my_mreq_flush();
+
+	for (int i = 0; i < BENCH_NETIFS; i++) {
+	    for (int o = 0; o < BENCH_OPS; o++) {
+		memset(&mreq, 0, PARENT_REQ_MAX);
+		mreq.op = bench_ops[o];
+		mreq.index = BENCH_INDEX + i;
+		my_mreq(&mreq);
+	    }
+	}
+	my_mreq_drop();
+    }
+    elapsed = bench_now() - start;
+
+    printf("%-9s %3d netifs: %6.1f round trips, %8.1f us per tick\n", desc,
+	BENCH_NETIFS, (double)(mreq_trips - trips) / BENCH_TICKS,
+	elapsed / BENCH_TICKS / 1000);
+}
+
+int main() {
+    int spair[2];
+    pid_t pid;
+
+    my_socketpair(spair);
+
+    // the parent side answers via the regular request handler,
+    // unknown ifindexes keep the work on that side minimal
+    if ((pid = fork()) == 0) {
+	close(spair[0]);
+	for (;;)
+	    parent_req(spair[1], 0);
+    }
+    close(spair[1]);
+    msock = spair[0];
+
+    bench_run("sync", 0);
+    bench_run("pipelined", 1);
+
+    kill(pid, SIGTERM);
+    return(EXIT_SUCCESS);
+}
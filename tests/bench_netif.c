@@ -0,0 +1,90 @@
+/*
+ * $Id$
+ *
+ * Copyright (c) 2008, 2009, 2010
+ *      Sten Spans <sten@blinkenlights.nl>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "common.h"
+#include "util.h"
+#include "proto/protos.h"
+#include "main.h"
+#include <time.h>
+
+uint32_t options = OPT_DAEMON;
+
+#define BENCH_NETIFS	10000
+#define BENCH_LOOKUPS	100000
+
+static double bench_now() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return(ts.tv_sec * 1e9 + ts.tv_nsec);
+}
+
+static void bench_run(const char *desc, struct nhead *netifs,
+		      struct netif *tnetifs, int lookups) {
+    struct netif *netif, *found;
+    double start, elapsed;
+
+    start = bench_now();
+    for (int i = 0; i < lookups; i++) {
+	netif = &tnetifs[(i * 7919) % BENCH_NETIFS];
+	found = netif_byindex(netifs, netif->index);
+	found = netif_byname(netifs, netif->name);
+	found = netif_byaddr(netifs, netif->hwaddr);
+	if (found != netif) {
+	    fprintf(stderr, "lookup failed for %s\n", netif->name);
+	    exit(EXIT_FAILURE);
+	}
+    }
+    elapsed = bench_now() - start;
+
+    printf("%-8s %6d netifs: %10.1f ns per lookup\n", desc,
+	BENCH_NETIFS, elapsed / (lookups * 3));
+}
+
+int main() {
+    struct nhead netifs;
+    struct netif *tnetifs, *netif;
+    struct netif_hash *hash;
+
+    netif_list_init(&netifs);
+    tnetifs = my_calloc(BENCH_NETIFS, sizeof(struct netif));
+
+    for (int i = 0; i < BENCH_NETIFS; i++) {
+	netif = &tnetifs[i];
+	netif->index = i + 1;
+	snprintf(netif->name, IFNAMSIZ, "vlan%d", i);
+	netif->hwaddr[0] = 0x02;
+	netif->hwaddr[3] = i >> 16;
+	netif->hwaddr[4] = i >> 8;
+	netif->hwaddr[5] = i;
+	netif_list_insert(&netifs, netif);
+    }
+
+    bench_run("hashed", &netifs, tnetifs, BENCH_LOOKUPS);
+
+    // without the index the lookups fall back to walking the list
+    hash = netifs.hash;
+    netifs.hash = NULL;
+    bench_run("linear", &netifs, tnetifs, BENCH_LOOKUPS / 100);
+    netifs.hash = hash;
+
+    netif_list_free(&netifs);
+    free(tnetifs);
+    return(EXIT_SUCCESS);
+}
@@ -28,16 +28,26 @@
 #include "child.h"
 #include "check_wrap.h"
 
+#ifdef HAVE_NETIF_EVENTS
+#include <libmnl/libmnl.h>
+#include <linux/rtnetlink.h>
+#include <linux/if_link.h>
+#include <linux/if_bonding.h>
+#endif
+
 const char *ifname = NULL;
 unsigned int ifindex = 0;
 
 uint32_t options = OPT_DAEMON | OPT_CHECK;
 extern struct nhead netifs;
 extern struct mhead mqueue;
+extern struct shead watchers;
 extern struct my_sysinfo sysinfo;
 extern int msock;
 
 START_TEST(test_child_init) {
+    extern uint32_t mreq_trips;
+    uint32_t trips;
     struct parent_req *mreq;
     struct netif *netif, *nnetif;
     const char *errstr = NULL;
@@ -70,6 +80,24 @@ START_TEST(test_child_init) {
     if (netif_fetch(0, NULL, &sysinfo, &netifs) == 0)
 	return;
 
+    // static interface facts are cached
+    mark_point();
+    trips = mreq_trips;
+    netif_fetch(0, NULL, &sysinfo, &netifs);
+    fail_unless (mreq_trips == trips,
+	"%u parent round trips on a steady-state fetch", mreq_trips - trips);
+
+    // and so are the media details while events keep them current
+    mark_point();
+    TAILQ_FOREACH(netif, &netifs, entries)
+	netif_media(netif);
+    trips = mreq_trips;
+    TAILQ_FOREACH(netif, &netifs, entries)
+	netif_media(netif);
+    fail_unless (mreq_trips == trips,
+	"%u parent round trips on a steady-state media check",
+	mreq_trips - trips);
+
     mark_point();
     null = open(_PATH_DEVNULL, O_WRONLY);
     pwd = getpwnam("nobody");
@@ -86,16 +114,70 @@ START_TEST(test_child_init) {
     loglevel = INFO;
     options = OPT_DAEMON | OPT_CHECK;
     TAILQ_FOREACH_SAFE(netif, &netifs, entries, nnetif) {
-	TAILQ_REMOVE(&netifs, netif, entries);
+	netif_list_remove(&netifs, netif);
     }
     close(spair[0]);
 }
 END_TEST
 
+START_TEST(test_child_wheel) {
+    struct child_wheel wheel = {};
+    uint32_t i, slot, load, total = 0;
+    uint32_t entries = 250 * 4;
+
+    mark_point();
+    event_init();
+    child_wheel_reset(&wheel);
+    fail_unless (wheel.seed != 0, "wheel seed missing");
+
+    for (i = 0; i < entries; i++)
+	child_wheel_insert(&wheel, i / 4 + 1, i / 4 + 1, i % 4);
+    fail_unless (wheel.count == entries, "%u frames scheduled", wheel.count);
+
+    // the slot lists match the load counters
+    for (slot = 0; slot < CHILD_WHEEL_SLOTS; slot++) {
+	load = 0;
+	for (i = wheel.slots[slot]; i != CHILD_WHEEL_NONE; i = wheel.tx[i].next)
+	    load++;
+	fail_unless (load == wheel.load[slot], "slot %u load mismatch", slot);
+	total += load;
+    }
+    fail_unless (total == entries, "%u frames on the wheel", total);
+
+    // and the load is spread over the interval
+    fail_unless (wheel.used > CHILD_WHEEL_SLOTS / 2,
+	"only %u slots used", wheel.used);
+    fail_unless (wheel.peak <= 6 * entries / CHILD_WHEEL_SLOTS,
+	"peak load of %u frames", wheel.peak);
+
+    // draining skips unknown interfaces
+    mark_point();
+    child_wheel_arm(-1, &wheel, 0);
+    fail_unless (wheel.pending == 1, "wheel not armed");
+    fail_unless (wheel.load[wheel.pos] > 0, "armed on an empty slot");
+    child_wheel_drain(-1, &wheel);
+    fail_unless (wheel.count == 0, "frames left on the wheel");
+    fail_unless (wheel.pending == 0, "drained wheel still armed");
+
+    // a new round starts empty
+    mark_point();
+    child_wheel_reset(&wheel);
+    fail_unless (wheel.count == 0 && wheel.used == 0 && wheel.peak == 0,
+	"wheel not reset");
+    child_wheel_arm(-1, &wheel, 0);
+    fail_unless (wheel.pending == 0, "empty wheel armed");
+
+    free(wheel.tx);
+}
+END_TEST
+
 START_TEST(test_child_send) {
+    extern uint32_t frame_hits, frame_builds;
+    uint32_t hits, builds;
     struct parent_req *mreq;
     struct netif *netif, *nnetif;
     int spair[2], null;
+    uint32_t count;
     struct child_send_args args = { .index = -1 };
     pid_t pid;
 
@@ -141,16 +223,242 @@ START_TEST(test_child_send) {
     protos[PROTO_CDP].enabled = 1;
     child_send(null, EV_TIMEOUT, &args);
 
+    // periodic frames are spread over the wheel
+    mark_point();
+    options |= OPT_SEND;
+    builds = frame_builds;
+    hits = frame_hits;
+    child_send(null, EV_TIMEOUT, &args);
+    fail_unless (frame_builds + frame_hits == builds + hits,
+	"frames sent before their slot");
+    fail_unless (args.wheel.count > 0, "no frames scheduled");
+    fail_unless (args.wheel.pending == 1, "wheel not armed");
+    fail_unless (args.wheel.used <= args.wheel.count, "invalid slot count");
+    count = args.wheel.count;
+    child_wheel_drain(null, &args.wheel);
+    fail_unless (args.wheel.count == 0, "frames left on the wheel");
+    fail_unless (args.wheel.pending == 0, "drained wheel still armed");
+    fail_unless (frame_builds + frame_hits - builds - hits == count,
+	"%u of %u scheduled frames sent",
+	frame_builds + frame_hits - builds - hits, count);
+
+    // unchanged frames are sent from the cache
+    mark_point();
+    builds = frame_builds;
+    hits = frame_hits;
+    child_send(null, EV_TIMEOUT, &args);
+    child_wheel_drain(null, &args.wheel);
+    fail_unless (frame_builds == builds,
+	"%u unchanged frames rebuilt", frame_builds - builds);
+
+    // and rebuilt when an input changes
+    mark_point();
+    builds = frame_builds;
+    hits = frame_hits - hits;
+    strlcpy(sysinfo.location, "check", sizeof(sysinfo.location));
+    child_send(null, EV_TIMEOUT, &args);
+    child_wheel_drain(null, &args.wheel);
+    fail_unless (frame_builds - builds == hits,
+	"%u of %u frames rebuilt", frame_builds - builds, hits);
+    memset(sysinfo.location, 0, sizeof(sysinfo.location));
+    options &= ~OPT_SEND;
+
     // reset
     kill(pid, SIGTERM);
     TAILQ_FOREACH_SAFE(netif, &netifs, entries, nnetif) {
-	TAILQ_REMOVE(&netifs, netif, entries);
+	netif_list_remove(&netifs, netif);
     }
 }
 END_TEST
 
+START_TEST(test_child_tx) {
+    extern uint32_t frame_hits, frame_builds;
+    struct parent_req *mreq;
+    struct netif *netif = NULL, *subif = NULL, *nnetif;
+    struct child_send_args args = { .index = -1 };
+    struct child_link_args largs = {};
+    int spair[2], null, i;
+    uint32_t sent;
+    time_t now = 100;
+    pid_t pid;
+
+    loglevel = INFO;
+    my_socketpair(spair);
+    msock = spair[0];
+    null = open(_PATH_DEVNULL, O_WRONLY);
+    netif_init();
+    event_init();
+
+    // start a dummy replier
+    pid = fork();
+    if (pid == 0) {
+	close(spair[0]);
+	mreq = my_malloc(PARENT_REQ_MAX);
+	while (read(spair[1], mreq, PARENT_REQ_MAX) > 0) {
+	    if (mreq->op == PARENT_DEVICE)
+		mreq->len = 1;
+	    if (write(spair[1], mreq, PARENT_REQ_LEN(mreq->len)) == -1)
+		exit(1);
+	}
+	exit (0);
+    }
+    close(spair[1]);
+
+    // fetch the interfaces and send the initial frames
+    mark_point();
+    options |= OPT_SEND;
+    protos[PROTO_LLDP].enabled = 1;
+    child_send(null, 0, &args);
+
+    while ((netif = netif_iter(netif, &netifs)) != NULL) {
+	if (child_send_skip(netif))
+	    continue;
+	while ((subif = subif_iter(subif, netif)) != NULL) {
+	    if (!child_send_skip(subif))
+		break;
+	}
+	if (subif != NULL)
+	    break;
+    }
+    fail_if (subif == NULL, "no interface found");
+
+    // new ports start with full credit
+    mark_point();
+    fail_unless (child_tx_credit(subif, now) == TX_CREDIT_MAX,
+	"invalid initial credit");
+
+    // a fast start sends one frame per tick
+    mark_point();
+    child_tx_fast(subif, TX_FAST_INIT);
+    for (i = 1; i <= TX_FAST_INIT; i++) {
+	sent = frame_builds + frame_hits;
+	fail_unless (child_tx_run(null, now) == (i < TX_FAST_INIT),
+	    "invalid number of waiting ports");
+	fail_unless (frame_builds + frame_hits - sent == 1,
+	    "fast transmit %d not sent", i);
+    }
+    fail_unless (subif->tx_fast == 0, "fast transmits left");
+    fail_unless (subif->tx_credit == TX_CREDIT_MAX - TX_FAST_INIT,
+	"credit not used");
+
+    // without credit ports wait for the refill
+    mark_point();
+    child_tx_fast(subif, TX_FAST_INIT);
+    child_tx_run(null, now);
+    sent = frame_builds + frame_hits;
+    fail_unless (child_tx_run(null, now) == 1, "port should be waiting");
+    fail_unless (frame_builds + frame_hits == sent, "sent without credit");
+
+    // including link events for all ports
+    mark_point();
+    largs.all = 1;
+    subif->tx_refill = time(NULL) + 60;
+    child_link_flush(null, 0, &largs);
+    fail_unless (frame_builds + frame_hits == sent, "sent without credit");
+    fail_unless (largs.all == 0, "link events not cleared");
+    subif->tx_credit = 1;
+    largs.all = 1;
+    child_link_flush(null, 0, &largs);
+    fail_unless (frame_builds + frame_hits - sent == 1,
+	"link events should use the credit");
+    fail_unless (subif->tx_credit == 0, "credit not used");
+    sent = frame_builds + frame_hits;
+    subif->tx_refill = now;
+
+    // which adds a credit per second
+    mark_point();
+    now += 2;
+    child_tx_run(null, now);
+    child_tx_run(null, now);
+    fail_unless (frame_builds + frame_hits - sent == 2,
+	"refilled credit not used");
+    fail_unless (child_tx_run(null, now) == 1, "port should be waiting");
+    now += 60;
+    fail_unless (child_tx_credit(subif, now) == TX_CREDIT_MAX,
+	"credit should be capped");
+    fail_unless (child_tx_run(null, now) == 0, "fast transmits left");
+
+    // reset
+    options &= ~OPT_SEND;
+    kill(pid, SIGTERM);
+    TAILQ_FOREACH_SAFE(netif, &netifs, entries, nnetif) {
+	netif_list_remove(&netifs, netif);
+    }
+    close(spair[0]);
+    close(null);
+}
+END_TEST
+
+START_TEST(test_child_link_queue) {
+    struct parent_req *mreq;
+    struct netif *netif, *nnetif;
+    struct child_link_args largs = {};
+    int spair[2], null;
+    pid_t pid;
+
+    loglevel = INFO;
+    my_socketpair(spair);
+    msock = spair[0];
+    null = open(_PATH_DEVNULL, O_WRONLY);
+    netif_init();
+    event_init();
+    event_set(&largs.event, null, 0, child_link_flush, &largs);
+
+    // start a dummy replier
+    pid = fork();
+    if (pid == 0) {
+	close(spair[0]);
+	mreq = my_malloc(PARENT_REQ_MAX);
+	while (read(spair[1], mreq, PARENT_REQ_MAX) > 0) {
+	    if (mreq->op == PARENT_DEVICE)
+		mreq->len = 1;
+	    if (write(spair[1], mreq, PARENT_REQ_LEN(mreq->len)) == -1)
+		exit(1);
+	}
+	exit (0);
+    }
+    close(spair[1]);
+
+    // duplicate events are coalesced
+    mark_point();
+    child_link_queue(&largs, 1);
+    child_link_queue(&largs, 9001);
+    child_link_queue(&largs, 1);
+    fail_unless (largs.pending == 1, "link events should be pending");
+    fail_unless (largs.count == 2, "link events not coalesced");
+    fail_unless (largs.all == 0, "link events should be targeted");
+
+    // handled by a single flush
+    mark_point();
+    event_loop(EVLOOP_ONCE);
+    fail_unless (largs.pending == 0, "link events not handled");
+    fail_unless (largs.count == 0, "link events not cleared");
+
+    // too many interfaces
+    mark_point();
+    for (int i = 0; i <= LINK_BATCH; i++)
+	child_link_queue(&largs, 9000 + i);
+    fail_unless (largs.count == LINK_BATCH, "incorrect link event count");
+    fail_unless (largs.all == 1, "all interfaces should be handled");
+    child_link_flush(null, 0, &largs);
+    fail_unless (largs.all == 0, "link events not cleared");
+    event_del(&largs.event);
+
+    // reset
+    kill(pid, SIGTERM);
+    TAILQ_FOREACH_SAFE(netif, &netifs, entries, nnetif) {
+	netif_list_remove(&netifs, netif);
+    }
+    close(spair[0]);
+    close(null);
+}
+END_TEST
+
 START_TEST(test_child_queue) {
+    extern uint32_t queue_hits, queue_decodes;
+    uint32_t hits, decodes;
     struct parent_msg msg, *dmsg, *nmsg;
+    struct mqueue_snap *snap;
     struct netif netif;
     struct ether_hdr ether;
     static uint8_t lldp_dst[] = LLDP_MULTICAST_ADDR;
@@ -177,7 +485,7 @@ START_TEST(test_child_queue) {
     memset(&netif, 0, sizeof(struct netif));
     netif.index = ifindex;
     strlcpy(netif.name, ifname, IFNAMSIZ);
-    TAILQ_INSERT_TAIL(&netifs, &netif, entries);
+    netif_list_insert(&netifs, &netif);
     msg.index = ifindex;
     WRAP_WRITE(spair[0], &msg, PARENT_MSG_LEN(msg.len));
     child_queue(spair[1], event);
@@ -208,11 +516,40 @@ START_TEST(test_child_queue) {
     WRAP_WRITE(spair[0], &msg, PARENT_MSG_LEN(msg.len));
     child_queue(spair[1], event);
 
-    // and the same peer again
+    // and the same peer again, refreshed without a decode
     mark_point();
+    hits = queue_hits;
+    decodes = queue_decodes;
+    dmsg = TAILQ_FIRST(&mqueue);
+    dmsg->received = 0;
     read_packet(&msg, "proto/lldp/42.good.big");
     WRAP_WRITE(spair[0], &msg, PARENT_MSG_LEN(msg.len));
     child_queue(spair[1], event);
+    fail_unless((queue_hits == hits + 1) && (queue_decodes == decodes),
+	"unchanged message should skip the decode");
+    fail_unless((TAILQ_FIRST(&mqueue) == dmsg) && (dmsg->received != 0),
+	"unchanged message should be refreshed");
+
+    // updates to a message held by a snapshot are copied
+    mark_point();
+    snap = mqueue_snapshot(&mqueue);
+    dmsg = TAILQ_FIRST(&mqueue);
+    decodes = queue_decodes;
+    read_packet(&msg, "proto/lldp/42.good.big");
+    WRAP_WRITE(spair[0], &msg, PARENT_MSG_LEN(msg.len));
+    child_queue(spair[1], event);
+    fail_unless(queue_decodes == decodes + 1,
+	"held message should be decoded");
+    fail_unless(TAILQ_FIRST(&mqueue) != dmsg,
+	"held message should be replaced");
+    fail_unless(TAILQ_NEXT(TAILQ_FIRST(&mqueue), entries) == NULL,
+	"invalid message count");
+    fail_unless((snap->msgs[0] == dmsg) && (dmsg->refs == 1),
+	"held message should stay in the snapshot");
+    fail_unless(strcmp(dmsg->peer[PEER_HOSTNAME],
+	TAILQ_FIRST(&mqueue)->peer[PEER_HOSTNAME]) == 0,
+	"held message should stay intact");
+    mqueue_snap_unref(&mqueue, snap);
 
     // test with OPT_AUTO
     mark_point();
@@ -231,9 +568,9 @@ START_TEST(test_child_queue) {
 
     // reset
     options = OPT_DAEMON | OPT_CHECK;
-    TAILQ_REMOVE(&netifs, &netif, entries);
+    netif_list_remove(&netifs, &netif);
     TAILQ_FOREACH_SAFE(dmsg, &mqueue, entries, nmsg) {
-	TAILQ_REMOVE(&mqueue, dmsg, entries);
+	mqueue_remove(&mqueue, dmsg);
     }
 }
 END_TEST
@@ -241,6 +578,7 @@ END_TEST
 START_TEST(test_child_expire) {
     const char *errstr = NULL;
     struct parent_msg msg, *dmsg;
+    struct mqueue_snap *snap;
     struct netif netif;
     int spair[2], count;
     short event = 0;
@@ -251,7 +589,7 @@ START_TEST(test_child_expire) {
     memset(&netif, 0, sizeof(struct netif));
     netif.index = ifindex;
     strlcpy(netif.name, ifname, IFNAMSIZ);
-    TAILQ_INSERT_TAIL(&netifs, &netif, entries);
+    netif_list_insert(&netifs, &netif);
 
     memset(&msg, 0, sizeof(struct parent_msg));
     msg.index = ifindex;
@@ -302,25 +640,13 @@ START_TEST(test_child_expire) {
     }
     fail_unless(count == 3, "invalid message count: %d != 3", count);
 
-    // expire a locked message
+    // expire a message held by a snapshot
     mark_point();
     options |= OPT_AUTO;
     dmsg = TAILQ_FIRST(&mqueue);
     dmsg->received  -= dmsg->ttl * 2;
-    dmsg->lock = 1;
-    child_expire();
-
-    // check the message count
-    count = 0;
-    TAILQ_FOREACH(dmsg, &mqueue, entries) {
-	count++;
-    }
-    fail_unless(count == 3, "invalid message count: %d != 3", count);
-
-    // expire a message
-    mark_point();
-    dmsg = TAILQ_FIRST(&mqueue);
-    dmsg->lock = 0;
+    mqueue_update(&mqueue, dmsg);
+    snap = mqueue_snapshot(&mqueue);
     child_expire();
 
     // check the message count
@@ -329,16 +655,23 @@ START_TEST(test_child_expire) {
 	count++;
     }
     fail_unless(count == 2, "invalid message count: %d != 2", count);
+    fail_unless(snap->count == 3, "invalid snapshot count: %u != 3",
+	snap->count);
+    fail_unless(snap->msgs[0]->refs == 1,
+	"expired message should only be held by the snapshot");
+    mqueue_snap_unref(&mqueue, snap);
 
     // expire a message
     mark_point();
     dmsg = TAILQ_FIRST(&mqueue);
     dmsg->received -= dmsg->ttl * 2;
+    mqueue_update(&mqueue, dmsg);
     child_expire();
 
     mark_point();
     dmsg = TAILQ_FIRST(&mqueue);
     dmsg->received -= dmsg->ttl * 2;
+    mqueue_update(&mqueue, dmsg);
     child_expire();
 
     // check the message count
@@ -346,17 +679,25 @@ START_TEST(test_child_expire) {
 
     // reset
     options = OPT_DAEMON | OPT_CHECK;
-    TAILQ_REMOVE(&netifs, &netif, entries);
+    netif_list_remove(&netifs, &netif);
 }
 END_TEST
 
 START_TEST(test_child_cli) {
     const char *errstr = NULL;
-    int sock, spair[2], i;
+    int sock, spair[2], rpair[2], i;
+    union {
+	struct peer_record rec;
+	char buf[PEER_RECORD_MAX];
+    } rbuf;
+    struct peer_record *rec = &rbuf.rec;
+    struct child_session *session;
+    ssize_t rlen, total;
+    struct cli_query query = { .version = CLI_VERSION, .proto = UINT8_MAX };
     struct sockaddr_in sa;
     socklen_t len = sizeof(sa);
     pid_t pid;
-    struct parent_msg msg;
+    struct parent_msg msg, *dmsg;
     struct ether_hdr ether;
     static uint8_t lldp_dst[] = LLDP_MULTICAST_ADDR;
     struct netif netif;
@@ -372,7 +713,7 @@ START_TEST(test_child_cli) {
     memset(&netif, 0, sizeof(struct netif));
     netif.index = ifindex;
     strlcpy(netif.name, ifname, IFNAMSIZ);
-    TAILQ_INSERT_TAIL(&netifs, &netif, entries);
+    netif_list_insert(&netifs, &netif);
 
     memset(&msg, 0, sizeof(struct parent_msg));
     msg.len = ETHER_MIN_LEN;
@@ -412,7 +753,10 @@ START_TEST(test_child_cli) {
 	    sock = my_socket(AF_INET, SOCK_STREAM, 0);
 	    if (connect(sock, (struct sockaddr *)&sa, sizeof(sa)) == -1)
 		exit(EXIT_FAILURE);
-	    while (read(sock, &msg, PARENT_MSG_MAX) > 0) {
+	    query.fields = CLI_FIELD_FRAME;
+	    if (write(sock, &query, CLI_QUERY_LEN(0)) == -1)
+		exit(EXIT_FAILURE);
+	    while (read(sock, &rbuf, sizeof(rbuf)) > 0) {
 		continue;
 	    }
 	    close(sock);
@@ -437,6 +781,196 @@ START_TEST(test_child_cli) {
     mark_point();
     event_loop(EVLOOP_ONCE);
 
+    // records for clients which ask for them
+    mark_point();
+    fail_if(socketpair(AF_UNIX, SOCK_SEQPACKET, 0, rpair) == -1,
+	"socketpair creation failed");
+    query.fields = CLI_FIELDS_PEER;
+    fail_unless(write(rpair[0], &query, CLI_QUERY_LEN(0)) ==
+	CLI_QUERY_LEN(0), "query write failed");
+    session = my_malloc(sizeof(struct child_session));
+    child_cli_read(rpair[1], EV_READ, session);
+    for (i = 0; i < 2; i++) {
+	rlen = read(rpair[0], &rbuf, sizeof(rbuf));
+	fail_unless(rlen == rec->len, "incorrect record length");
+	fail_unless(rec->index == ifindex, "incorrect record index");
+	fail_unless(rec->peer[PEER_HOSTNAME] != 0, "missing record hostname");
+	fail_unless(rec->frame == 0, "unwanted record frame");
+	fail_unless(rec->holdtime > 0, "missing record holdtime");
+    }
+    fail_unless(read(rpair[0], &rbuf, sizeof(rbuf)) == 0,
+	"session should be closed");
+    close(rpair[0]);
+
+    // the child filters on protocol, ifindex and fields
+    mark_point();
+    fail_if(socketpair(AF_UNIX, SOCK_SEQPACKET, 0, rpair) == -1,
+	"socketpair creation failed");
+    query.proto = (1 << PROTO_CDP);
+    query.fields = CLI_FIELD(PEER_HOSTNAME) | CLI_FIELD_FRAME;
+    query.count = 1;
+    query.index[0] = ifindex;
+    fail_unless(write(rpair[0], &query, CLI_QUERY_LEN(1)) ==
+	CLI_QUERY_LEN(1), "query write failed");
+    session = my_malloc(sizeof(struct child_session));
+    child_cli_read(rpair[1], EV_READ, session);
+    rlen = read(rpair[0], &rbuf, sizeof(rbuf));
+    fail_unless(rlen == rec->len, "incorrect record length");
+    fail_unless(rec->proto == PROTO_CDP, "incorrect record proto");
+    fail_unless(rec->peer[PEER_HOSTNAME] != 0, "missing record hostname");
+    fail_unless(rec->peer[PEER_PORTNAME] == 0, "unwanted record portname");
+    fail_unless(rec->frame && rec->frame_len, "missing record frame");
+    fail_unless(read(rpair[0], &rbuf, sizeof(rbuf)) == 0,
+	"session should be closed");
+    close(rpair[0]);
+
+    fail_if(socketpair(AF_UNIX, SOCK_SEQPACKET, 0, rpair) == -1,
+	"socketpair creation failed");
+    query.index[0] = ifindex + 1;
+    fail_unless(write(rpair[0], &query, CLI_QUERY_LEN(1)) ==
+	CLI_QUERY_LEN(1), "query write failed");
+    session = my_malloc(sizeof(struct child_session));
+    child_cli_read(rpair[1], EV_READ, session);
+    fail_unless(read(rpair[0], &rbuf, sizeof(rbuf)) == 0,
+	"no records should match");
+    close(rpair[0]);
+
+    // watch sessions get a snapshot followed by changes
+    mark_point();
+    fail_if(socketpair(AF_UNIX, SOCK_SEQPACKET, 0, rpair) == -1,
+	"socketpair creation failed");
+    query.proto = UINT8_MAX;
+    query.fields = CLI_FIELD(PEER_HOSTNAME);
+    query.flags = CLI_QUERY_WATCH;
+    query.count = 0;
+    fail_unless(write(rpair[0], &query, CLI_QUERY_LEN(0)) ==
+	CLI_QUERY_LEN(0), "query write failed");
+    session = my_malloc(sizeof(struct child_session));
+    child_cli_read(rpair[1], EV_READ, session);
+    for (i = 0; i < 2; i++) {
+	rlen = read(rpair[0], &rbuf, sizeof(rbuf));
+	fail_unless(rlen == rec->len, "incorrect record length");
+	fail_unless(rec->event == CLI_EVENT_NONE, "incorrect record event");
+    }
+    rlen = read(rpair[0], &rbuf, sizeof(rbuf));
+    fail_unless((rlen == PEER_RECORD_MIN) && (rec->event == CLI_EVENT_SYNC),
+	"missing sync marker");
+    fail_unless(TAILQ_FIRST(&watchers) == session, "session not watching");
+
+    // identical refreshes are not reported, new peers are
+    mark_point();
+    msg.proto = PROTO_LLDP;
+    read_packet(&msg, "proto/lldp/42.good.big");
+    WRAP_WRITE(spair[0], &msg, PARENT_MSG_LEN(msg.len));
+    child_queue(spair[1], 0);
+    fail_unless(session->ecount == 0, "refresh should not be reported");
+
+    memset(msg.msg + ETHER_ADDR_LEN, 'B', ETHER_ADDR_LEN);
+    WRAP_WRITE(spair[0], &msg, PARENT_MSG_LEN(msg.len));
+    child_queue(spair[1], 0);
+    fail_unless(session->ecount == 1, "new peer should be reported");
+    child_cli_write(rpair[1], EV_WRITE, session);
+    rlen = read(rpair[0], &rbuf, sizeof(rbuf));
+    fail_unless((rlen == rec->len) && (rec->event == CLI_EVENT_ADD),
+	"missing add event");
+    fail_unless(rec->peer[PEER_HOSTNAME] != 0, "missing record hostname");
+
+    // expired peers are reported without holdtime
+    mark_point();
+    dmsg = mqueue_lookup(&mqueue, &msg);
+    fail_unless(dmsg != NULL, "new peer not found");
+    dmsg->received -= dmsg->ttl * 2;
+    mqueue_update(&mqueue, dmsg);
+    child_expire();
+    child_cli_write(rpair[1], EV_WRITE, session);
+    rlen = read(rpair[0], &rbuf, sizeof(rbuf));
+    fail_unless((rlen == rec->len) && (rec->event == CLI_EVENT_REMOVE),
+	"missing remove event");
+    fail_unless(rec->holdtime == 0, "removed peer should have no holdtime");
+
+    // overflows drop the backlog and resend the snapshot
+    mark_point();
+    for (i = 0; i <= CHILD_EVENT_MAX; i++)
+	child_cli_notify(CLI_EVENT_CHANGE, TAILQ_FIRST(&mqueue));
+    fail_unless(session->overflow && (session->ecount == 0),
+	"backlog should be dropped");
+    fail_unless(TAILQ_FIRST(&mqueue)->refs == 2,
+	"dropped events should be released");
+    child_cli_write(rpair[1], EV_WRITE, session);
+    rlen = read(rpair[0], &rbuf, sizeof(rbuf));
+    fail_unless(rec->event == CLI_EVENT_OVERFLOW, "missing overflow marker");
+    for (i = 0; i < 2; i++) {
+	rlen = read(rpair[0], &rbuf, sizeof(rbuf));
+	fail_unless(rec->event == CLI_EVENT_NONE, "incorrect record event");
+    }
+    rlen = read(rpair[0], &rbuf, sizeof(rbuf));
+    fail_unless(rec->event == CLI_EVENT_SYNC, "missing sync marker");
+
+    // disconnecting ends the session
+    mark_point();
+    close(rpair[0]);
+    child_cli_close(rpair[1], EV_READ, session);
+    fail_unless(TAILQ_EMPTY(&watchers), "session still watching");
+
+    // watchers which don't keep up with their snapshot are dropped
+    mark_point();
+    fail_if(socketpair(AF_UNIX, SOCK_SEQPACKET, 0, rpair) == -1,
+	"socketpair creation failed");
+    fail_unless(write(rpair[0], &query, CLI_QUERY_LEN(0)) ==
+	CLI_QUERY_LEN(0), "query write failed");
+    session = my_malloc(sizeof(struct child_session));
+    child_cli_read(rpair[1], EV_READ, session);
+    fail_unless(TAILQ_FIRST(&watchers) == session, "session not watching");
+    for (i = 0; i <= CHILD_EVENT_MAX; i++)
+	child_cli_notify(CLI_EVENT_CHANGE, TAILQ_FIRST(&mqueue));
+    fail_unless(session->snap != NULL, "snapshot should be pending");
+    for (i = 0; i <= CHILD_EVENT_MAX; i++)
+	child_cli_notify(CLI_EVENT_CHANGE, TAILQ_FIRST(&mqueue));
+    fail_unless(TAILQ_EMPTY(&watchers), "slow session still watching");
+    fail_unless(TAILQ_FIRST(&mqueue)->refs == 1,
+	"slow sessions should release the queue");
+    while ((rlen = read(rpair[0], &rbuf, sizeof(rbuf))) > 0);
+    fail_unless(rlen == 0, "session should be closed");
+    close(rpair[0]);
+    query.flags = 0;
+
+    // stream sockets may deliver the query in pieces
+    mark_point();
+    fail_if(socketpair(AF_UNIX, SOCK_STREAM, 0, rpair) == -1,
+	"socketpair creation failed");
+    session = my_malloc(sizeof(struct child_session));
+    event_set(&session->event, rpair[1], EV_READ,
+	(void *)child_cli_read, session);
+    fail_unless(write(rpair[0], &query, 3) == 3, "query write failed");
+    child_cli_read(rpair[1], EV_READ, session);
+    fail_unless(session->qlen == 3, "partial query should be kept");
+    fail_unless(write(rpair[0], (uint8_t *)&query + 3,
+	CLI_QUERY_LEN(0) - 3) == CLI_QUERY_LEN(0) - 3, "query write failed");
+    event_loop(EVLOOP_ONCE);
+    for (total = 0; (rlen = read(rpair[0], &rbuf, sizeof(rbuf))) > 0;)
+	total += rlen;
+    fail_unless(rlen == 0, "session should be closed");
+    fail_unless(total >= 2 * PEER_RECORD_MIN, "records missing: %zd", total);
+    close(rpair[0]);
+
+    // invalid queries close the session
+    mark_point();
+    fail_if(socketpair(AF_UNIX, SOCK_SEQPACKET, 0, rpair) == -1,
+	"socketpair creation failed");
+    query.version = UINT8_MAX;
+    fail_unless(write(rpair[0], &query, CLI_QUERY_LEN(1)) ==
+	CLI_QUERY_LEN(1), "query write failed");
+    session = my_malloc(sizeof(struct child_session));
+    errstr = "invalid cli query";
+    WRAP_FATAL_START();
+    child_cli_read(rpair[1], EV_READ, session);
+    WRAP_FATAL_END();
+    fail_unless(strncmp(check_wrap_errstr, errstr, strlen(errstr)) == 0,
+	"incorrect message logged: %s", check_wrap_errstr);
+    fail_unless(read(rpair[0], &rbuf, sizeof(rbuf)) == 0,
+	"session should be closed");
+    close(rpair[0]);
+
     // test EAGAIN too
     mark_point();
     msg.proto = PROTO_LLDP;
@@ -470,6 +1004,305 @@ START_TEST(test_child_link) {
 }
 END_TEST
 
+#ifdef HAVE_NETIF_EVENTS
+static struct nlmsghdr *link_msg(char *buf, uint16_t type, uint32_t index,
+				 unsigned int flags, const char *name) {
+    struct nlmsghdr *nlh;
+    struct ifinfomsg *ifm;
+
+    memset(buf, 0, MNL_SOCKET_BUFFER_SIZE);
+    nlh = mnl_nlmsg_put_header(buf);
+    nlh->nlmsg_type = type;
+    ifm = mnl_nlmsg_put_extra_header(nlh, sizeof(struct ifinfomsg));
+    ifm->ifi_type = ARPHRD_ETHER;
+    ifm->ifi_index = index;
+    ifm->ifi_flags = flags;
+    if (name)
+	mnl_attr_put_strz(nlh, IFLA_IFNAME, name);
+    return(nlh);
+}
+
+static void link_info(struct nlmsghdr *nlh, uint16_t kind_type,
+		      const char *kind, uint16_t data_type,
+		      uint16_t attr, size_t len, const void *data) {
+    struct nlattr *info, *nest;
+
+    info = mnl_attr_nest_start(nlh, IFLA_LINKINFO);
+    mnl_attr_put_strz(nlh, kind_type, kind);
+    nest = mnl_attr_nest_start(nlh, data_type);
+    mnl_attr_put(nlh, attr, len, data);
+    mnl_attr_nest_end(nlh, nest);
+    mnl_attr_nest_end(nlh, info);
+}
+
+START_TEST(test_child_link_event) {
+    char buf[MNL_SOCKET_BUFFER_SIZE];
+    struct nlmsghdr *nlh;
+    struct ifaddrmsg *ifa;
+    struct parent_req *mreq;
+    struct netif *netif, *bond, *vlan, *nnetif;
+    uint8_t hwaddr[ETHER_ADDR_LEN] = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55 };
+    uint8_t mode = BOND_MODE_ACTIVEBACKUP, state;
+    uint16_t vid = 42;
+    uint32_t master = 9002, addr = htonl(0xc0000201);
+    unsigned int up = IFF_UP|IFF_RUNNING;
+    int spair[2], ret;
+    pid_t pid;
+
+    loglevel = INFO;
+    my_socketpair(spair);
+    msock = spair[0];
+    netif_init();
+    memset(&sysinfo, 0, sizeof(sysinfo));
+
+    // start a dummy replier
+    pid = fork();
+    if (pid == 0) {
+	close(spair[0]);
+	mreq = my_malloc(PARENT_REQ_MAX);
+	while (read(spair[1], mreq, PARENT_REQ_MAX) > 0) {
+	    mreq->len = (mreq->op == PARENT_DEVICE) ? 1 : 0;
+	    if (write(spair[1], mreq, PARENT_REQ_LEN(mreq->len)) == -1)
+		exit(1);
+	}
+	exit (0);
+    }
+    close(spair[1]);
+
+    // new ethernet interface
+    mark_point();
+    nlh = link_msg(buf, RTM_NEWLINK, 9001, up, "ladvd0");
+    mnl_attr_put(nlh, IFLA_ADDRESS, ETHER_ADDR_LEN, hwaddr);
+    ret = netif_event(nlh, &sysinfo, &netifs);
+    fail_unless (ret == (NETIF_EVENT_UPDATE|NETIF_EVENT_ADDRS),
+	"new interfaces should request addresses");
+    netif = netif_byname(&netifs, "ladvd0");
+    fail_unless (netif != NULL, "interface not added");
+    fail_unless (netif->type == NETIF_REGULAR, "incorrect interface type");
+    fail_unless (netif_byaddr(&netifs, hwaddr) == netif,
+	"interface not found by hwaddr");
+    fail_unless (sysinfo.physif_count == 1, "incorrect physif count");
+    fail_unless (netif_valid(0, NULL, &sysinfo, &netifs) == 1,
+	"incorrect netif count");
+
+#if HAVE_LINUX_ETHTOOL_H
+    // media details are cached until the carrier changes
+    mark_point();
+    netif_media(netif);
+    fail_unless (netif_facts(9001, "ladvd0")->valid & NETIF_FACT_MEDIA,
+	"media details not cached");
+    nlh = link_msg(buf, RTM_NEWLINK, 9001, up, "ladvd0");
+    netif_event(nlh, &sysinfo, &netifs);
+    fail_unless (netif_facts(9001, "ladvd0")->valid & NETIF_FACT_MEDIA,
+	"media details should be kept");
+    nlh = link_msg(buf, RTM_NEWLINK, 9001, up|IFF_LOWER_UP, "ladvd0");
+    netif_event(nlh, &sysinfo, &netifs);
+    fail_unless (!(netif_facts(9001, "ladvd0")->valid & NETIF_FACT_MEDIA),
+	"a carrier change should refresh the media details");
+#endif /* HAVE_LINUX_ETHTOOL_H */
+
+    // interfaces which are down or not ethernet are skipped,
+    // but ports which are down still count like netif_fetch does
+    mark_point();
+    nlh = link_msg(buf, RTM_NEWLINK, 9009, 0, "ladvd9");
+    fail_unless (netif_event(nlh, &sysinfo, &netifs) == NETIF_EVENT_UPDATE,
+	"disabled interfaces should update the sysinfo");
+    fail_unless (netif_byindex(&netifs, 9009) == NULL,
+	"disabled interfaces should be skipped");
+    fail_unless (sysinfo.physif_count == 2, "incorrect physif count");
+    nlh = link_msg(buf, RTM_NEWLINK, 9009, 0, "ladvd9");
+    fail_unless (netif_event(nlh, &sysinfo, &netifs) == 0,
+	"unchanged disabled interfaces should be skipped");
+    nlh = link_msg(buf, RTM_NEWLINK, 9009, up, "ladvd9");
+    ((struct ifinfomsg *)mnl_nlmsg_get_payload(nlh))->ifi_type = ARPHRD_LOOPBACK;
+    fail_unless (netif_event(nlh, &sysinfo, &netifs) == NETIF_EVENT_UPDATE,
+	"non-ethernet interfaces should update the sysinfo");
+    fail_unless (netif_byindex(&netifs, 9009) == NULL,
+	"non-ethernet interfaces should be skipped");
+    fail_unless (sysinfo.physif_count == 1, "incorrect physif count");
+
+    // failover bond
+    mark_point();
+    nlh = link_msg(buf, RTM_NEWLINK, 9002, up, "bond0");
+    link_info(nlh, IFLA_INFO_KIND, "bond", IFLA_INFO_DATA,
+	IFLA_BOND_MODE, sizeof(mode), &mode);
+    netif_event(nlh, &sysinfo, &netifs);
+    bond = netif_byindex(&netifs, 9002);
+    fail_unless (bond != NULL, "bond not added");
+    fail_unless (bond->type == NETIF_BONDING, "incorrect bond type");
+    fail_unless (bond->bonding_mode == NETIF_BONDING_FAILOVER,
+	"incorrect bonding mode");
+
+    // enslave a backup and an active subif
+    mark_point();
+    state = BOND_STATE_BACKUP;
+    nlh = link_msg(buf, RTM_NEWLINK, 9001, up, "ladvd0");
+    mnl_attr_put_u32(nlh, IFLA_MASTER, master);
+    link_info(nlh, IFLA_INFO_SLAVE_KIND, "bond", IFLA_INFO_SLAVE_DATA,
+	IFLA_BOND_SLAVE_STATE, sizeof(state), &state);
+    netif_event(nlh, &sysinfo, &netifs);
+    fail_unless (netif->parent == bond, "subif not enslaved");
+    fail_unless (bond->subif == netif, "subif not linked");
+    fail_unless (netif->child == NETIF_CHILD_BACKUP, "subif should be backup");
+
+    state = BOND_STATE_ACTIVE;
+    nlh = link_msg(buf, RTM_NEWLINK, 9003, up, "ladvd1");
+    mnl_attr_put_u32(nlh, IFLA_MASTER, master);
+    link_info(nlh, IFLA_INFO_SLAVE_KIND, "bond", IFLA_INFO_SLAVE_DATA,
+	IFLA_BOND_SLAVE_STATE, sizeof(state), &state);
+    netif_event(nlh, &sysinfo, &netifs);
+    nnetif = netif_byindex(&netifs, 9003);
+    fail_unless (nnetif->parent == bond, "subif not enslaved");
+    fail_unless (netif->subif == nnetif, "subif not linked");
+    fail_unless (nnetif->child == NETIF_CHILD_ACTIVE, "subif should be active");
+    fail_unless (nnetif->lacp_index == 1, "incorrect lacp index");
+
+    // vlan on top of the bond
+    mark_point();
+    nlh = link_msg(buf, RTM_NEWLINK, 9004, up, "bond0.42");
+    mnl_attr_put_u32(nlh, IFLA_LINK, master);
+    link_info(nlh, IFLA_INFO_KIND, "vlan", IFLA_INFO_DATA,
+	IFLA_VLAN_ID, sizeof(vid), &vid);
+    netif_event(nlh, &sysinfo, &netifs);
+    vlan = netif_byindex(&netifs, 9004);
+    fail_unless (vlan != NULL, "vlan not added");
+    fail_unless (vlan->type == NETIF_VLAN, "incorrect vlan type");
+    fail_unless (vlan->vlan_id == 42, "incorrect vlan id");
+    fail_unless (vlan->vlan_parent == 9002, "incorrect vlan parent");
+
+    // addresses
+    mark_point();
+    memset(buf, 0, sizeof(buf));
+    nlh = mnl_nlmsg_put_header(buf);
+    nlh->nlmsg_type = RTM_NEWADDR;
+    ifa = mnl_nlmsg_put_extra_header(nlh, sizeof(struct ifaddrmsg));
+    ifa->ifa_family = AF_INET;
+    ifa->ifa_index = 9004;
+    mnl_attr_put(nlh, IFA_LOCAL, sizeof(addr), &addr);
+    fail_unless (netif_event(nlh, &sysinfo, &netifs) == NETIF_EVENT_UPDATE,
+	"address not added");
+    fail_unless (vlan->ipaddr4 == addr, "incorrect address");
+    nlh->nlmsg_type = RTM_DELADDR;
+    fail_unless (netif_event(nlh, &sysinfo, &netifs) ==
+	(NETIF_EVENT_UPDATE|NETIF_EVENT_ADDRS), "address not removed");
+    fail_unless (vlan->ipaddr4 == 0, "address should be removed");
+
+    // rename and release from the bond
+    mark_point();
+    nlh = link_msg(buf, RTM_NEWLINK, 9001, up, "ladvd2");
+    netif_event(nlh, &sysinfo, &netifs);
+    fail_unless (netif_byname(&netifs, "ladvd0") == NULL,
+	"old name should be gone");
+    fail_unless (netif_byname(&netifs, "ladvd2") == netif,
+	"interface not renamed");
+    fail_unless (netif->parent == NULL, "subif not released");
+    fail_unless (bond->subif == nnetif, "subif list not updated");
+    fail_unless (nnetif->lacp_index == 0, "lacp index not updated");
+
+    // removed bond
+    mark_point();
+    nlh = link_msg(buf, RTM_DELLINK, 9002, 0, "bond0");
+    fail_unless (netif_event(nlh, &sysinfo, &netifs) == NETIF_EVENT_UPDATE,
+	"bond not removed");
+    fail_unless (netif_byindex(&netifs, 9002) == NULL, "bond not removed");
+    fail_unless (nnetif->parent == NULL, "subif not released");
+
+    // re-created bond adopts its subifs
+    mode = BOND_MODE_8023AD;
+    nlh = link_msg(buf, RTM_NEWLINK, 9002, up, "bond0");
+    link_info(nlh, IFLA_INFO_KIND, "bond", IFLA_INFO_DATA,
+	IFLA_BOND_MODE, sizeof(mode), &mode);
+    netif_event(nlh, &sysinfo, &netifs);
+    bond = netif_byindex(&netifs, 9002);
+    fail_unless (bond->bonding_mode == NETIF_BONDING_LACP,
+	"incorrect bonding mode");
+    fail_unless (nnetif->parent == bond, "subif not adopted");
+
+    // interface going down
+    mark_point();
+    nlh = link_msg(buf, RTM_NEWLINK, 9003, 0, "ladvd1");
+    netif_event(nlh, &sysinfo, &netifs);
+    fail_unless (netif_byindex(&netifs, 9003) == NULL,
+	"disabled interface not removed");
+    fail_unless (bond->subif == NULL, "subif list not updated");
+    fail_unless (netif_valid(0, NULL, &sysinfo, &netifs) == 3,
+	"incorrect netif count");
+
+    // reset
+    kill(pid, SIGTERM);
+    TAILQ_FOREACH_SAFE(netif, &netifs, entries, nnetif) {
+	netif_list_remove(&netifs, netif);
+	free(netif);
+    }
+    close(spair[0]);
+}
+END_TEST
+#endif /* HAVE_NETIF_EVENTS */
+
+START_TEST(test_child_state) {
+    extern int state_fd;
+    struct parent_msg msg, *dmsg;
+    struct netif netif;
+    char path[] = "/tmp/check_state.XXXXXX";
+    int spair[2];
+    time_t received;
+
+    loglevel = INFO;
+    my_socketpair(spair);
+    state_fd = mkstemp(path);
+    fail_if(state_fd == -1, "mkstemp failed: %s", strerror(errno));
+    unlink(path);
+
+    memset(&netif, 0, sizeof(struct netif));
+    netif.index = ifindex;
+    strlcpy(netif.name, ifname, IFNAMSIZ);
+    netif_list_insert(&netifs, &netif);
+
+    memset(&msg, 0, sizeof(struct parent_msg));
+    msg.index = ifindex;
+    msg.len = ETHER_MIN_LEN;
+    msg.proto = PROTO_LLDP;
+
+    // save a neighbor
+    mark_point();
+    read_packet(&msg, "proto/lldp/42.good.big");
+    WRAP_WRITE(spair[0], &msg, PARENT_MSG_LEN(msg.len));
+    child_queue(spair[1], 0);
+    dmsg = TAILQ_FIRST(&mqueue);
+    fail_unless(dmsg != NULL, "message not queued");
+    dmsg->received -= 5;
+    received = dmsg->received;
+    child_save(state_fd, 0, NULL);
+
+    mqueue_remove(&mqueue, dmsg);
+    mqueue_unref(dmsg);
+    fail_unless(TAILQ_EMPTY(&mqueue), "the queue should be empty");
+    fail_unless(netif.tx_fast == TX_FAST_INIT, "new peers should be fast");
+    netif.tx_fast = 0;
+
+    // and restore it with the original timestamp
+    mark_point();
+    child_load(state_fd);
+    dmsg = TAILQ_FIRST(&mqueue);
+    fail_unless(dmsg != NULL, "message not restored");
+    fail_unless(dmsg->received == received, "incorrect received timestamp");
+    fail_unless(dmsg->peer[PEER_HOSTNAME] != NULL, "message not decoded");
+    fail_unless(netif.tx_fast == 0, "restored peers should be quiet");
+    mqueue_remove(&mqueue, dmsg);
+    mqueue_unref(dmsg);
+
+    // renamed interfaces are skipped
+    mark_point();
+    strlcpy(netif.name, "renamed0", IFNAMSIZ);
+    child_load(state_fd);
+    fail_unless(TAILQ_EMPTY(&mqueue), "the queue should be empty");
+
+    netif_list_remove(&netifs, &netif);
+    close(state_fd);
+    state_fd = -1;
+}
+END_TEST
+
 START_TEST(test_child_free) {
     mark_point();
     child_free(0, 0, NULL);
@@ -479,8 +1312,8 @@ END_TEST
 Suite * child_suite (void) {
     Suite *s = suite_create("child.c");
 
-    TAILQ_INIT(&netifs);
-    TAILQ_INIT(&mqueue);
+    netif_list_init(&netifs);
+    mqueue_init(&mqueue);
     memset(&sysinfo, 0, sizeof(struct my_sysinfo));
     WRAP_FATAL_START();
     sysinfo_fetch(&sysinfo);
@@ -490,11 +1323,18 @@ Suite * child_suite (void) {
     // child test case
     TCase *tc_child = tcase_create("child");
     tcase_add_test(tc_child, test_child_init);
+    tcase_add_test(tc_child, test_child_wheel);
     tcase_add_test(tc_child, test_child_send);
+    tcase_add_test(tc_child, test_child_tx);
     tcase_add_test(tc_child, test_child_queue);
     tcase_add_test(tc_child, test_child_expire);
     tcase_add_test(tc_child, test_child_cli);
+    tcase_add_test(tc_child, test_child_state);
     tcase_add_test(tc_child, test_child_link);
+    tcase_add_test(tc_child, test_child_link_queue);
+#ifdef HAVE_NETIF_EVENTS
+    tcase_add_test(tc_child, test_child_link_event);
+#endif
     tcase_add_test(tc_child, test_child_free);
     suite_add_tcase(s, tc_child);
 
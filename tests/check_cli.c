@@ -43,6 +43,7 @@ START_TEST(test_cli_main) {
     char *argv[7], ifname[IFNAMSIZ];
     char buf[8192];
     struct parent_msg msg = {};
+    struct peer_record *rec, *rbuf = my_malloc(PEER_RECORD_MAX);
     int sobuf = PARENT_MSG_MAX * 10;
     time_t now;
 #if HAVE_EVHTTP_H
@@ -121,6 +122,24 @@ START_TEST(test_cli_main) {
     http_host = NULL;
     free(http_path);
     http_path = NULL;
+
+    // batch sizes need to be numeric
+    mark_point();
+    memset(buf, 0, sizeof(buf));
+    argv[5] = "-n10x";
+    optind = 1;
+    WRAP_FATAL_START();
+    cli_main(argc, argv);
+    WRAP_FATAL_END();
+    fflush(stderr);
+    fail_if(read(spair[5], buf, sizeof(buf)) < 0,
+	    "cli_main read failed");
+    fail_if(strstr(buf, "Usage:") == NULL,
+    	    "invalid usage output: %s", buf);
+    free(http_host);
+    http_host = NULL;
+    free(http_path);
+    http_path = NULL;
 #endif /* HAVE_EVHTTP_H */
 
     mark_point();
@@ -180,42 +199,49 @@ START_TEST(test_cli_main) {
     msg.proto = PROTO_LLDP;
     msg.index = 1;
     strlcpy(msg.name, ifname, IFNAMSIZ);
-    fail_if(write(spair[1], &msg, PARENT_MSG_MAX) < 0,
+    rec = peer_record_fields(&msg, CLI_FIELD_FRAME, rbuf);
+    fail_if(write(spair[1], rec, rec->len) < 0,
 	    "write failed");
 
     // invalid proto
     mark_point();
     read_packet(&msg, "proto/cdp/43.good.big");
     msg.proto = PROTO_MAX;
-    fail_if(write(spair[1], &msg, PARENT_MSG_MAX) < 0,
+    rec = peer_record_fields(&msg, CLI_FIELD_FRAME, rbuf);
+    fail_if(write(spair[1], rec, rec->len) < 0,
 	    "write failed");
 
     // invalid len
     mark_point();
     msg.proto = PROTO_CDP;
-    msg.len += ETHER_MAX_LEN;
-    fail_if(write(spair[1], &msg, PARENT_MSG_MAX) < 0,
+    rec = peer_record_fields(&msg, CLI_FIELD_FRAME, rbuf);
+    rec->frame_len += ETHER_MAX_LEN;
+    fail_if(write(spair[1], rec, rec->len) < 0,
 	    "write failed");
 
     // invalid ifindex
     mark_point();
-    msg.len -= ETHER_MAX_LEN;
     msg.index = 0;
-    fail_if(write(spair[1], &msg, PARENT_MSG_MAX) < 0,
+    peer_reset(&msg);
+    rec = peer_record_fields(&msg, CLI_FIELD_FRAME, rbuf);
+    fail_if(write(spair[1], rec, rec->len) < 0,
 	    "write failed");
 
     // unwanted proto
     mark_point();
     msg.index = 1;
     msg.proto = PROTO_NDP;
-    fail_if(write(spair[1], &msg, PARENT_MSG_MAX) < 0,
+    peer_reset(&msg);
+    rec = peer_record_fields(&msg, CLI_FIELD_FRAME, rbuf);
+    fail_if(write(spair[1], rec, rec->len) < 0,
 	    "write failed");
 
     // invalid packet
     mark_point();
     msg.proto = PROTO_LLDP;
     read_packet(&msg, "proto/lldp/A3.fuzzer.chassis_id.broken");
-    fail_if(write(spair[1], &msg, PARENT_MSG_MAX) < 0,
+    rec = peer_record_fields(&msg, CLI_FIELD_FRAME, rbuf);
+    fail_if(write(spair[1], rec, rec->len) < 0,
 	    "write failed");
 
     // old message
@@ -223,14 +249,17 @@ START_TEST(test_cli_main) {
     msg.proto = PROTO_LLDP;
     read_packet(&msg, "proto/lldp/45.good.vlan");
     msg.received = 0;
-    fail_if(write(spair[1], &msg, PARENT_MSG_MAX) < 0,
+    rec = peer_record_fields(&msg, CLI_FIELD_FRAME, rbuf);
+    fail_if(write(spair[1], rec, rec->len) < 0,
 	    "write failed");
 
     // valid
     mark_point();
     msg.received = now;
     strlcpy(msg.name, ifname, IFNAMSIZ);
-    fail_if(write(spair[1], &msg, PARENT_MSG_MAX) < 0,
+    peer_reset(&msg);
+    rec = peer_record_fields(&msg, CLI_FIELD_FRAME, rbuf);
+    fail_if(write(spair[1], rec, rec->len) < 0,
 	    "write failed");
 
     mark_point();
@@ -278,6 +307,92 @@ START_TEST(test_cli_main) {
     check_wrap_fail = 0;
     check_wrap_fake = 0;
     options = OPT_DAEMON | OPT_CHECK;
+    peer_free(&msg);
+    free(rbuf);
+}
+END_TEST
+
+START_TEST(test_cli_record) {
+    struct parent_msg msg = {}, rmsg = {};
+    struct peer_record *rec, *rrec, *frec;
+    int spair[2];
+
+    mark_point();
+    msg.index = 1;
+    msg.proto = PROTO_CDP;
+    msg.ttl = 180;
+    msg.received = time(NULL);
+    strlcpy(msg.name, "eth0", IFNAMSIZ);
+    msg.peer[PEER_HOSTNAME] = peer_strdup(&msg, "router");
+    msg.peer[PEER_PORTNAME] = peer_strdup(&msg, "Gi0/1");
+    rec = peer_record(&msg);
+    rec->holdtime = 42;
+    rrec = my_malloc(PEER_RECORD_MAX);
+
+    // records are framed by their length on stream sockets
+    mark_point();
+    fail_if(socketpair(AF_UNIX, SOCK_STREAM, 0, spair) == -1,
+	    "socketpair creation failed");
+    fail_if(write(spair[0], rec, rec->len) != rec->len, "write failed");
+    fail_if(write(spair[0], rec, rec->len) != rec->len, "write failed");
+    close(spair[0]);
+
+    fail_unless(cli_recv(spair[1], rrec, SOCK_STREAM) == rec->len,
+	"cli_recv failed");
+    fail_unless(cli_record(rrec, rrec->len, &rmsg) == 1, "cli_record failed");
+    fail_unless(rmsg.index == 1, "incorrect index");
+    fail_unless(rmsg.proto == PROTO_CDP, "incorrect proto");
+    fail_unless(rmsg.ttl == 180, "incorrect ttl");
+    fail_unless(rrec->holdtime == 42, "incorrect holdtime");
+    fail_unless(strcmp(rmsg.name, "eth0") == 0, "incorrect name");
+    fail_unless(strcmp(rmsg.peer[PEER_HOSTNAME], "router") == 0,
+	"incorrect hostname");
+    fail_unless(strcmp(rmsg.peer[PEER_PORTNAME], "Gi0/1") == 0,
+	"incorrect portname");
+    fail_unless(rmsg.peer[PEER_CAP] == NULL, "missing fields should be NULL");
+    fail_unless(cli_recv(spair[1], rrec, SOCK_STREAM) == rec->len,
+	"cli_recv failed");
+    fail_unless(cli_recv(spair[1], rrec, SOCK_STREAM) == 0,
+	"cli_recv should fail on eof");
+    close(spair[1]);
+
+    // partial records with the raw frame
+    mark_point();
+    msg.len = ETHER_MIN_LEN;
+    memset(msg.msg, 'A', msg.len);
+    frec = my_malloc(PEER_RECORD_MAX);
+    fail_unless(peer_record_fields(&msg, CLI_FIELDS_PEER, frec) == rec,
+	"the cached record should be used");
+    fail_unless(peer_record_fields(&msg,
+	CLI_FIELD(PEER_HOSTNAME) | CLI_FIELD_FRAME, frec) == frec,
+	"a partial record should be rendered");
+    fail_unless(cli_record(frec, frec->len, &rmsg) == 1, "cli_record failed");
+    fail_unless(rmsg.len == ETHER_MIN_LEN, "incorrect frame length");
+    fail_unless(memcmp(rmsg.msg, msg.msg, msg.len) == 0, "incorrect frame");
+    fail_unless(strcmp(rmsg.peer[PEER_HOSTNAME], "router") == 0,
+	"incorrect hostname");
+    fail_unless(rmsg.peer[PEER_PORTNAME] == NULL,
+	"unwanted fields should be NULL");
+    frec->frame_len = frec->len;
+    fail_unless(cli_record(frec, frec->len, &rmsg) == 0,
+	"invalid frame should fail");
+    free(frec);
+
+    // invalid records
+    mark_point();
+    memcpy(rrec, rec, rec->len);
+    fail_unless(cli_record(rrec, rec->len - 1, &rmsg) == 0,
+	"truncated record should fail");
+    rrec->peer[PEER_HOSTNAME] = rec->len;
+    fail_unless(cli_record(rrec, rec->len, &rmsg) == 0,
+	"invalid offset should fail");
+    memcpy(rrec, rec, rec->len);
+    ((char *)rrec)[rec->len - 1] = 'X';
+    fail_unless(cli_record(rrec, rec->len, &rmsg) == 0,
+	"unterminated record should fail");
+
+    free(rrec);
+    peer_free(&msg);
 }
 END_TEST
 
@@ -309,8 +424,8 @@ START_TEST(test_batch_write) {
     mark_point();
     strlcpy(msg.name, "eth0", IFNAMSIZ);
     msg.proto = PROTO_CDP;
-    msg.peer[PEER_HOSTNAME] = strdup("router");
-    msg.peer[PEER_PORTNAME] = strdup("Fas'tEthernet42/64");
+    msg.peer[PEER_HOSTNAME] = peer_strdup(&msg, "router");
+    msg.peer[PEER_PORTNAME] = peer_strdup(&msg, "Fas'tEthernet42/64");
     batch_write(&msg, 42);
     fflush(stdout);
     fail_if(read(spair[1], buf, sizeof(buf)) < 0,
@@ -325,7 +440,50 @@ START_TEST(test_batch_write) {
     close(spair[1]);
     dup2(ostdout, STDOUT_FILENO);
     close(ostdout);
-    peer_free(msg.peer);
+    peer_free(&msg);
+}
+END_TEST
+
+START_TEST(test_json_write) {
+    struct parent_msg msg = {};
+    int ostdout, spair[2];
+    char buf[8192];
+    int sobuf = 8192;
+    ssize_t len;
+
+    ostdout = dup(STDOUT_FILENO);
+    fail_if(ostdout == -1, "dup failed: %s", strerror(errno));
+    fail_if(socketpair(AF_UNIX, SOCK_STREAM, 0, spair) == -1,
+	    "socketpair creation failed: %s", strerror(errno));
+    setsockopt(spair[0], SOL_SOCKET, SO_SNDBUF, &sobuf, sizeof(sobuf));
+    setsockopt(spair[1], SOL_SOCKET, SO_RCVBUF, &sobuf, sizeof(sobuf));
+    dup2(spair[0], STDOUT_FILENO);
+
+    mark_point();
+    strlcpy(msg.name, "eth0", IFNAMSIZ);
+    msg.index = 2;
+    msg.proto = PROTO_CDP;
+    msg.ttl = 180;
+    msg.peer[PEER_HOSTNAME] = peer_strdup(&msg, "rou\"ter\\\x01");
+    msg.peer[PEER_PORTNAME] = peer_strdup(&msg, "FastEthernet42/64");
+    json_write(&msg, 42);
+    json_write(&msg, 41);
+    json_flush();
+    memset(buf, 0, sizeof(buf));
+    len = read(spair[1], buf, sizeof(buf) - 1);
+    fail_if(len < 0, "read failed");
+    fail_if(strstr(buf, "{\"interface\":\"eth0\",\"ifindex\":2,"
+	"\"protocol\":\"CDP\",\"hostname\":\"rou\\\"ter\\\\\\u0001\","
+	"\"portname\":\"FastEthernet42/64\",\"ttl\":180,\"holdtime\":42}\n")
+	!= buf, "invalid json_write output: %s", buf);
+    fail_if(strstr(buf, "\"holdtime\":41}\n") != buf + len - 15,
+	    "records should be newline delimited");
+
+    close(spair[0]);
+    close(spair[1]);
+    dup2(ostdout, STDOUT_FILENO);
+    close(ostdout);
+    peer_free(&msg);
 }
 END_TEST
 
@@ -356,8 +514,8 @@ START_TEST(test_cli) {
     mark_point();
     strlcpy(msg.name, "eth0", IFNAMSIZ);
     msg.proto = PROTO_CDP;
-    msg.peer[PEER_HOSTNAME] = strdup("router.local");
-    msg.peer[PEER_PORTNAME] = strdup("TenGigabitEthernet42/64");
+    msg.peer[PEER_HOSTNAME] = peer_strdup(&msg, "router.local");
+    msg.peer[PEER_PORTNAME] = peer_strdup(&msg, "TenGigabitEthernet42/64");
     cli_write(&msg, 42);
     fflush(stdout);
     fail_if(read(spair[1], buf, sizeof(buf)) < 0,
@@ -371,7 +529,7 @@ START_TEST(test_cli) {
     close(spair[1]);
     dup2(ostdout, STDOUT_FILENO);
     close(ostdout);
-    peer_free(msg.peer);
+    peer_free(&msg);
 }
 END_TEST
 
@@ -479,8 +637,8 @@ START_TEST(test_http) {
     strlcpy(msg.name, "eth0", IFNAMSIZ);
     msg.proto = PROTO_CDP;
     msg.decode = (1 << PEER_HOSTNAME)|(1 << PEER_PORTNAME);
-    msg.peer[PEER_HOSTNAME] = strdup("router");
-    msg.peer[PEER_PORTNAME] = strdup("Fas'tEthernet42/64");
+    msg.peer[PEER_HOSTNAME] = peer_strdup(&msg, "router");
+    msg.peer[PEER_PORTNAME] = peer_strdup(&msg, "Fas'tEthernet42/64");
     http_request(&msg, 0);
 
     mark_point();
@@ -544,7 +702,125 @@ START_TEST(test_http) {
 
     evhttp_free(httpd);
     event_base_free(base);
-    peer_free(msg.peer);
+    peer_free(&msg);
+}
+END_TEST
+
+// stand-in collector for the batched posts
+static int batch_requests = 0, batch_lines = 0, batch_gzip = 0;
+static int batch_fail = 0;
+
+static void batch_handler(struct evhttp_request *req, void *arg) {
+    const char *enc;
+    unsigned char *data = EVBUFFER_DATA(req->input_buffer);
+    size_t i, len = EVBUFFER_LENGTH(req->input_buffer);
+
+    batch_requests++;
+    if (batch_fail) {
+	batch_fail--;
+	evhttp_send_reply(req, 503, "Service Unavailable", NULL);
+	return;
+    }
+
+    enc = evhttp_find_header(req->input_headers, "Content-Encoding");
+    if (enc && (strcmp(enc, "gzip") == 0) && (len > 2) &&
+	(data[0] == 0x1f) && (data[1] == 0x8b))
+	batch_gzip++;
+    for (i = 0; i < len; i++)
+	batch_lines += (data[i] == '\n');
+    evhttp_send_reply(req, HTTP_OK, "OK", NULL);
+}
+
+START_TEST(test_http_batch) {
+    struct parent_msg msg = {};
+    extern char *http_host, *http_path, *hostname;
+    extern struct event_base *http_base;
+    extern int status;
+    extern short http_port;
+    extern uint32_t http_batch_max, http_retry_ms;
+    extern uint8_t http_gzip;
+    struct evhttp *httpd;
+    int sock = -1, i;
+
+    // check for ipv4 before running the test
+    mark_point();
+    if ((sock = socket(AF_INET, SOCK_STREAM, 0)) == -1)
+	return;
+    else
+	close(sock);
+
+    http_host = "127.0.0.1";
+    http_path = "/batch";
+    event_set_log_callback(&fake_log_cb);
+
+    mark_point();
+    http_base = event_init();
+    httpd = evhttp_new(http_base);
+    for (http_port = 8090; http_port < 8100; http_port++) {
+        if (evhttp_bind_socket(httpd, http_host, http_port) != -1)
+	    break;
+    }
+    fail_unless (http_port < 8100, "failed to start httpd on %s", http_host);
+    evhttp_set_gencb(httpd, batch_handler, NULL);
+
+    strlcpy(msg.name, "eth0", IFNAMSIZ);
+    msg.proto = PROTO_CDP;
+    msg.peer[PEER_HOSTNAME] = peer_strdup(&msg, "router");
+    msg.peer[PEER_PORTNAME] = peer_strdup(&msg, "FastEthernet42/64");
+
+    // batches are split and retried after a server error
+    mark_point();
+    status = EXIT_SUCCESS;
+    http_batch_max = 2;
+    http_retry_ms = 10;
+    batch_fail = 1;
+    http_batch_init();
+    for (i = 0; i < 5; i++)
+	http_batch_write(&msg, 42);
+    http_batch_dispatch();
+    fail_unless (batch_requests == 4,
+	"incorrect request count: %d != 4", batch_requests);
+    fail_unless (batch_lines == 5,
+	"incorrect record count: %d != 5", batch_lines);
+    fail_unless (status == EXIT_SUCCESS,
+	"incorrect exit status returned: %d", status);
+    free(hostname);
+
+#ifdef HAVE_LIBZ
+    // compressed batches
+    mark_point();
+    http_gzip = 1;
+    http_batch_init();
+    http_batch_write(&msg, 42);
+    http_batch_dispatch();
+    fail_unless (batch_gzip == 1, "batch should be compressed");
+    fail_unless (status == EXIT_SUCCESS,
+	"incorrect exit status returned: %d", status);
+    http_gzip = 0;
+    free(hostname);
+#endif /* HAVE_LIBZ */
+
+    // batches are dropped after the last retry, later ones are still sent
+    mark_point();
+    batch_requests = 0;
+    batch_lines = 0;
+    batch_fail = HTTP_RETRIES + 1;
+    http_batch_init();
+    for (i = 0; i < 3; i++)
+	http_batch_write(&msg, 42);
+    http_batch_dispatch();
+    fail_unless (batch_requests == HTTP_RETRIES + 2,
+	"incorrect request count: %d", batch_requests);
+    fail_unless (batch_lines == 1,
+	"incorrect record count: %d != 1", batch_lines);
+    fail_unless (status == EXIT_FAILURE,
+	"incorrect exit status returned: %d", status);
+    free(hostname);
+
+    evhttp_free(httpd);
+    event_base_free(http_base);
+    http_base = NULL;
+    peer_free(&msg);
 }
 END_TEST
 #endif /* HAVE_EVHTTP_H */
@@ -555,11 +831,14 @@ Suite * cli_suite (void) {
     // cli test case
     TCase *tc_cli = tcase_create("cli");
     tcase_add_test(tc_cli, test_cli_main);
+    tcase_add_test(tc_cli, test_cli_record);
     tcase_add_test(tc_cli, test_batch_write);
+    tcase_add_test(tc_cli, test_json_write);
     tcase_add_test(tc_cli, test_cli);
     tcase_add_test(tc_cli, test_debug);
 #if HAVE_EVHTTP_H
     tcase_add_test(tc_cli, test_http);
+    tcase_add_test(tc_cli, test_http_batch);
 #endif /* HAVE_EVHTTP_H */
     suite_add_tcase(s, tc_cli);
 
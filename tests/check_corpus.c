@@ -0,0 +1,77 @@
+/*
+ * $Id$
+ *
+ * Copyright (c) 2008, 2009, 2010
+ *      Sten Spans <sten@blinkenlights.nl>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "config.h"
+#include <dirent.h>
+#include <pcap.h>
+
+#include "common.h"
+#include "check_wrap.h"
+
+// hand every frame of the pcap files in a tests/proto directory to cb,
+// returns the number of frames or -1 when the corpus can't be read
+int read_corpus(const char *dir, corpus_cb cb, void *arg) {
+    const char *prefix;
+    char *path = NULL, errbuf[PCAP_ERRBUF_SIZE];
+    struct pcap_pkthdr p_pkthdr;
+    const u_char *data;
+    struct dirent *dirent;
+    pcap_t *p_handle;
+    DIR *dirp;
+    int count = 0;
+
+    if ((prefix = getenv("srcdir")) == NULL)
+	prefix = ".";
+
+    if (asprintf(&path, "%s/proto/%s", prefix, dir) == -1)
+	return(-1);
+    if ((dirp = opendir(path)) == NULL) {
+	fprintf(stderr, "failed to open %s\n", path);
+	free(path);
+	return(-1);
+    }
+    free(path);
+
+    while ((dirent = readdir(dirp)) != NULL) {
+	if (strstr(dirent->d_name, ".pcap") == NULL)
+	    continue;
+	if (asprintf(&path, "%s/proto/%s/%s",
+		prefix, dir, dirent->d_name) == -1)
+	    goto error;
+	if ((p_handle = pcap_open_offline(path, errbuf)) == NULL) {
+	    fprintf(stderr, "failed to open %s: %s\n", path, errbuf);
+	    free(path);
+	    goto error;
+	}
+	free(path);
+
+	while ((data = pcap_next(p_handle, &p_pkthdr)) != NULL) {
+	    cb(&p_pkthdr, data, arg);
+	    count++;
+	}
+	pcap_close(p_handle);
+    }
+    closedir(dirp);
+
+    return(count);
+
+error:
+    closedir(dirp);
+    return(-1);
+}
@@ -121,6 +121,14 @@ START_TEST(test_parent_signal) {
     fail_unless (strcmp(check_wrap_errstr, errstr) == 0,
 	"incorrect message logged: %s", check_wrap_errstr);
 
+    // forwarded to the child
+    mark_point();
+    check_wrap_fake |= FAKE_KILL;
+    parent_signal(sig, event, &pid);
+    fail_unless (strcmp(check_wrap_errstr, errstr) == 0,
+	"incorrect message logged: %s", check_wrap_errstr);
+    check_wrap_fake &= ~FAKE_KILL;
+
     mark_point();
     sig = 0;
     errstr = "unexpected signal";
@@ -136,7 +144,7 @@ START_TEST(test_parent_signal) {
 END_TEST
 
 START_TEST(test_parent_req) {
-    struct parent_req mreq = {};
+    struct parent_req mreq = {}, breq = {};
     struct ether_hdr ether = {};
     static uint8_t lldp_dst[] = LLDP_MULTICAST_ADDR;
     struct rawfd *rfd;
@@ -260,6 +268,40 @@ START_TEST(test_parent_req) {
 	"incorrect message logged: %s", check_wrap_errstr);
 #endif /* HAVE_SYSFS */
 
+    // test a batch of requests handled in one go
+    mark_point();
+    while (recv(spair[0], &breq, PARENT_REQ_MAX, MSG_DONTWAIT) > 0)
+	continue;
+    memset(&breq, 0, PARENT_REQ_MAX);
+    breq.op = PARENT_DEVICE;
+    for (uint32_t id = 1; id <= 3; id++) {
+	breq.id = id;
+	WRAP_WRITE(spair[0], &breq, PARENT_REQ_LEN(0));
+    }
+    parent_req(spair[1], event);
+    for (uint32_t id = 1; id <= 3; id++) {
+	fail_unless (recv(spair[0], &breq, PARENT_REQ_MAX, MSG_DONTWAIT) ==
+	    PARENT_REQ_LEN(0), "reply %u missing", id);
+	fail_unless (breq.id == id, "incorrect reply id %u", breq.id);
+    }
+
+#if HAVE_LINUX_ETHTOOL_H
+    // test link settings, returned in full or not at all
+    mark_point();
+    memset(&breq, 0, PARENT_REQ_MAX);
+    breq.op = PARENT_ETHTOOL_GLINK;
+    breq.index = ifindex;
+    strlcpy(breq.name, ifname, IFNAMSIZ);
+    breq.len = sizeof(struct parent_link_info);
+    WRAP_WRITE(spair[0], &breq, PARENT_REQ_LEN(breq.len));
+    parent_req(spair[1], event);
+    fail_unless (recv(spair[0], &breq, PARENT_REQ_MAX, MSG_DONTWAIT) > 0,
+	"link settings reply missing");
+    fail_unless ((breq.len == 0) ||
+	(breq.len == sizeof(struct parent_link_info)),
+	"incorrect link settings length %zd", breq.len);
+#endif /* HAVE_LINUX_ETHTOOL_H */
+
     // test a failing return message
     mark_point();
     parent_open(ifindex, ifname);
@@ -300,11 +342,11 @@ START_TEST(test_parent_check) {
 
 #ifdef HAVE_LINUX_ETHTOOL_H
     mark_point();
-    mreq.op = PARENT_ETHTOOL_GSET;
+    mreq.op = PARENT_ETHTOOL_GLINK;
     mreq.index = ifindex;
-    mreq.len = sizeof(struct ethtool_cmd);
+    mreq.len = sizeof(struct parent_link_info);
     fail_unless(parent_check(&mreq) == EXIT_SUCCESS,
-	"PARENT_ETHTOOL_GSET check failed");
+	"PARENT_ETHTOOL_GLINK check failed");
 
     mark_point();
     mreq.op = PARENT_ETHTOOL_GDRV;
@@ -325,7 +367,7 @@ START_TEST(test_parent_check) {
 
 #ifndef HAVE_LINUX_ETHTOOL_H
     mark_point();
-    mreq.op = PARENT_ETHTOOL_GSET;
+    mreq.op = PARENT_ETHTOOL_GLINK;
     fail_unless(parent_check(&mreq) == EXIT_FAILURE,
 	"parent_check should fail");
 #endif
@@ -334,10 +376,11 @@ END_TEST
 
 START_TEST(test_parent_send) {
     struct rawfd *rfd;
-    struct parent_msg msg = {};
+    struct parent_msg msg = {}, msgs[3];
     struct ether_hdr ether = {};
     static uint8_t lldp_dst[] = LLDP_MULTICAST_ADDR;
-    int spair[2];
+    uint8_t frame[ETHER_MAX_LEN];
+    int spair[2], fpair[2];
     const char *errstr;
     short event = 0;
 
@@ -381,7 +424,7 @@ START_TEST(test_parent_send) {
     memcpy(ether.dst, lldp_dst, ETHER_ADDR_LEN);
     ether.type = htons(ETHERTYPE_LLDP);
     memcpy(msg.msg, &ether, sizeof(ether));
-    errstr = "only -1 bytes written";
+    errstr = "failed to send LLDP frame on";
     close(rfd->fd);
     rfd->fd = -1;
     options &= ~OPT_DEBUG;
@@ -390,6 +433,31 @@ START_TEST(test_parent_send) {
     fail_unless (strncmp(check_wrap_errstr, errstr, strlen(errstr)) == 0,
 	"incorrect message logged: %s", check_wrap_errstr);
 
+    // a batch is sent per interface
+    mark_point();
+    my_socketpair(fpair);
+    rfd->fd = fpair[0];
+    for (int i = 0; i < 3; i++) {
+	msgs[i] = msg;
+	msgs[i].len = ETHER_MIN_LEN + i;
+    }
+    msgs[1].index = UINT32_MAX;
+    errstr = "invalid ifindex supplied";
+    fail_unless (my_msend(spair[0], msgs, 3) == 3, "message write failed");
+    parent_send(spair[1], event);
+    fail_unless (strncmp(check_wrap_errstr, errstr, strlen(errstr)) == 0,
+	"incorrect message logged: %s", check_wrap_errstr);
+    fail_unless (read(fpair[1], frame, sizeof(frame)) == msgs[0].len,
+	"incorrect frame sent");
+    fail_unless (read(fpair[1], frame, sizeof(frame)) == msgs[2].len,
+	"incorrect frame sent");
+    my_nonblock(fpair[1]);
+    fail_unless (read(fpair[1], frame, sizeof(frame)) == -1,
+	"no more frames should be sent");
+    close(fpair[0]);
+    close(fpair[1]);
+    rfd->fd = -1;
+
     options |= OPT_DEBUG;
 
     close(spair[0]);
@@ -430,6 +498,52 @@ START_TEST(test_parent_open_close) {
 }
 END_TEST
 
+START_TEST(test_parent_rfd_index) {
+    struct rfdhead rfds = {};
+    struct rawfd *rfd, *nrfd;
+    uint32_t count = RFD_HASH_MIN * 4;
+
+    TAILQ_INIT(&rfds);
+    fail_unless (rfd_byindex(&rfds, 1) == NULL, "empty list lookup failed");
+
+    // the index grows with the list
+    mark_point();
+    for (uint32_t i = 1; i <= count; i++) {
+	rfd = my_malloc(sizeof(struct rawfd));
+	rfd->index = i * 7;
+	rfd_insert(&rfds, rfd);
+    }
+    fail_unless (rfds.hsize >= count, "index should grow");
+    for (uint32_t i = 1; i <= count; i++) {
+	rfd = rfd_byindex(&rfds, i * 7);
+	fail_unless ((rfd != NULL) && (rfd->index == i * 7),
+	    "rfd %u not found", i * 7);
+    }
+    fail_unless (rfd_byindex(&rfds, 8) == NULL, "unknown rfd found");
+
+    // removed rawfds can't be found
+    mark_point();
+    TAILQ_FOREACH_SAFE(rfd, &rfds, entries, nrfd) {
+	if (rfd->index % 2)
+	    continue;
+	rfd_remove(&rfds, rfd);
+	free(rfd);
+    }
+    for (uint32_t i = 1; i <= count; i++) {
+	rfd = rfd_byindex(&rfds, i * 7);
+	fail_unless ((rfd != NULL) == (i % 2),
+	    "incorrect lookup for rfd %u", i * 7);
+    }
+
+    TAILQ_FOREACH_SAFE(rfd, &rfds, entries, nrfd) {
+	rfd_remove(&rfds, rfd);
+	free(rfd);
+    }
+    fail_unless (rfds.hcount == 0, "index should be empty");
+    free(rfds.hbuckets);
+}
+END_TEST
+
 START_TEST(test_parent_socket) {
     struct rawfd *rfd;
     const char *errstr;
@@ -464,6 +578,104 @@ START_TEST(test_parent_socket) {
 }
 END_TEST
 
+struct filter_arg {
+    struct bpf_insn *insns;
+    uint8_t *src;
+    int accepted;
+};
+
+static void filter_frame(const struct pcap_pkthdr *p_pkthdr,
+			 const u_char *data, void *arg) {
+    struct filter_arg *farg = arg;
+
+    if (bpf_filter(farg->insns, data, p_pkthdr->len, p_pkthdr->caplen) == 0)
+	return;
+    memcpy(farg->src, data + ETHER_ADDR_LEN, ETHER_ADDR_LEN);
+    farg->accepted++;
+}
+
+// run a filter over all frames in a tests/proto directory,
+// returns the number of accepted frames and the last accepted source
+static int filter_corpus(const char *dir, struct bpf_insn *insns,
+			 int *count, uint8_t *src) {
+    struct filter_arg farg = { .insns = insns, .src = src };
+
+    *count = read_corpus(dir, filter_frame, &farg);
+    fail_if (*count == -1, "failed to read the %s corpus", dir);
+
+    return(farg.accepted);
+}
+
+START_TEST(test_parent_filter) {
+    struct bpf_insn insns[FILTER_MAX];
+    const char *dirs[] = { "lldp", "cdp", "edp", "fdp", NULL };
+    const int dprotos[] = { PROTO_LLDP, PROTO_CDP, PROTO_EDP, PROTO_FDP };
+    int accepted[PROTO_MAX] = {}, count, len, d, p;
+    uint8_t src[ETHER_ADDR_LEN], enabled[PROTO_MAX];
+    uint8_t hwaddrs[FILTER_HWADDRS][ETHER_ADDR_LEN];
+
+    for (p = 0; p < PROTO_MAX; p++)
+	enabled[p] = protos[p].enabled;
+
+    // all protocols, the corpus frames of each are accepted
+    mark_point();
+    options |= OPT_AUTO;
+    len = parent_filter(insns, NULL, 0);
+    fail_unless (bpf_validate(insns, len), "invalid filter generated");
+    for (d = 0; dirs[d] != NULL; d++) {
+	accepted[d] = filter_corpus(dirs[d], insns, &count, src);
+	fail_unless (accepted[d] > 0, "no %s frames accepted", dirs[d]);
+	fail_unless (accepted[d] <= count, "invalid %s count", dirs[d]);
+    }
+    options &= ~OPT_AUTO;
+
+    // only the enabled protocols
+    mark_point();
+    for (p = 0; p < PROTO_MAX; p++)
+	protos[p].enabled = 0;
+    protos[PROTO_LLDP].enabled = 1;
+    len = parent_filter(insns, NULL, 0);
+    fail_unless (bpf_validate(insns, len), "invalid filter generated");
+    for (d = 0; dirs[d] != NULL; d++) {
+	fail_unless (filter_corpus(dirs[d], insns, &count, src) ==
+	    ((dprotos[d] == PROTO_LLDP) ? accepted[d] : 0),
+	    "incorrect number of %s frames accepted", dirs[d]);
+    }
+
+    // and frames from our own hwaddr are rejected
+    mark_point();
+    for (d = 0; dirs[d] != NULL; d++) {
+	protos[dprotos[d]].enabled = 1;
+	len = parent_filter(insns, NULL, 0);
+	fail_unless (filter_corpus(dirs[d], insns, &count, src) > 0,
+	    "no %s frames accepted", dirs[d]);
+	len = parent_filter(insns, src, 1);
+	fail_unless (bpf_validate(insns, len), "invalid filter generated");
+	fail_unless (filter_corpus(dirs[d], insns, &count, src) <
+	    accepted[d], "own %s frames accepted", dirs[d]);
+    }
+
+    // also with the hwaddrs of several interfaces, as used by the ring
+    mark_point();
+    memset(hwaddrs, 0, sizeof(hwaddrs));
+    for (d = 0; dirs[d] != NULL; d++) {
+	len = parent_filter(insns, NULL, 0);
+	filter_corpus(dirs[d], insns, &count, hwaddrs[d * 2 + 1]);
+    }
+    memcpy(hwaddrs[FILTER_HWADDRS - 1], hwaddrs[1], ETHER_ADDR_LEN);
+    len = parent_filter(insns, hwaddrs[0], FILTER_HWADDRS);
+    fail_unless (bpf_validate(insns, len), "invalid filter generated");
+    fail_unless (len <= FILTER_MAX, "filter too long");
+    for (d = 0; dirs[d] != NULL; d++) {
+	fail_unless (filter_corpus(dirs[d], insns, &count, src) <
+	    accepted[d], "own %s frames accepted", dirs[d]);
+    }
+
+    for (p = 0; p < PROTO_MAX; p++)
+	protos[p].enabled = enabled[p];
+}
+END_TEST
+
 START_TEST(test_parent_multi) {
     struct rawfd rfd;
     int spair[2];
@@ -615,6 +827,268 @@ START_TEST(test_parent_recv) {
 }
 END_TEST
 
+START_TEST(test_parent_recv_limit) {
+    struct rawfd rfd = { .name = "eth0" };
+    uint8_t frame[ETHER_ADDR_LEN] = LLDP_MULTICAST_ADDR;
+    uint64_t now = 1000;
+    const char *errstr = NULL;
+    int i, accepted = 0;
+
+    loglevel = INFO;
+
+    mark_point();
+    fail_unless (parent_recv_proto(frame) == PROTO_LLDP,
+	"LLDP frame not detected");
+
+    // new buckets accept a full burst
+    mark_point();
+    for (i = 0; i < PARENT_RECV_RATE * PARENT_RECV_BURST * 2; i++)
+	accepted += parent_recv_limit(&rfd, PROTO_LLDP, now);
+    fail_unless (accepted == PARENT_RECV_RATE * PARENT_RECV_BURST,
+	"%d frames accepted", accepted);
+    fail_unless (rfd.buckets[PROTO_LLDP].drops == accepted,
+	"%u frames dropped", rfd.buckets[PROTO_LLDP].drops);
+
+    // refilled at the configured rate, drops are reported afterwards
+    mark_point();
+    errstr = "dropped 20 LLDP frames on eth0";
+    my_log(CRIT, "test");
+    WRAP_FATAL_START();
+    fail_unless (parent_recv_limit(&rfd, PROTO_LLDP,
+		 now + 1000 / PARENT_RECV_RATE) == 1, "frame not accepted");
+    WRAP_FATAL_END();
+    fail_unless (strncmp(check_wrap_errstr, errstr, strlen(errstr)) == 0,
+	"incorrect message logged: %s", check_wrap_errstr);
+    fail_unless (parent_recv_limit(&rfd, PROTO_LLDP,
+		 now + 1000 / PARENT_RECV_RATE) == 0, "frame not dropped");
+
+    // protocols use separate buckets with their own rate
+    mark_point();
+    protos[PROTO_CDP].rate = 1;
+    errstr = "rate limiting CDP frames on eth0";
+    my_log(CRIT, "test");
+    WRAP_FATAL_START();
+    for (i = 0, accepted = 0; i < 10; i++)
+	accepted += parent_recv_limit(&rfd, PROTO_CDP, now);
+    WRAP_FATAL_END();
+    fail_unless (accepted == PARENT_RECV_BURST, "%d frames accepted", accepted);
+    fail_unless (strncmp(check_wrap_errstr, errstr, strlen(errstr)) == 0,
+	"incorrect message logged: %s", check_wrap_errstr);
+    fail_unless (parent_recv_limit(&rfd, PROTO_CDP, now + 1000) == 1,
+	"frame not accepted");
+    protos[PROTO_CDP].rate = 0;
+}
+END_TEST
+
+#ifdef HAVE_RXRING
+START_TEST(test_parent_ring) {
+    struct rxring ring = {};
+    struct parent_msg msg = {}, mrecv = {};
+    struct tpacket_block_desc *pbd;
+    struct tpacket3_hdr *hdr;
+    struct sockaddr_ll *sll;
+    const char *errstr = NULL;
+    size_t hlen, off;
+    uint16_t tag;
+    int spair[2];
+    short event = 0;
+
+    my_socketpair(spair);
+
+    options |= OPT_DEBUG;
+    loglevel = INFO;
+    dfd = STDOUT_FILENO;
+
+    mark_point();
+    parent_open(ifindex, ifname);
+    fail_unless (rfd_byindex(&rawfds, ifindex) != NULL,
+	"rfd should be added to the queue");
+
+    read_packet(&msg, "proto/cdp/43.good.big");
+
+    // a fake ring with two blocks
+    ring.bsize = 4096;
+    ring.bnum = 2;
+    ring.size = ring.bsize * ring.bnum;
+    ring.map = my_malloc(ring.size);
+
+    // the first block holds a frame for an unknown and a known ifindex
+    pbd = (struct tpacket_block_desc *)ring.map;
+    pbd->hdr.bh1.num_pkts = 2;
+    pbd->hdr.bh1.offset_to_first_pkt =
+	TPACKET_ALIGN(sizeof(struct tpacket_block_desc));
+    hlen = TPACKET_ALIGN(sizeof(struct tpacket3_hdr));
+    off = TPACKET_ALIGN(hlen + sizeof(struct sockaddr_ll));
+
+    hdr = (struct tpacket3_hdr *)
+	(ring.map + pbd->hdr.bh1.offset_to_first_pkt);
+    for (int i = 0; i < 2; i++) {
+	sll = (struct sockaddr_ll *)((uint8_t *)hdr + hlen);
+	sll->sll_ifindex = (i == 0) ? 0 : ifindex;
+	hdr->tp_mac = off;
+	hdr->tp_snaplen = msg.len;
+	memcpy((uint8_t *)hdr + off, msg.msg, msg.len);
+	hdr->tp_next_offset = TPACKET_ALIGN(off + msg.len);
+	hdr = (struct tpacket3_hdr *)((uint8_t *)hdr + hdr->tp_next_offset);
+    }
+
+    // the second block holds a vlan tagged frame
+    pbd = (struct tpacket_block_desc *)(ring.map + ring.bsize);
+    pbd->hdr.bh1.num_pkts = 1;
+    pbd->hdr.bh1.offset_to_first_pkt =
+	TPACKET_ALIGN(sizeof(struct tpacket_block_desc));
+    hdr = (struct tpacket3_hdr *)
+	((uint8_t *)pbd + pbd->hdr.bh1.offset_to_first_pkt);
+    sll = (struct sockaddr_ll *)((uint8_t *)hdr + hlen);
+    sll->sll_ifindex = ifindex;
+    hdr->tp_status = TP_STATUS_VLAN_VALID;
+    hdr->hv1.tp_vlan_tci = 42;
+    hdr->tp_mac = off;
+    hdr->tp_snaplen = msg.len;
+    memcpy((uint8_t *)hdr + off, msg.msg, msg.len);
+
+    // nothing handed to userspace yet
+    mark_point();
+    errstr = "test";
+    my_log(CRIT, errstr);
+    parent_ring_recv(-1, event, &ring);
+    fail_unless (strcmp(check_wrap_errstr, errstr) == 0,
+	"incorrect message logged: %s", check_wrap_errstr);
+    fail_unless (ring.block == 0, "ring should not advance");
+
+    // closed child socket
+    mark_point();
+    mfd = -1;
+    pbd = (struct tpacket_block_desc *)ring.map;
+    pbd->hdr.bh1.block_status = TP_STATUS_USER;
+    errstr = "failed to send message to child";
+    WRAP_FATAL_START();
+    parent_ring_recv(-1, event, &ring);
+    WRAP_FATAL_END();
+    fail_unless (strcmp(check_wrap_errstr, errstr) == 0,
+	"incorrect message logged: %s", check_wrap_errstr);
+    fail_unless (ring.block == 1, "ring should advance");
+    ring.block = 0;
+
+    // working
+    mark_point();
+    mfd = spair[0];
+    pbd->hdr.bh1.block_status = TP_STATUS_USER;
+    pbd = (struct tpacket_block_desc *)(ring.map + ring.bsize);
+    pbd->hdr.bh1.block_status = TP_STATUS_USER;
+    parent_ring_recv(-1, event, &ring);
+    errstr = "received CDP message (426 bytes)";
+    fail_unless (strcmp(check_wrap_errstr, errstr) == 0,
+	"incorrect message logged: %s", check_wrap_errstr);
+    fail_unless (ring.block == 0, "ring should wrap around");
+    fail_unless (pbd->hdr.bh1.block_status == TP_STATUS_KERNEL,
+	"block should be returned to the kernel");
+
+    // only the known ifindex is delivered
+    fail_unless (read(spair[1], &mrecv, PARENT_MSG_MAX) ==
+	PARENT_MSG_LEN(msg.len), "message read failed");
+    fail_unless (mrecv.index == ifindex, "incorrect ifindex");
+    fail_unless (memcmp(mrecv.msg, msg.msg, msg.len) == 0,
+	"incorrect message received");
+
+    // the vlan tag is restored
+    fail_unless (read(spair[1], &mrecv, PARENT_MSG_MAX) ==
+	PARENT_MSG_LEN(msg.len + ETHER_VLAN_ENCAP_LEN), "message read failed");
+    memcpy(&tag, mrecv.msg + ETHER_ADDR_LEN * 2, sizeof(tag));
+    fail_unless (ntohs(tag) == ETHERTYPE_VLAN, "vlan tag missing");
+    memcpy(&tag, mrecv.msg + ETHER_ADDR_LEN * 2 + sizeof(tag), sizeof(tag));
+    fail_unless (ntohs(tag) == 42, "incorrect vlan id");
+    fail_unless (memcmp(mrecv.msg + ETHER_ADDR_LEN * 2 + ETHER_VLAN_ENCAP_LEN,
+	msg.msg + ETHER_ADDR_LEN * 2, msg.len - ETHER_ADDR_LEN * 2) == 0,
+	"incorrect message received");
+
+    mark_point();
+    free(ring.map);
+    peer_free(&msg);
+    rfd_closeall(&rawfds);
+    close(spair[0]);
+    close(spair[1]);
+}
+END_TEST
+
+START_TEST(test_parent_ring_filter) {
+    struct rxring ring = { .dirty = 1 };
+    struct parent_req mreq = {};
+    struct rawfd *rfd, *nrfd;
+    const char *errstr;
+
+    loglevel = INFO;
+    ring.fd = my_socket(AF_INET, SOCK_DGRAM, 0);
+
+    // vlans sharing a hwaddr only take a single slot
+    mark_point();
+    for (int i = 0; i < FILTER_HWADDRS * 2; i++) {
+	rfd = my_malloc(sizeof(struct rawfd));
+	rfd->index = i + 1;
+	rfd->ring = &ring;
+	rfd->hwaddr[0] = 0x02;
+	rfd->hwaddr[5] = i % 2;
+	rfd_insert(&rawfds, rfd);
+    }
+    check_wrap_errstr[0] = '\0';
+    fail_unless (parent_ring_filter(&ring) == 0, "filter not attached");
+    fail_unless (ring.dirty == 0, "ring should be clean");
+    fail_unless (ring.overflow == 0, "ring should not overflow");
+    fail_unless (strlen(check_wrap_errstr) == 0,
+	"incorrect message logged: %s", check_wrap_errstr);
+
+    // distinct hwaddrs overflow, which is logged once
+    mark_point();
+    TAILQ_FOREACH(rfd, &rawfds, entries)
+	rfd->hwaddr[5] = rfd->index;
+    errstr = "more than";
+    fail_unless (parent_ring_filter(&ring) == 0, "filter not attached");
+    fail_unless (ring.overflow == 1, "ring should overflow");
+    fail_unless (strncmp(check_wrap_errstr, errstr, strlen(errstr)) == 0,
+	"incorrect message logged: %s", check_wrap_errstr);
+    check_wrap_errstr[0] = '\0';
+    fail_unless (parent_ring_filter(&ring) == 0, "filter not attached");
+    fail_unless (strlen(check_wrap_errstr) == 0,
+	"incorrect message logged: %s", check_wrap_errstr);
+
+    mark_point();
+    TAILQ_FOREACH_SAFE(rfd, &rawfds, entries, nrfd) {
+	rfd_remove(&rawfds, rfd);
+	free(rfd);
+    }
+
+    // an unchanged hwaddr doesn't trigger a refresh
+    mark_point();
+    options |= OPT_RECV;
+    options &= ~OPT_DEBUG;
+    rfd = my_malloc(sizeof(struct rawfd));
+    rfd->index = ifindex;
+    rfd->ring = &ring;
+    strlcpy(rfd->name, ifname, IFNAMSIZ);
+    memset(rfd->hwaddr, 0x02, ETHER_ADDR_LEN);
+    rfd_insert(&rawfds, rfd);
+
+    mreq.op = PARENT_OPEN;
+    mreq.index = ifindex;
+    mreq.len = ETHER_ADDR_LEN;
+    memcpy(mreq.buf, rfd->hwaddr, ETHER_ADDR_LEN);
+    parent_req_op(&mreq);
+    fail_unless (ring.dirty == 0, "ring should be clean");
+
+    // the hwaddr can't be read without the parent socket, so it's kept
+    memset(mreq.buf, 0, ETHER_ADDR_LEN);
+    parent_req_op(&mreq);
+    fail_unless (ring.dirty == 0, "ring should be clean");
+    fail_unless (rfd->hwaddr[0] == 0x02, "hwaddr should be kept");
+
+    rfd_remove(&rawfds, rfd);
+    free(rfd);
+    options &= ~OPT_RECV;
+    close(ring.fd);
+}
+END_TEST
+#endif /* HAVE_RXRING */
+
 Suite * parent_suite (void) {
     Suite *s = suite_create("parent.c");
 
@@ -628,9 +1102,16 @@ Suite * parent_suite (void) {
     tcase_add_test(tc_parent, test_parent_check);
     tcase_add_test(tc_parent, test_parent_send);
     tcase_add_test(tc_parent, test_parent_open_close);
+    tcase_add_test(tc_parent, test_parent_rfd_index);
     tcase_add_test(tc_parent, test_parent_socket);
     tcase_add_test(tc_parent, test_parent_multi);
+    tcase_add_test(tc_parent, test_parent_filter);
     tcase_add_test(tc_parent, test_parent_recv);
+    tcase_add_test(tc_parent, test_parent_recv_limit);
+#ifdef HAVE_RXRING
+    tcase_add_test(tc_parent, test_parent_ring);
+    tcase_add_test(tc_parent, test_parent_ring_filter);
+#endif /* HAVE_RXRING */
     suite_add_tcase(s, tc_parent);
 
     ifname = "lo";
@@ -104,11 +104,11 @@ START_TEST(test_proto_packet) {
     strlcpy(vlan2.name, "eth0.42", IFNAMSIZ);
 
 
-    TAILQ_INIT(&netifs);
-    TAILQ_INSERT_TAIL(&netifs, &netif, entries);
-    TAILQ_INSERT_TAIL(&netifs, &parent, entries);
-    TAILQ_INSERT_TAIL(&netifs, &vlan1, entries);
-    TAILQ_INSERT_TAIL(&netifs, &vlan2, entries);
+    netif_list_init(&netifs);
+    netif_list_insert(&netifs, &netif);
+    netif_list_insert(&netifs, &parent);
+    netif_list_insert(&netifs, &vlan1);
+    netif_list_insert(&netifs, &vlan2);
 
     mark_point();
     memset(msg.msg, 0, ETHER_MAX_LEN);
@@ -1060,7 +1060,7 @@ START_TEST(test_cdp_decode) {
     close(spair[0]);
     close(spair[1]);
     fd = dup(fd);
-    peer_free(msg.peer);
+    peer_free(&msg);
 }
 END_TEST
 
@@ -1138,7 +1138,7 @@ START_TEST(test_edp_decode) {
     fail_unless (msg.peer[PEER_PORTNAME] == NULL,
 	"port id should be empty, not '%s'", msg.peer[PEER_PORTNAME]);
 
-    peer_free(msg.peer);
+    peer_free(&msg);
 }
 END_TEST
 
@@ -1230,7 +1230,7 @@ START_TEST(test_fdp_decode) {
     fail_unless (strcmp(msg.peer[PEER_PORTNAME], "ethernet1/1") == 0,
 	"port id should be 'ethernet1/1' not '%s'", msg.peer[PEER_PORTNAME]);
 
-    peer_free(msg.peer);
+    peer_free(&msg);
 }
 END_TEST
 
@@ -83,55 +83,55 @@ START_TEST(test_value_str) {
     fail_unless (strncmp(check_wrap_errstr, errstr, strlen(errstr)) == 0,
 	"incorrect message logged: %s", check_wrap_errstr);
 
-    peer_free(msg.peer);
+    peer_free(&msg);
 }
 END_TEST
 
 START_TEST(test_str_addr) {
+    struct parent_msg msg = {};
     char *str = NULL;
     void *pos;
 
     mark_point();
     pos = "foob";
-    str = tlv_str_addr(PEER_ADDR_INET4, pos, 3);
+    str = tlv_str_addr(&msg, PEER_ADDR_INET4, pos, 3);
     fail_unless (str == NULL, "a NULL pointer should be returned");
 
-    str = tlv_str_addr(PEER_ADDR_INET4, pos, 5);
+    str = tlv_str_addr(&msg, PEER_ADDR_INET4, pos, 5);
     fail_unless (str == NULL, "a NULL pointer should be returned");
 
-    str = tlv_str_addr(PEER_ADDR_INET4, pos, 4);
+    str = tlv_str_addr(&msg, PEER_ADDR_INET4, pos, 4);
     fail_unless (str != NULL, "a string pointer should be returned");
-    free(str);
     str = NULL;
 
     mark_point();
     pos = "foobfoobfoobfoob";
-    str = tlv_str_addr(PEER_ADDR_INET6, pos, 3);
+    str = tlv_str_addr(&msg, PEER_ADDR_INET6, pos, 3);
     fail_unless (str == NULL, "a NULL pointer should be returned");
 
-    str = tlv_str_addr(PEER_ADDR_INET6, pos, 17);
+    str = tlv_str_addr(&msg, PEER_ADDR_INET6, pos, 17);
     fail_unless (str == NULL, "a NULL pointer should be returned");
 
-    str = tlv_str_addr(PEER_ADDR_INET6, pos, 16);
+    str = tlv_str_addr(&msg, PEER_ADDR_INET6, pos, 16);
     fail_unless (str != NULL, "a string pointer should be returned");
-    free(str);
     str = NULL;
 
     mark_point();
     pos = "foobfo";
-    str = tlv_str_addr(PEER_ADDR_802, pos, 5);
+    str = tlv_str_addr(&msg, PEER_ADDR_802, pos, 5);
     fail_unless (str == NULL, "a NULL pointer should be returned");
 
-    str = tlv_str_addr(PEER_ADDR_802, pos, 7);
+    str = tlv_str_addr(&msg, PEER_ADDR_802, pos, 7);
     fail_unless (str == NULL, "a NULL pointer should be returned");
 
-    str = tlv_str_addr(PEER_ADDR_802, pos, 6);
+    str = tlv_str_addr(&msg, PEER_ADDR_802, pos, 6);
     fail_unless (str != NULL, "a string pointer should be returned");
-    free(str);
     str = NULL;
 
-    str = tlv_str_addr(PEER_MAX, pos, 9);
+    str = tlv_str_addr(&msg, PEER_MAX, pos, 9);
     fail_unless (str == NULL, "a NULL pointer should be returned");
+
+    peer_free(&msg);
 }
 END_TEST
 
@@ -183,6 +183,142 @@ START_TEST(test_my_mreq) {
 }
 END_TEST
 
+START_TEST(test_my_mreq_queue) {
+    struct parent_req mreq = {}, *rreq;
+    int spair[2];
+    extern int msock;
+    extern uint32_t mreq_trips;
+    uint32_t id, trips;
+    pid_t pid;
+
+    loglevel = INFO;
+    my_socketpair(spair);
+    msock = spair[1];
+
+    // start a replier which returns the ifindex as the reply
+    pid = fork();
+    if (pid == 0) {
+	close(spair[1]);
+	rreq = my_malloc(PARENT_REQ_MAX);
+	while (read(spair[0], rreq, PARENT_REQ_MAX) > 0) {
+	    rreq->len = sizeof(rreq->index);
+	    memcpy(rreq->buf, &rreq->index, rreq->len);
+	    if (write(spair[0], rreq, PARENT_REQ_LEN(rreq->len)) == -1)
+		exit(1);
+	}
+	exit(0);
+    }
+    close(spair[0]);
+
+    // queued requests get an id but aren't sent
+    mark_point();
+    trips = mreq_trips;
+    mreq.op = PARENT_DEVICE;
+    for (uint32_t i = 1; i <= PARENT_REQ_QUEUE * 2; i++) {
+	mreq.index = i;
+	id = my_mreq_queue(&mreq);
+	fail_unless (id != 0, "queued requests need an id");
+    }
+    fail_unless (mreq_trips == trips, "requests should be queued");
+
+    // and sent in windows
+    mark_point();
+    fail_unless (my_mreq_flush() == PARENT_REQ_QUEUE * 2,
+	"incorrect number of replies");
+    fail_unless (mreq_trips - trips == PARENT_REQ_QUEUE * 2 / PARENT_REQ_BATCH,
+	"incorrect number of round trips: %u", mreq_trips - trips);
+
+    // the replies are picked up without a round trip
+    mark_point();
+    trips = mreq_trips;
+    for (uint32_t i = PARENT_REQ_QUEUE * 2; i > 0; i--) {
+	memset(&mreq, 0, PARENT_REQ_MAX);
+	mreq.op = PARENT_DEVICE;
+	mreq.index = i;
+	fail_unless (my_mreq(&mreq) == sizeof(mreq.index),
+	    "incorrect reply length");
+	fail_unless (memcmp(mreq.buf, &i, sizeof(i)) == 0,
+	    "reply doesn't match the request");
+    }
+    fail_unless (mreq_trips == trips, "replies should be cached");
+
+    // other requests still go to the parent, including the queue
+    mark_point();
+    mreq.op = PARENT_ALIAS;
+    mreq.index = 1;
+    my_mreq_queue(&mreq);
+    mreq.index = 2;
+    my_mreq(&mreq);
+    fail_unless (mreq_trips == trips + 1, "requests should be sent together");
+    fail_unless (memcmp(mreq.buf, &mreq.index, sizeof(mreq.index)) == 0,
+	"reply doesn't match the request");
+
+    // unused replies are dropped
+    mark_point();
+    my_mreq_drop();
+    mreq.index = 1;
+    my_mreq(&mreq);
+    fail_unless (mreq_trips == trips + 2, "dropped replies should be refetched");
+
+    kill(pid, SIGTERM);
+    close(spair[1]);
+}
+END_TEST
+
+START_TEST(test_my_msend) {
+    struct parent_msg msgs[PARENT_MSG_BATCH] = {}, rmsgs[PARENT_MSG_BATCH];
+    int spair[2], count;
+
+    my_socketpair(spair);
+
+    mark_point();
+    fail_unless (my_msend(-1, msgs, 1) == 0,
+	"nothing should be sent on an invalid fd");
+    fail_unless (my_mrecv(-1, rmsgs, 1) == 0,
+	"nothing should be received on an invalid fd");
+
+    mark_point();
+    for (int i = 0; i < 4; i++) {
+	msgs[i].index = i;
+	msgs[i].len = ETHER_MIN_LEN + i;
+	memset(msgs[i].msg, 'A' + i, msgs[i].len);
+    }
+    fail_unless (my_msend(spair[0], msgs, 4) == 4,
+	"all messages should be sent");
+
+    // an invalid message in between is skipped
+    WRAP_WRITE(spair[0], &msgs[0], ETHER_MIN_LEN);
+    fail_unless (my_msend(spair[0], &msgs[3], 1) == 1,
+	"all messages should be sent");
+
+    mark_point();
+    memset(rmsgs, 'X', sizeof(rmsgs));
+    count = 0;
+    while (count < 5) {
+	int ret = my_mrecv(spair[1], rmsgs + count, PARENT_MSG_BATCH - count);
+	fail_unless (ret > 0, "no messages received");
+	count += ret;
+    }
+    fail_unless (count == 5, "incorrect message count %d", count);
+    for (int i = 0; i < 5; i++) {
+	struct parent_msg *msg = &msgs[(i < 4) ? i : 3];
+	fail_unless (rmsgs[i].index == msg->index, "incorrect index");
+	fail_unless (rmsgs[i].len == msg->len, "incorrect length");
+	fail_unless (memcmp(rmsgs[i].msg, msg->msg, msg->len) == 0,
+	    "incorrect message");
+	fail_unless (rmsgs[i].msg[msg->len] == 0,
+	    "message remainder should be cleared");
+	fail_unless (rmsgs[i].peer[PEER_HOSTNAME] == NULL,
+	    "message peer should be cleared");
+    }
+    fail_unless (my_mrecv(spair[1], rmsgs, PARENT_MSG_BATCH) == 0,
+	"the socket should be drained");
+
+    close(spair[0]);
+    close(spair[1]);
+}
+END_TEST
+
 START_TEST(test_netif) {
     struct nhead nqueue;
     struct nhead *netifs = &nqueue;
@@ -196,8 +332,8 @@ START_TEST(test_netif) {
     ssize_t len;
     extern int msock;
 
-    TAILQ_INIT(&nqueue);
-    TAILQ_INIT(&mqueue);
+    netif_list_init(&nqueue);
+    mqueue_init(&mqueue);
     my_socketpair(spair);
 
     tnetifs[0].index = 0;
@@ -247,12 +383,12 @@ START_TEST(test_netif) {
     strlcpy(tnetifs[5].name, "eth1", IFNAMSIZ); 
     strlcpy(tnetifs[5].description, "eth1", IFDESCRSIZE); 
 
-    TAILQ_INSERT_TAIL(netifs, &tnetifs[0], entries);
-    TAILQ_INSERT_TAIL(netifs, &tnetifs[1], entries);
-    TAILQ_INSERT_TAIL(netifs, &tnetifs[2], entries);
-    TAILQ_INSERT_TAIL(netifs, &tnetifs[3], entries);
-    TAILQ_INSERT_TAIL(netifs, &tnetifs[4], entries);
-    TAILQ_INSERT_TAIL(netifs, &tnetifs[5], entries);
+    netif_list_insert(netifs, &tnetifs[0]);
+    netif_list_insert(netifs, &tnetifs[1]);
+    netif_list_insert(netifs, &tnetifs[2]);
+    netif_list_insert(netifs, &tnetifs[3]);
+    netif_list_insert(netifs, &tnetifs[4]);
+    netif_list_insert(netifs, &tnetifs[5]);
 
     // netif_iter checks
     mark_point();
@@ -343,51 +479,51 @@ START_TEST(test_netif) {
     msg->index = netif->index;
     msg->proto = PROTO_LLDP;
     memcpy(msg->msg + ETHER_ADDR_LEN, "\x02\x00\x01", 3);
-    msg->peer[PEER_HOSTNAME] = my_strdup("foo");
-    msg->peer[PEER_PORTNAME] = my_strdup("FastEthernet6/20");
-    TAILQ_INSERT_TAIL(&mqueue, msg, entries);
+    msg->peer[PEER_HOSTNAME] = peer_strdup(msg, "foo");
+    msg->peer[PEER_PORTNAME] = peer_strdup(msg, "FastEthernet6/20");
+    mqueue_insert(&mqueue, msg);
 
     msg = my_malloc(PARENT_MSG_SIZ);
     netif = netif_byname(netifs, "eth2");
     msg->index = netif->index;
     msg->proto = PROTO_CDP;
     memcpy(msg->msg + ETHER_ADDR_LEN, "\x02\x00\x02", 3);
-    msg->peer[PEER_HOSTNAME] = my_strdup("bar");
-    TAILQ_INSERT_TAIL(&mqueue, msg, entries);
+    msg->peer[PEER_HOSTNAME] = peer_strdup(msg, "bar");
+    mqueue_insert(&mqueue, msg);
 
     msg = my_malloc(PARENT_MSG_SIZ);
     netif = netif_byname(netifs, "eth1");
     msg->index = netif->index;
     msg->proto = PROTO_LLDP;
     memcpy(msg->msg + ETHER_ADDR_LEN, "\x02\x00\x03", 3);
-    msg->peer[PEER_HOSTNAME] = my_strdup("baz");
-    msg->peer[PEER_PORTNAME] = my_strdup("Ethernet4");
-    TAILQ_INSERT_TAIL(&mqueue, msg, entries);
+    msg->peer[PEER_HOSTNAME] = peer_strdup(msg, "baz");
+    msg->peer[PEER_PORTNAME] = peer_strdup(msg, "Ethernet4");
+    mqueue_insert(&mqueue, msg);
 
     msg = my_malloc(PARENT_MSG_SIZ);
     netif = netif_byname(netifs, "eth1");
     msg->index = netif->index;
     msg->proto = PROTO_LLDP;
     memcpy(msg->msg + ETHER_ADDR_LEN, "\x02\x00\x04", 3);
-    msg->peer[PEER_HOSTNAME] = my_strdup("quux");
-    msg->peer[PEER_PORTNAME] = my_strdup("Ethernet5");
-    TAILQ_INSERT_TAIL(&mqueue, msg, entries);
+    msg->peer[PEER_HOSTNAME] = peer_strdup(msg, "quux");
+    msg->peer[PEER_PORTNAME] = peer_strdup(msg, "Ethernet5");
+    mqueue_insert(&mqueue, msg);
 
     msg = my_malloc(PARENT_MSG_SIZ);
     netif = netif_byname(netifs, "eth1");
     msg->index = netif->index;
     msg->proto = PROTO_FDP;
     memcpy(msg->msg + ETHER_ADDR_LEN, "\x02\x00\x04", 3);
-    msg->peer[PEER_HOSTNAME] = my_strdup("quux");
-    msg->peer[PEER_PORTNAME] = my_strdup("Ethernet5");
-    TAILQ_INSERT_TAIL(&mqueue, msg, entries);
+    msg->peer[PEER_HOSTNAME] = peer_strdup(msg, "quux");
+    msg->peer[PEER_PORTNAME] = peer_strdup(msg, "Ethernet5");
+    mqueue_insert(&mqueue, msg);
 
     msg = my_malloc(PARENT_MSG_SIZ);
     netif = netif_byname(netifs, "lagg0");
     msg->index = netif->index;
     msg->proto = PROTO_LLDP;
     memcpy(msg->msg + ETHER_ADDR_LEN, "\x02\x00\x05", 3);
-    TAILQ_INSERT_TAIL(&mqueue, msg, entries);
+    mqueue_insert(&mqueue, msg);
 
     // netif_protos checks
     mark_point();
@@ -483,19 +619,541 @@ START_TEST(test_netif) {
 
     free(mreq);
     TAILQ_FOREACH_SAFE(msg, &mqueue, entries, nmsg) {
-	TAILQ_REMOVE(&mqueue, msg, entries);
-	peer_free(msg->peer);
+	mqueue_remove(&mqueue, msg);
+	peer_free(msg);
 	free(msg);
     }
+    fail_unless (mqueue.index->count == 0, "the index should be empty");
+    mqueue_free(&mqueue);
     TAILQ_FOREACH_SAFE(netif, &nqueue, entries, subif) {
-	TAILQ_REMOVE(&nqueue, netif, entries);
+	netif_list_remove(&nqueue, netif);
     }
+    netif_list_free(&nqueue);
 
     close(spair[0]);
     close(spair[1]);
 }
 END_TEST
 
+START_TEST(test_netif_hash) {
+    struct nhead nqueue;
+    struct netif *tnetifs, *netif;
+    char name[IFNAMSIZ];
+    uint8_t hwaddr[ETHER_ADDR_LEN] = {};
+    int count = NETIF_HASH_MIN * 4;
+
+    mark_point();
+    netif_list_init(&nqueue);
+    tnetifs = my_calloc(count, sizeof(struct netif));
+
+    // insert enough netifs to grow the index
+    for (int i = 0; i < count; i++) {
+	netif = &tnetifs[i];
+	netif->index = i + 1;
+	snprintf(netif->name, IFNAMSIZ, "eth%d", i);
+	netif->hwaddr[4] = i >> 8;
+	netif->hwaddr[5] = i & 0xff;
+	netif_list_insert(&nqueue, netif);
+    }
+    fail_unless (nqueue.hash != NULL, "the index should be created");
+    fail_unless (nqueue.hash->size >= (uint32_t)count,
+	"the index should grow");
+    fail_unless (nqueue.hash->count == (uint32_t)count,
+	"incorrect index count %u", nqueue.hash->count);
+
+    mark_point();
+    for (int i = 0; i < count; i++) {
+	snprintf(name, IFNAMSIZ, "eth%d", i);
+	hwaddr[4] = i >> 8;
+	hwaddr[5] = i & 0xff;
+	fail_unless (netif_byindex(&nqueue, i + 1) == &tnetifs[i],
+	    "netif %d not found by index", i);
+	fail_unless (netif_byname(&nqueue, name) == &tnetifs[i],
+	    "netif %d not found by name", i);
+	fail_unless (netif_byaddr(&nqueue, hwaddr) == &tnetifs[i],
+	    "netif %d not found by addr", i);
+    }
+    fail_unless (netif_byindex(&nqueue, count + 1) == NULL,
+	"unknown index should not be found");
+    fail_unless (netif_byname(&nqueue, "eth-1") == NULL,
+	"unknown name should not be found");
+
+    // the list order is untouched
+    mark_point();
+    fail_unless (TAILQ_FIRST(&nqueue) == &tnetifs[0],
+	"the first netif should be returned");
+    fail_unless (TAILQ_NEXT(&tnetifs[0], entries) == &tnetifs[1],
+	"the second netif should be returned");
+
+    // renamed netifs are found after a rehash
+    mark_point();
+    netif = &tnetifs[42];
+    strlcpy(netif->name, "renamed", IFNAMSIZ);
+    memset(netif->hwaddr, 0xaa, ETHER_ADDR_LEN);
+    netif_list_rehash(&nqueue, netif);
+    memset(hwaddr, 0xaa, ETHER_ADDR_LEN);
+    fail_unless (netif_byname(&nqueue, "renamed") == netif,
+	"renamed netif not found");
+    fail_unless (netif_byname(&nqueue, "eth42") == NULL,
+	"old name should not be found");
+    fail_unless (netif_byaddr(&nqueue, hwaddr) == netif,
+	"changed hwaddr not found");
+
+    // removed netifs are gone
+    mark_point();
+    netif_list_remove(&nqueue, netif);
+    fail_unless (netif_byindex(&nqueue, 43) == NULL,
+	"removed netif should not be found");
+    fail_unless (netif_byname(&nqueue, "renamed") == NULL,
+	"removed netif should not be found");
+    fail_unless (netif_byindex(&nqueue, 44) == &tnetifs[43],
+	"remaining netif not found");
+    fail_unless (nqueue.hash->count == (uint32_t)count - 1,
+	"incorrect index count %u", nqueue.hash->count);
+
+    netif_list_free(&nqueue);
+    fail_unless (netif_byindex(&nqueue, 44) == &tnetifs[43],
+	"netif not found without index");
+    free(tnetifs);
+}
+END_TEST
+
+START_TEST(test_netif_facts) {
+    struct netif_facts *nfacts, *cfacts;
+
+    mark_point();
+    nfacts = netif_facts(1001, "eth0");
+    fail_unless (nfacts->valid == 0, "new facts should be empty");
+    nfacts->valid = NETIF_FACT_DRIVER|NETIF_FACT_ALIAS;
+    strlcpy(nfacts->driver, "e1000e", sizeof(nfacts->driver));
+    strlcpy(nfacts->alias, "uplink", sizeof(nfacts->alias));
+    cfacts = netif_facts(1001 + NETIF_FACTS_HASH, "eth1");
+    cfacts->valid = NETIF_FACT_DEVICE;
+
+    // cached per ifindex
+    mark_point();
+    fail_unless (netif_facts(1001, "eth0") == nfacts, "facts not cached");
+    fail_unless (strcmp(nfacts->driver, "e1000e") == 0, "driver not cached");
+    fail_unless (netif_facts(1001 + NETIF_FACTS_HASH, "eth1") == cfacts,
+	"facts not cached");
+
+    // forget a single fact
+    mark_point();
+    netif_facts_forget(1001, NETIF_FACT_ALIAS);
+    fail_unless (nfacts->valid == NETIF_FACT_DRIVER, "alias not forgotten");
+    fail_unless (cfacts->valid == NETIF_FACT_DEVICE, "wrong facts forgotten");
+
+    // a reused ifindex gets new facts
+    mark_point();
+    nfacts = netif_facts(1001, "eth2");
+    fail_unless (nfacts->valid == 0, "facts should be reset");
+    fail_unless (strlen(nfacts->driver) == 0, "driver should be reset");
+    fail_unless (strcmp(nfacts->name, "eth2") == 0, "incorrect name");
+
+    // and everything
+    mark_point();
+    nfacts->valid = NETIF_FACT_DRIVER;
+    netif_facts_forget(NETIF_INDEX_MAX, NETIF_FACT_ALL);
+    nfacts = netif_facts(1001, "eth2");
+    fail_unless (nfacts->valid == 0, "facts should be forgotten");
+    netif_facts_forget(NETIF_INDEX_MAX, NETIF_FACT_ALL);
+}
+END_TEST
+
+START_TEST(test_netif_gen) {
+    struct netif netif = {}, parent = {};
+    uint32_t gen;
+
+    mark_point();
+    netif.index = 1;
+    netif.mtu = 1500;
+    gen = netif_gen(&netif);
+    fail_unless (gen != 0, "a generation should be handed out");
+    fail_unless (netif_gen(&netif) == gen, "unchanged netif got a new gen");
+
+    // volatile fields are ignored
+    mark_point();
+    netif.protos = 1;
+    netif.update = 1;
+    netif.tx_fast = 1;
+    fail_unless (netif_gen(&netif) == gen, "volatile fields should be ignored");
+
+    // but the builder inputs are not
+    mark_point();
+    netif.mtu = 9000;
+    fail_unless (netif_gen(&netif) > gen, "mtu change not detected");
+    gen = netif.gen;
+    netif.parent = &parent;
+    fail_unless (netif_gen(&netif) > gen, "parent change not detected");
+    gen = netif.gen;
+    strlcpy(netif.device_name, "NIC", sizeof(netif.device_name));
+    fail_unless (netif_gen(&netif) > gen, "device change not detected");
+
+    netif.frames[0] = my_malloc(sizeof(struct netif_frame));
+    netif_frames_free(&netif);
+    fail_unless (netif.gen_input == NULL, "inputs should be freed");
+    fail_unless (netif.frames[0] == NULL, "frames should be freed");
+}
+END_TEST
+
+START_TEST(test_peer_arena) {
+    struct parent_msg msg = {};
+    char *str, *big, long_str[PEER_ARENA_SIZE * 2];
+    struct peer_arena *arena;
+
+    mark_point();
+    str = peer_strdup(&msg, "foo");
+    fail_unless (strcmp(str, "foo") == 0, "peer_strdup failed");
+    fail_unless (msg.arena != NULL, "an arena should be allocated");
+    arena = msg.arena;
+    msg.peer[PEER_HOSTNAME] = str;
+
+    // a reset rewinds the arena but keeps the memory
+    mark_point();
+    peer_reset(&msg);
+    fail_unless (msg.peer[PEER_HOSTNAME] == NULL, "peers should be cleared");
+    fail_unless (msg.arena == arena, "arena should be kept");
+    fail_unless (peer_strdup(&msg, "bar") == str, "arena should be reused");
+
+    // oversized strings get their own block
+    mark_point();
+    memset(long_str, 'a', sizeof(long_str) - 1);
+    long_str[sizeof(long_str) - 1] = '\0';
+    big = peer_strdup(&msg, long_str);
+    fail_unless (strcmp(big, long_str) == 0, "peer_strdup failed");
+    fail_unless (strcmp(str, "bar") == 0, "earlier strings should be stable");
+    fail_unless (arena->next != NULL, "a second block should be chained");
+
+    // allocations are zeroed
+    str = peer_alloc(&msg, 16);
+    fail_unless (memcmp(str, "\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0", 16) == 0,
+	"peer_alloc should zero memory");
+
+    peer_free(&msg);
+    fail_unless (msg.arena == NULL, "arena should be freed");
+}
+END_TEST
+
+START_TEST(test_peer_record) {
+    struct parent_msg msg = {};
+    struct peer_record *rec;
+    char long_str[PEER_RECORD_MAX];
+
+    mark_point();
+    msg.index = 1;
+    msg.proto = PROTO_LLDP;
+    msg.ttl = 120;
+    strlcpy(msg.name, "eth0", IFNAMSIZ);
+    msg.peer[PEER_HOSTNAME] = peer_strdup(&msg, "router");
+    msg.peer[PEER_PORTNAME] = peer_strdup(&msg, "Gi0/1");
+
+    rec = peer_record(&msg);
+    fail_unless (((uintptr_t)rec % sizeof(time_t)) == 0,
+	"record should be aligned");
+    fail_unless (rec->len == PEER_RECORD_MIN + sizeof("router Gi0/1"),
+	"incorrect record length");
+    fail_unless (rec->index == 1, "incorrect index");
+    fail_unless (rec->ttl == 120, "incorrect ttl");
+    fail_unless (strcmp(rec->name, "eth0") == 0, "incorrect name");
+    fail_unless (strcmp((char *)rec + rec->peer[PEER_HOSTNAME], "router") == 0,
+	"incorrect hostname");
+    fail_unless (strcmp((char *)rec + rec->peer[PEER_PORTNAME], "Gi0/1") == 0,
+	"incorrect portname");
+    fail_unless (rec->peer[PEER_CAP] == 0, "missing fields should be 0");
+    fail_unless (peer_record(&msg) == rec, "record should be rendered once");
+
+    // a reset drops the record, oversized fields are left out
+    mark_point();
+    peer_reset(&msg);
+    fail_unless (msg.record == NULL, "record should be dropped");
+    memset(long_str, 'a', sizeof(long_str) - 1);
+    long_str[sizeof(long_str) - 1] = '\0';
+    msg.peer[PEER_HOSTNAME] = peer_strdup(&msg, "router");
+    msg.peer[PEER_PORTDESCR] = peer_strdup(&msg, long_str);
+    rec = peer_record(&msg);
+    fail_unless (rec->len <= PEER_RECORD_MAX, "record too long");
+    fail_unless (rec->peer[PEER_HOSTNAME] != 0, "hostname should fit");
+    fail_unless (rec->peer[PEER_PORTDESCR] == 0, "portdescr should not fit");
+
+    peer_free(&msg);
+    fail_unless (msg.record == NULL, "record should be freed");
+}
+END_TEST
+
+START_TEST(test_mqueue) {
+    struct mhead mqueue;
+    struct parent_msg *msgs, *msg, *nmsg, key;
+    struct mqueue_snap *snap, *nsnap;
+    int count = MQUEUE_HASH_MIN * 4, peers;
+    time_t now = 1000;
+
+    mark_point();
+    mqueue_init(&mqueue);
+    msgs = my_calloc(count, sizeof(struct parent_msg));
+
+    // unindexed lookups
+    msg = &msgs[0];
+    msg->index = 1;
+    msg->proto = 1;
+    TAILQ_INSERT_TAIL(&mqueue, msg, entries);
+    fail_unless (mqueue_lookup(&mqueue, msg) == msg,
+	"message not found without index");
+    fail_unless (mqueue_iter(NULL, &mqueue, 1) == msg,
+	"message not found without index");
+    fail_unless (mqueue_expired(&mqueue, now) == msg,
+	"message should be expired");
+    TAILQ_REMOVE(&mqueue, msg, entries);
+
+    // 4 interfaces with 2 protocols from 8 peers each
+    mark_point();
+    for (int i = 0; i < count; i++) {
+	msg = &msgs[i];
+	msg->index = (i % 4) + 1;
+	msg->proto = (i / 4) % 2;
+	msg->msg[ETHER_ADDR_LEN] = 0x02;
+	msg->msg[ETHER_ADDR_LEN + 5] = i / 8;
+	msg->received = now;
+	msg->ttl = 30 + (i * 7919) % 120;
+	mqueue_insert(&mqueue, msg);
+    }
+    fail_unless (mqueue.index->count == (uint32_t)count,
+	"incorrect index count %u", mqueue.index->count);
+    fail_unless (mqueue.index->size >= (uint32_t)count,
+	"the index should grow");
+
+    mark_point();
+    for (int i = 0; i < count; i++) {
+	memcpy(&key, &msgs[i], offsetof(struct parent_msg, entries));
+	fail_unless (mqueue_lookup(&mqueue, &key) == &msgs[i],
+	    "message %d not found", i);
+    }
+    key.proto = 3;
+    fail_unless (mqueue_lookup(&mqueue, &key) == NULL,
+	"unknown protocol should not be found");
+
+    // messages per interface are grouped by peer
+    mark_point();
+    for (uint32_t index = 1; index <= 4; index++) {
+	uint8_t paddr[ETHER_ADDR_LEN] = {};
+	peers = 0;
+	msg = NULL;
+	while ((msg = mqueue_iter(msg, &mqueue, index)) != NULL) {
+	    fail_unless (msg->index == index, "incorrect interface");
+	    if (memcmp(paddr, msg->msg + ETHER_ADDR_LEN, ETHER_ADDR_LEN) == 0)
+		continue;
+	    memcpy(paddr, msg->msg + ETHER_ADDR_LEN, ETHER_ADDR_LEN);
+	    peers++;
+	}
+	fail_unless (peers == count / 8,
+	    "incorrect peer count %d on interface %u", peers, index);
+    }
+    fail_unless (mqueue_iter(NULL, &mqueue, 5) == NULL,
+	"unknown interface should be empty");
+
+    // nothing is due yet
+    mark_point();
+    fail_unless (mqueue_expired(&mqueue, now) == NULL,
+	"no message should be expired");
+
+    // updates are reflected in the expiry order
+    msg = &msgs[42];
+    msg->ttl = 0;
+    mqueue_update(&mqueue, msg);
+    fail_unless (mqueue_expired(&mqueue, now + 1) == msg,
+	"updated message should expire first");
+
+    // unchanged queues share a snapshot
+    mark_point();
+    snap = mqueue_snapshot(&mqueue);
+    fail_unless (snap->count == (uint32_t)count,
+	"incorrect snapshot count %u", snap->count);
+    fail_unless (mqueue_snapshot(&mqueue) == snap,
+	"snapshot should be shared");
+    fail_unless ((snap->refs == 2) && (msg->refs == 2),
+	"incorrect snapshot references");
+    mqueue_snap_unref(&mqueue, snap);
+
+    // replaced messages are kept by the snapshot
+    mark_point();
+    nmsg = my_malloc(sizeof(struct parent_msg));
+    memcpy(nmsg, msg, offsetof(struct parent_msg, entries));
+    mqueue_replace(&mqueue, msg, nmsg);
+    fail_unless (mqueue_lookup(&mqueue, msg) == nmsg,
+	"replacement not found");
+    fail_unless (mqueue_expired(&mqueue, now + 1) == nmsg,
+	"replacement should expire first");
+    fail_unless ((msg->refs == 2) && (nmsg->refs == 1),
+	"incorrect message references");
+    peers = 0;
+    for (uint32_t i = 0; i < snap->count; i++)
+	peers += (snap->msgs[i] == msg);
+    fail_unless (peers == 1, "replaced message missing from the snapshot");
+
+    nsnap = mqueue_snapshot(&mqueue);
+    fail_unless (nsnap != snap, "changed queue should get a new snapshot");
+    fail_unless (nsnap->count == (uint32_t)count,
+	"incorrect snapshot count %u", nsnap->count);
+    for (uint32_t i = 0; i < nsnap->count; i++)
+	fail_unless (nsnap->msgs[i] != msg,
+	    "replaced message in the new snapshot");
+    mqueue_snap_unref(&mqueue, nsnap);
+
+    // the old queue reference is left for the caller to drop
+    mqueue_snap_unref(&mqueue, snap);
+    fail_unless (msg->refs == 1, "incorrect message references");
+    fail_unless (mqueue.snap == NULL, "snapshot should be released");
+
+    // expire in order
+    mark_point();
+    time_t last = 0;
+    peers = 0;
+    while ((msg = mqueue_expired(&mqueue, now + 90)) != NULL) {
+	fail_unless (msg->received + msg->ttl >= last,
+	    "messages expired out of order");
+	fail_unless (msg->received + msg->ttl < now + 90,
+	    "message expired too early");
+	last = msg->received + msg->ttl;
+	mqueue_remove(&mqueue, msg);
+	peers++;
+    }
+    fail_unless (peers > 0, "messages should be expired");
+    fail_unless (mqueue.index->count == (uint32_t)(count - peers),
+	"incorrect index count %u", mqueue.index->count);
+
+    TAILQ_FOREACH(msg, &mqueue, entries) {
+	fail_unless (msg->received + msg->ttl >= now + 90,
+	    "expired message should be removed");
+	fail_unless (mqueue_lookup(&mqueue, msg) == msg,
+	    "remaining message not found");
+    }
+
+    mark_point();
+    while ((msg = TAILQ_FIRST(&mqueue)) != NULL)
+	mqueue_remove(&mqueue, msg);
+    fail_unless (mqueue.index->icount == 0,
+	"interface lists should be released");
+    mqueue_free(&mqueue);
+    free(nmsg);
+    free(msgs);
+}
+END_TEST
+
+static struct parent_msg mqueue_loaded[4];
+static time_t mqueue_loaded_received[4];
+static int mqueue_loaded_count = 0;
+
+static void mqueue_load_cb(struct parent_msg *msg, time_t received) {
+    fail_unless(mqueue_loaded_count < 4, "too many messages loaded");
+    memcpy(&mqueue_loaded[mqueue_loaded_count], msg,
+	offsetof(struct parent_msg, peer));
+    mqueue_loaded_received[mqueue_loaded_count++] = received;
+}
+
+START_TEST(test_mqueue_file) {
+    struct mhead mqueue;
+    struct parent_msg msgs[3] = {};
+    struct mqueue_file hdrs[MQUEUE_FILE_SLOTS];
+    char path[] = "/tmp/check_mqueue.XXXXXX";
+    time_t now = 1000;
+    uint8_t byte;
+    off_t off;
+    int fd;
+
+    mark_point();
+    fd = mkstemp(path);
+    fail_if(fd == -1, "mkstemp failed: %s", strerror(errno));
+    unlink(path);
+
+    mqueue_init(&mqueue);
+    for (int i = 0; i < 3; i++) {
+	msgs[i].index = i + 1;
+	msgs[i].proto = i;
+	msgs[i].len = ETHER_MIN_LEN + i;
+	memset(msgs[i].msg, 'a' + i, msgs[i].len);
+	snprintf(msgs[i].name, IFNAMSIZ, "eth%d", i);
+	msgs[i].received = now - 60;
+	msgs[i].ttl = 120;
+	mqueue_insert(&mqueue, &msgs[i]);
+    }
+    // expired
+    msgs[2].ttl = 30;
+
+    // empty files are invalid
+    fail_unless(mqueue_load(fd, now, mqueue_load_cb) == -1,
+	"empty file should be invalid");
+
+    mark_point();
+    fail_unless(mqueue_save(&mqueue, fd, now) == 2,
+	"expired messages should not be saved");
+    fail_unless(mqueue_load(fd, now, mqueue_load_cb) == 2,
+	"incorrect number of messages loaded");
+    for (int i = 0; i < 2; i++) {
+	fail_unless(mqueue_loaded[i].index == msgs[i].index &&
+	    mqueue_loaded[i].proto == msgs[i].proto &&
+	    mqueue_loaded[i].ttl == msgs[i].ttl &&
+	    mqueue_loaded[i].len == msgs[i].len &&
+	    strcmp(mqueue_loaded[i].name, msgs[i].name) == 0 &&
+	    memcmp(mqueue_loaded[i].msg, msgs[i].msg, msgs[i].len) == 0,
+	    "message %d not restored", i);
+	fail_unless(mqueue_loaded_received[i] == msgs[i].received,
+	    "incorrect received timestamp");
+    }
+
+    // messages expire while the snapshot is stored
+    mark_point();
+    mqueue_loaded_count = 0;
+    fail_unless(mqueue_load(fd, now + 120, mqueue_load_cb) == 0,
+	"expired messages should not be loaded");
+
+    // the next save goes to the other slot, behind the current records
+    mark_point();
+    mqueue_remove(&mqueue, &msgs[1]);
+    fail_unless(mqueue_save(&mqueue, fd, now) == 1,
+	"incorrect number of messages saved");
+    mqueue_loaded_count = 0;
+    fail_unless(mqueue_load(fd, now, mqueue_load_cb) == 1,
+	"incorrect number of messages loaded");
+    fail_unless(pread(fd, hdrs, sizeof(hdrs), 0) == sizeof(hdrs),
+	"read failed");
+    fail_unless(hdrs[1].gen == hdrs[0].gen + 1, "incorrect slot used");
+    fail_unless(hdrs[1].offset == hdrs[0].offset + hdrs[0].size,
+	"previous records overwritten");
+
+    // corrupt records fail the checksum, the previous snapshot is used
+    mark_point();
+    off = hdrs[1].offset + 8;
+    fail_unless(pread(fd, &byte, 1, off) == 1, "read failed");
+    byte ^= 0xff;
+    fail_unless(pwrite(fd, &byte, 1, off) == 1, "write failed");
+    mqueue_loaded_count = 0;
+    fail_unless(mqueue_load(fd, now, mqueue_load_cb) == 2,
+	"previous snapshot should be loaded");
+
+    // and the next save replaces the corrupt slot
+    mark_point();
+    fail_unless(mqueue_save(&mqueue, fd, now) == 1,
+	"incorrect number of messages saved");
+    mqueue_loaded_count = 0;
+    fail_unless(mqueue_load(fd, now, mqueue_load_cb) == 1,
+	"incorrect number of messages loaded");
+
+    // without any valid slot the file is invalid
+    mark_point();
+    fail_unless(pread(fd, hdrs, sizeof(hdrs), 0) == sizeof(hdrs),
+	"read failed");
+    fail_unless(hdrs[0].gen == hdrs[1].gen + 1, "incorrect slot used");
+    off = hdrs[0].offset + 8;
+    fail_unless(pread(fd, &byte, 1, off) == 1, "read failed");
+    byte ^= 0xff;
+    fail_unless(pwrite(fd, &byte, 1, off) == 1, "write failed");
+    fail_unless(mqueue_load(fd, now, mqueue_load_cb) == -1,
+	"corrupt file should be invalid");
+
+    close(fd);
+    mqueue_free(&mqueue);
+}
+END_TEST
+
 START_TEST(test_read_line) {
     char line[128];
     const char *data = "0123456789ABCDEF";
@@ -566,6 +1224,97 @@ START_TEST(test_my_cksum) {
     sum = ntohs(my_chksum(data, strlen(data) - 1, cisco));
     fail_unless(sum ==  30250,
 	"(Cisco) IP checksum result should be 30250 not %d", sum);
+
+    fail_unless(my_crc32("123456789", 9) == 0xcbf43926,
+	"incorrect crc32 result");
+    fail_unless(my_crc32(data, 0) == 0, "incorrect crc32 result");
+
+    // every kernel should match the scalar one
+    uint8_t buf[70000];
+    uint16_t ref;
+    size_t off, len;
+
+    srandom(1);
+    for (size_t i = 0; i < sizeof(buf); i++)
+	buf[i] = random();
+    memset(buf + 1000, 0xff, 2000);
+
+    for (int r = 0; r < 200; r++) {
+	off = random() % 64;
+	len = (r < 100) ? r : random() % (sizeof(buf) - 64);
+	if (r == 199)
+	    len = sizeof(buf) - 64;
+	cisco = r % 2;
+
+	fail_unless(my_simd_select(MY_SIMD_SCALAR) == MY_SIMD_SCALAR,
+	    "the scalar kernel should always be available");
+	ref = my_chksum(buf + off, len, cisco);
+
+	for (int l = MY_SIMD_SSE2; l <= MY_SIMD_NEON; l++) {
+	    if (my_simd_select(l) == -1)
+		continue;
+	    sum = my_chksum(buf + off, len, cisco);
+	    fail_unless(sum == ref,
+		"checksum mismatch for level %d len %zu: %d != %d",
+		l, len, sum, ref);
+	}
+    }
+    fail_unless(my_simd_select(MY_SIMD_AUTO) != -1,
+	"auto selection should always succeed");
+    fail_unless(my_simd_select(42) == -1,
+	"unknown levels should be rejected");
+}
+END_TEST
+
+START_TEST(test_my_strnvis) {
+    int flags[] = { VIS_NL|VIS_TAB|VIS_GLOB|VIS_OCTAL, VIS_SAFE|VIS_OCTAL,
+		    VIS_SP|VIS_OCTAL };
+    char src[600], str[601], ref[601 * 4], vis[600 * 4 + 1];
+    size_t len, ret;
+
+    srandom(1);
+    for (int r = 0; r < 2000; r++) {
+	// single bytes, printable text with exceptions, random garbage
+	if (r < 256) {
+	    len = 3;
+	    memset(src, 'a', len);
+	    src[1] = r;
+	} else if (r < 1500) {
+	    len = random() % sizeof(src);
+	    for (size_t i = 0; i < len; i++)
+		src[i] = ' ' + random() % 95;
+	    for (int i = random() % 4; i > 0 && len; i--)
+		src[random() % len] = random();
+	} else {
+	    len = random() % sizeof(src);
+	    for (size_t i = 0; i < len; i++)
+		src[i] = random();
+	}
+	memcpy(str, src, len);
+	str[len] = '\0';
+
+	for (int f = 0; f < (sizeof(flags) / sizeof(flags[0])); f++) {
+	    strnvis(ref, str, sizeof(ref), flags[f]);
+
+	    for (int l = MY_SIMD_SCALAR; l <= MY_SIMD_NEON; l++) {
+		if (my_simd_select(l) == -1)
+		    continue;
+		memset(vis, 'x', sizeof(vis));
+		ret = my_strnvis(vis, src, len, flags[f]);
+		fail_unless(strcmp(vis, ref) == 0,
+		    "my_strnvis mismatch for level %d: '%s' != '%s'",
+		    l, vis, ref);
+		fail_unless(ret == strlen(ref), "incorrect length returned");
+	    }
+	}
+    }
+    my_simd_select(MY_SIMD_AUTO);
+
+    ret = my_strnvis(vis, "", 0, VIS_SAFE);
+    fail_unless(ret == 0 && *vis == '\0', "empty input should work");
+    ret = my_strnvis(vis, "a\\b\0c", 5, VIS_SAFE|VIS_OCTAL);
+    fail_unless(strcmp(vis, "a\\\\b") == 0,
+	"backslashes should be escaped and a NUL should end the string");
 }
 END_TEST
 
@@ -824,9 +1573,19 @@ Suite * util_suite (void) {
     TCase *tc_util = tcase_create("util");
     tcase_add_test(tc_util, test_my);
     tcase_add_test(tc_util, test_my_mreq);
+    tcase_add_test(tc_util, test_my_mreq_queue);
+    tcase_add_test(tc_util, test_my_msend);
     tcase_add_test(tc_util, test_netif);
+    tcase_add_test(tc_util, test_netif_hash);
+    tcase_add_test(tc_util, test_netif_facts);
+    tcase_add_test(tc_util, test_netif_gen);
+    tcase_add_test(tc_util, test_peer_arena);
+    tcase_add_test(tc_util, test_peer_record);
+    tcase_add_test(tc_util, test_mqueue);
+    tcase_add_test(tc_util, test_mqueue_file);
     tcase_add_test(tc_util, test_read_line);
     tcase_add_test(tc_util, test_my_cksum);
+    tcase_add_test(tc_util, test_my_strnvis);
     tcase_add_test(tc_util, test_my_priv);
     tcase_add_test(tc_util, test_portname_abbr);
     tcase_add_test(tc_util, test_pcap);
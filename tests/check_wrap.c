@@ -148,7 +148,7 @@ void read_packet(struct parent_msg *msg, const char *suffix) {
     memset(msg->msg, 0, ETHER_MAX_LEN);
     msg->len = 0;
     msg->ttl = 0;
-    peer_free(msg->peer);
+    peer_reset(msg);
 
     if ((prefix = getenv("srcdir")) == NULL)
 	prefix = ".";
@@ -68,3 +68,7 @@ extern char check_wrap_errstr[];
     fail_if(len != PARENT_REQ_LEN(mreq->len), "message read failed");
 
 void read_packet(struct parent_msg *msg, const char *suffix);
+
+struct pcap_pkthdr;
+typedef void (*corpus_cb)(const struct pcap_pkthdr *, const u_char *, void *);
+int read_corpus(const char *dir, corpus_cb cb, void *arg);